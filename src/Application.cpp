@@ -24,6 +24,7 @@
 #include <QtCore/QHashIterator>
 #include <QtCore/QFileInfo>
 #include <QtCore/QDir>
+#include <QtDBus/QDBusConnection>
 
 // KDE
 #include <KAction>
@@ -48,6 +49,10 @@ void Application::init()
 {
     _backgroundInstance = 0;
 
+    // requests from konsole-launch
+    QDBusConnection::sessionBus().registerObject("/Launcher", this,
+            QDBusConnection::ExportScriptableSlots);
+
 #if defined(Q_WS_MAC)
     // this ensures that Ctrl and Meta are not swapped, so CTRL-C and friends
     // will work correctly in the terminal
@@ -132,22 +137,7 @@ int Application::newInstance()
         if (args->isSet("background-mode")) {
             startBackgroundMode(window);
         } else {
-            // Qt constrains top-level windows which have not been manually
-            // resized (via QWidget::resize()) to a maximum of 2/3rds of the
-            //  screen size.
-            //
-            // This means that the terminal display might not get the width/
-            // height it asks for.  To work around this, the widget must be
-            // manually resized to its sizeHint().
-            //
-            // This problem only affects the first time the application is run.
-            // run. After that KMainWindow will have manually resized the
-            // window to its saved size at this point (so the Qt::WA_Resized
-            // attribute will be set)
-            if (!window->testAttribute(Qt::WA_Resized))
-                window->resize(window->sizeHint());
-
-            window->show();
+            showWindow(window);
         }
     }
 
@@ -156,6 +146,72 @@ int Application::newInstance()
     return 0;
 }
 
+int Application::openSession(const QString& profile, const QString& directory,
+                             const QStringList& command, bool newWindow)
+{
+    MainWindow* window = newWindow ? 0 : lastMainWindow();
+    if (!window)
+        window = newMainWindow();
+
+    Profile::Ptr baseProfile;
+    if (!profile.isEmpty())
+        baseProfile = ProfileManager::instance()->loadProfile(profile);
+    if (!baseProfile)
+        baseProfile = ProfileManager::instance()->defaultProfile();
+
+    Profile::Ptr newProfile = baseProfile;
+    if (!directory.isEmpty() || !command.isEmpty()) {
+        newProfile = Profile::Ptr(new Profile(baseProfile));
+        newProfile->setHidden(true);
+
+        if (!directory.isEmpty())
+            newProfile->setProperty(Profile::Directory, directory);
+
+        if (!command.isEmpty()) {
+            newProfile->setProperty(Profile::Command, command.first());
+            newProfile->setProperty(Profile::Arguments, command);
+        }
+    }
+
+    Session* session = window->createSession(newProfile, QString());
+    showWindow(window);
+
+    return session->sessionId();
+}
+
+MainWindow* Application::lastMainWindow() const
+{
+    QListIterator<QWidget*> iter(topLevelWidgets());
+    iter.toBack();
+    while (iter.hasPrevious()) {
+        MainWindow* window = qobject_cast<MainWindow*>(iter.previous());
+        if (window != 0)
+            return window;
+    }
+
+    return 0;
+}
+
+void Application::showWindow(MainWindow* window)
+{
+    // Qt constrains top-level windows which have not been manually
+    // resized (via QWidget::resize()) to a maximum of 2/3rds of the
+    //  screen size.
+    //
+    // This means that the terminal display might not get the width/
+    // height it asks for.  To work around this, the widget must be
+    // manually resized to its sizeHint().
+    //
+    // This problem only affects the first time the application is run.
+    // run. After that KMainWindow will have manually resized the
+    // window to its saved size at this point (so the Qt::WA_Resized
+    // attribute will be set)
+    if (!window->testAttribute(Qt::WA_Resized))
+        window->resize(window->sizeHint());
+
+    window->show();
+}
+
 /* Documentation for tab file:
  *
  * ;; is the token separator
@@ -284,15 +340,8 @@ void Application::createTabFromArgs(KCmdLineArgs* args, MainWindow* window,
 MainWindow* Application::processWindowArgs(KCmdLineArgs* args)
 {
     MainWindow* window = 0;
-    if (args->isSet("new-tab")) {
-        QListIterator<QWidget*> iter(topLevelWidgets());
-        iter.toBack();
-        while (iter.hasPrevious()) {
-            window = qobject_cast<MainWindow*>(iter.previous());
-            if (window != 0)
-                break;
-        }
-    }
+    if (args->isSet("new-tab"))
+        window = lastMainWindow();
 
     if (window == 0) {
         window = newMainWindow();
@@ -48,6 +48,7 @@ class Session;
 class Application : public KUniqueApplication
 {
     Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.kde.konsole.Launcher")
 
 public:
     /** Constructs a new Konsole application. */
@@ -65,6 +66,26 @@ public:
      */
     MainWindow* newMainWindow();
 
+public slots:
+    /**
+     * Opens a new session in a new tab of the most recently created window,
+     * or in a new window if @p newWindow is true or there is no window yet.
+     * This is called over D-Bus by the konsole-launch client, which avoids
+     * starting a whole Konsole process just to forward its arguments here.
+     *
+     * @param profile The name of the profile to use, or an empty string
+     * for the default profile.
+     * @param directory The initial working directory, or an empty string
+     * for the profile's directory.
+     * @param command The command to run followed by its arguments, or an
+     * empty list for the profile's command.
+     * @param newWindow Whether to open the session in a new window.
+     *
+     * Returns the id of the new session.
+     */
+    Q_SCRIPTABLE int openSession(const QString& profile, const QString& directory,
+                                 const QStringList& command, bool newWindow);
+
 private slots:
     void createWindow(Profile::Ptr profile , const QString& directory);
     void detachView(Session* session);
@@ -76,6 +97,8 @@ private:
     void listAvailableProfiles();
     void listProfilePropertyInfo();
     void startBackgroundMode(MainWindow* window);
+    MainWindow* lastMainWindow() const;
+    void showWindow(MainWindow* window);
     bool processHelpArgs(KCmdLineArgs* args);
     MainWindow* processWindowArgs(KCmdLineArgs* args);
     Profile::Ptr processProfileSelectArgs(KCmdLineArgs* args);
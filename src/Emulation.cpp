@@ -30,16 +30,37 @@
 #include "KeyboardTranslatorManager.h"
 #include "Screen.h"
 #include "ScreenWindow.h"
+#include "SessionUsage.h"
 
 using namespace Konsole;
 
+// output is inspected for binary data in samples of this many characters
+const int BINARY_OUTPUT_SAMPLE_SIZE = 4096;
+// a sample looks like binary data if at least this percentage of its
+// characters are decoding errors or unexpected control characters
+const int BINARY_OUTPUT_PERCENTAGE = 10;
+// output is discarded after this many samples in a row look like binary data
+const int BINARY_OUTPUT_SAMPLES = 4;
+
+// control characters which terminal programs commonly print: BEL, BS, HT,
+// LF, VT, FF, CR, SO, SI and ESC
+const quint32 EXPECTED_CONTROL_CHARACTERS = 0x0000ff80 | (1 << 27);
+
 Emulation::Emulation() :
     _currentScreen(0),
     _codec(0),
     _decoder(0),
     _keyTranslator(0),
+    _clipboardPayloadLimit(1024 * 1024),
     _usesMouse(false),
-    _imageSizeInitialized(false)
+    _outputGeneration(0),
+    _binaryOutputGuard(false),
+    _discardingOutput(false),
+    _inspectedCharacters(0),
+    _binaryCharacters(0),
+    _binarySamples(0),
+    _imageSizeInitialized(false),
+    _usage(0)
 {
     // create screens with a default size
     _screen[0] = new Screen(40, 80);
@@ -64,6 +85,80 @@ void Emulation::usesMouseChanged(bool usesMouse)
     _usesMouse = usesMouse;
 }
 
+void Emulation::setClipboardPayloadLimit(int bytes)
+{
+    _clipboardPayloadLimit = qMax(bytes, 0);
+}
+
+int Emulation::clipboardPayloadLimit() const
+{
+    return _clipboardPayloadLimit;
+}
+
+void Emulation::setBinaryOutputGuardEnabled(bool enabled)
+{
+    _binaryOutputGuard = enabled;
+
+    if (!enabled)
+        resumeOutput();
+}
+
+bool Emulation::binaryOutputGuardEnabled() const
+{
+    return _binaryOutputGuard;
+}
+
+bool Emulation::isDiscardingOutput() const
+{
+    return _discardingOutput;
+}
+
+void Emulation::setUsage(SessionUsage* usage)
+{
+    _usage = usage;
+}
+
+void Emulation::resumeOutput()
+{
+    _inspectedCharacters = 0;
+    _binaryCharacters = 0;
+    _binarySamples = 0;
+
+    if (!_discardingOutput)
+        return;
+
+    _discardingOutput = false;
+
+    // the output was discarded in the middle of a multi-byte sequence
+    delete _decoder;
+    _decoder = _codec->makeDecoder();
+
+    emit outputDiscardingChanged(false);
+}
+
+bool Emulation::detectBinaryOutput(ushort ch)
+{
+    if (ch < 0x20) {
+        if (!(EXPECTED_CONTROL_CHARACTERS & (1u << ch)))
+            _binaryCharacters++;
+    } else if ((ch >= 0x80 && ch < 0xa0) || ch == QChar::ReplacementCharacter) {
+        _binaryCharacters++;
+    }
+
+    if (++_inspectedCharacters < BINARY_OUTPUT_SAMPLE_SIZE)
+        return false;
+
+    if (_binaryCharacters * 100 >= _inspectedCharacters * BINARY_OUTPUT_PERCENTAGE)
+        _binarySamples++;
+    else
+        _binarySamples = 0;
+
+    _inspectedCharacters = 0;
+    _binaryCharacters = 0;
+
+    return _binarySamples >= BINARY_OUTPUT_SAMPLES;
+}
+
 ScreenWindow* Emulation::createWindow()
 {
     ScreenWindow* window = new ScreenWindow();
@@ -73,7 +168,7 @@ ScreenWindow* Emulation::createWindow()
     connect(window , SIGNAL(selectionChanged()),
             this , SLOT(bufferedUpdate()));
     connect(window, SIGNAL(selectionChanged()),
-            this, SLOT(checkSelectedText()));
+            this, SLOT(checkSelection()));
 
     connect(this , SIGNAL(outputChanged()),
             window , SLOT(notifyOutputChanged()));
@@ -86,10 +181,9 @@ void Emulation::checkScreenInUse()
     emit primaryScreenInUse(_currentScreen == _screen[0]);
 }
 
-void Emulation::checkSelectedText()
+void Emulation::checkSelection()
 {
-    QString text = _currentScreen->selectedText(true);
-    emit selectionChanged(text);
+    emit selectionChanged(_currentScreen->isSelectionValid());
 }
 
 Emulation::~Emulation()
@@ -114,17 +208,19 @@ void Emulation::setScreen(int index)
         }
 
         checkScreenInUse();
-        checkSelectedText();
+        checkSelection();
     }
 }
 
 void Emulation::clearHistory()
 {
     _screen[0]->setScroll(_screen[0]->getScroll() , false);
+    _outputGeneration++;
 }
 void Emulation::setHistory(const HistoryType& history)
 {
     _screen[0]->setScroll(history);
+    _outputGeneration++;
 
     showBulk();
 }
@@ -134,6 +230,11 @@ const HistoryType& Emulation::history() const
     return _screen[0]->getScroll();
 }
 
+quint32 Emulation::outputGeneration() const
+{
+    return _outputGeneration;
+}
+
 void Emulation::setCodec(const QTextCodec * codec)
 {
     if (codec) {
@@ -214,13 +315,27 @@ void Emulation::receiveData(const char* text, int length)
 {
     emit stateSet(NOTIFYACTIVITY);
 
+    if (_discardingOutput)
+        return;
+
+    _outputGeneration++;
+
     bufferedUpdate();
 
     QString unicodeText = _decoder->toUnicode(text, length);
 
     //send characters to terminal emulator
-    for (int i = 0; i < unicodeText.length(); i++)
-        receiveChar(unicodeText[i].unicode());
+    for (int i = 0; i < unicodeText.length(); i++) {
+        const ushort ch = unicodeText[i].unicode();
+
+        if (_binaryOutputGuard && detectBinaryOutput(ch)) {
+            _discardingOutput = true;
+            emit outputDiscardingChanged(true);
+            return;
+        }
+
+        receiveChar(ch);
+    }
 
     //look for z-modem indicator
     //-- someone who understands more about z-modems that I do may be able to move
@@ -288,6 +403,11 @@ void Emulation::writeToStream(TerminalCharacterDecoder* decoder ,
     _currentScreen->writeLinesToStream(decoder, startLine, endLine);
 }
 
+void Emulation::copyLines(LineBlock* block, int startLine, int endLine) const
+{
+    _currentScreen->copyLines(block, startLine, endLine);
+}
+
 int Emulation::lineCount() const
 {
     // sum number of lines currently on _screen plus number of lines in history
@@ -296,6 +416,10 @@ int Emulation::lineCount() const
 
 void Emulation::showBulk()
 {
+    SessionUsage::Scope scope(_usage);
+    if (_usage)
+        _usage->addFrame();
+
     _bulkTimer1.stop();
     _bulkTimer2.stop();
 
@@ -303,6 +427,12 @@ void Emulation::showBulk()
 
     _currentScreen->resetScrolledLines();
     _currentScreen->resetDroppedLines();
+
+    // compact the lines which scrolled into the history since the last update
+    _currentScreen->flushHistory();
+
+    if (_usage)
+        _usage->addSkippedHistoryLines(_currentScreen->takeSkippedHistoryLines());
 }
 
 void Emulation::bufferedUpdate()
@@ -345,6 +475,7 @@ void Emulation::setImageSize(int lines, int columns)
     } else {
         _screen[0]->resizeImage(lines, columns);
         _screen[1]->resizeImage(lines, columns);
+        _outputGeneration++;
 
         emit imageSizeChanged(lines, columns);
 
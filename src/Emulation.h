@@ -39,7 +39,9 @@ class KeyboardTranslator;
 class HistoryType;
 class Screen;
 class ScreenWindow;
+class SessionUsage;
 class TerminalCharacterDecoder;
+class LineBlock;
 
 /**
  * This enum describes the available states which
@@ -152,6 +154,15 @@ public:
     /** Clears the history scroll. */
     void clearHistory();
 
+    /**
+     * Returns a number which changes whenever output is received, the
+     * history is cleared or replaced, or the screen is resized.  Code which
+     * keeps information about the position of text in the output, such as
+     * the lines matching a search, can compare it with the value at the
+     * time the information was gathered to find out whether it is stale.
+     */
+    quint32 outputGeneration() const;
+
     /**
      * Copies the output history from @p startLine to @p endLine
      * into @p stream, using @p decoder to convert the terminal
@@ -165,6 +176,13 @@ public:
      */
     virtual void writeToStream(TerminalCharacterDecoder* decoder, int startLine, int endLine);
 
+    /**
+     * Appends a copy of the output history from @p startLine to @p endLine
+     * to @p block.  Unlike the emulation, the copy can be decoded on other
+     * threads with ParallelLineDecoder.
+     */
+    void copyLines(LineBlock* block, int startLine, int endLine) const;
+
     /** Returns the codec used to decode incoming characters.  See setCodec() */
     const QTextCodec* codec() const {
         return _codec;
@@ -215,6 +233,43 @@ public:
      */
     bool programUsesMouse() const;
 
+    /**
+     * Sets the maximum size in bytes of text which the terminal program
+     * may place on the clipboard using the OSC 52 escape sequence.
+     * Larger requests are discarded.  A limit of 0 disables remote
+     * clipboard access.
+     *
+     * The clipboardChangeRequest() signal is emitted for accepted requests.
+     */
+    void setClipboardPayloadLimit(int bytes);
+    /** Returns the limit set with setClipboardPayloadLimit() */
+    int clipboardPayloadLimit() const;
+
+    /**
+     * Specifies whether output which looks like binary data is discarded.
+     *
+     * When enabled, receiveData() watches for output with a high proportion
+     * of decoding errors, NULs and other control characters which terminal
+     * programs do not print, as when a binary file is written to the
+     * terminal.  Once this has been seen for several thousand characters in
+     * a row, further output is discarded without being decoded until
+     * resumeOutput() is called.
+     *
+     * The outputDiscardingChanged() signal is emitted when output starts
+     * or stops being discarded.
+     */
+    void setBinaryOutputGuardEnabled(bool enabled);
+    /** Returns true if binary output is discarded.  See setBinaryOutputGuardEnabled() */
+    bool binaryOutputGuardEnabled() const;
+    /** Returns true if output is currently being discarded. */
+    bool isDiscardingOutput() const;
+
+    /**
+     * Sets the usage which the time spent sending updated images to the
+     * views, and the number of updates, are recorded in.  May be null.
+     */
+    void setUsage(SessionUsage* usage);
+
 public slots:
 
     /** Change the size of the emulation's image */
@@ -261,6 +316,12 @@ public slots:
      */
     void receiveData(const char* buffer, int len);
 
+    /**
+     * Resumes processing of output after output which looks like binary
+     * data was detected.  See setBinaryOutputGuardEnabled()
+     */
+    void resumeOutput();
+
 signals:
 
     /**
@@ -294,6 +355,15 @@ signals:
      */
     void zmodemDetected();
 
+    /**
+     * Emitted when output which looks like binary data has been detected
+     * and further output is discarded, or when output is processed again
+     * after resumeOutput() was called.
+     *
+     * @param discarding True if output is being discarded
+     */
+    void outputDiscardingChanged(bool discarding);
+
 
     /**
      * Requests that the color of the text used
@@ -362,6 +432,17 @@ signals:
 
     void titleChanged(int title, const QString& newTitle);
 
+    /**
+     * Emitted when the program running in the terminal wishes to place
+     * text on the clipboard, using the escape sequence
+     * "\033]52;TARGETS;BASE64-DATA\007".
+     *
+     * @param targets The xterm selection targets, 'c' for the clipboard,
+     * 'p' or 's' for the X11 selection.  May be empty.
+     * @param text The decoded text
+     */
+    void clipboardChangeRequest(const QString& targets, const QString& text);
+
     /**
      * Emitted when the terminal emulator's size has changed
      */
@@ -406,9 +487,14 @@ signals:
     void primaryScreenInUse(bool use);
 
     /**
-     * Emitted when the text selection is changed
+     * Emitted when the text selection is changed.  The selected text is
+     * not included because building it for a large selection is expensive
+     * and the selection changes with every mouse move while it is dragged.
+     * Use ScreenWindow::selectedText() to get the text when it is needed.
+     *
+     * @param hasSelection True if any text is selected
      */
-    void selectionChanged(const QString& text);
+    void selectionChanged(bool hasSelection);
 
 protected:
     virtual void setMode(int mode) = 0;
@@ -453,6 +539,8 @@ protected:
     QTextDecoder* _decoder;
     const KeyboardTranslator* _keyTranslator; // the keyboard layout
 
+    int _clipboardPayloadLimit;
+
 protected slots:
     /**
      * Schedules an update of attached views.
@@ -464,8 +552,8 @@ protected slots:
     // used to emit the primaryScreenInUse(bool) signal
     void checkScreenInUse();
 
-    // used to emit the selectionChanged(QString) signal
-    void checkSelectedText();
+    // used to emit the selectionChanged(bool) signal
+    void checkSelection();
 
 private slots:
     // triggered by timer, causes the emulation to send an updated screen image to each
@@ -475,10 +563,21 @@ private slots:
     void usesMouseChanged(bool usesMouse);
 
 private:
+    // counts @p ch towards the output inspected for binary data and returns
+    // true if output should be discarded from now on
+    bool detectBinaryOutput(ushort ch);
+
     bool _usesMouse;
+    quint32 _outputGeneration;
+    bool _binaryOutputGuard;
+    bool _discardingOutput;
+    int _inspectedCharacters;   // characters in the current sample
+    int _binaryCharacters;      // characters in the current sample which look like binary data
+    int _binarySamples;         // consecutive samples which look like binary data
     QTimer _bulkTimer1;
     QTimer _bulkTimer2;
     bool _imageSizeInitialized;
+    SessionUsage* _usage;
 };
 }
 
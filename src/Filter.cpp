@@ -107,6 +107,17 @@ QList<Filter::HotSpot*> FilterChain::hotSpots() const
     return list;
 }
 
+QList<Filter::HotSpot*> FilterChain::hotSpotsInLines(int firstLine , int lastLine) const
+{
+    QList<Filter::HotSpot*> list;
+    QListIterator<Filter*> iter(*this);
+    while (iter.hasNext()) {
+        Filter* filter = iter.next();
+        list << filter->hotSpotsInLines(firstLine, lastLine);
+    }
+    return list;
+}
+
 TerminalImageFilterChain::TerminalImageFilterChain()
     : _buffer(0)
     , _linePositions(0)
@@ -241,11 +252,31 @@ QList<Filter::HotSpot*> Filter::hotSpotsAtLine(int line) const
     return _hotspots.values(line);
 }
 
+QList<Filter::HotSpot*> Filter::hotSpotsInLines(int firstLine , int lastLine) const
+{
+    QList<HotSpot*> list;
+
+    for (int line = firstLine ; line <= lastLine ; line++) {
+        QMultiHash<int, HotSpot*>::const_iterator iter = _hotspots.constFind(line);
+        for (; iter != _hotspots.constEnd() && iter.key() == line ; ++iter) {
+            HotSpot* spot = iter.value();
+            // a hotspot spanning several lines is only added at the first of them
+            if (line == qMax(spot->startLine(), firstLine))
+                list << spot;
+        }
+    }
+
+    return list;
+}
+
 Filter::HotSpot* Filter::hotSpotAt(int line , int column) const
 {
-    QList<HotSpot*> hotspots = _hotspots.values(line);
+    // the hotspots of each line are looked up without copying them, since
+    // this is called for every mouse movement over the display
+    QMultiHash<int, HotSpot*>::const_iterator iter = _hotspots.constFind(line);
+    for (; iter != _hotspots.constEnd() && iter.key() == line ; ++iter) {
+        HotSpot* spot = iter.value();
 
-    foreach(HotSpot* spot, hotspots) {
         if (spot->startLine() == line && spot->startColumn() > column)
             continue;
         if (spot->endLine() == line && spot->endColumn() < column)
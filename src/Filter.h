@@ -151,6 +151,13 @@ public:
     /** Returns the list of hotspots identified by the filter which occur on a given line */
     QList<HotSpot*> hotSpotsAtLine(int line) const;
 
+    /**
+     * Returns the list of hotspots identified by the filter which occur on
+     * any of the lines from @p firstLine to @p lastLine.  Each hotspot is
+     * listed once, even if it spans several of the lines.
+     */
+    QList<HotSpot*> hotSpotsInLines(int firstLine , int lastLine) const;
+
     /**
      * TODO: Document me
      */
@@ -339,6 +346,11 @@ public:
     QList<Filter::HotSpot*> hotSpots() const;
     /** Returns a list of all hotspots at the given line in all the chain's filters */
     QList<Filter::HotSpot> hotSpotsAtLine(int line) const;
+    /**
+     * Returns a list of the hotspots in all the chain's filters which occur on
+     * any of the lines from @p firstLine to @p lastLine
+     */
+    QList<Filter::HotSpot*> hotSpotsInLines(int firstLine , int lastLine) const;
 };
 
 /** A filter chain which processes character images from terminal displays */
@@ -28,14 +28,22 @@
 #include <sys/mman.h>
 #include <unistd.h>
 #include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+
+// Qt
+#include <QtCore/QRunnable>
+#include <QtCore/QTemporaryFile>
+#include <QtCore/QThreadPool>
+#include <QtCore/QVarLengthArray>
 
 // KDE
 #include <kde_file.h>
 #include <KDebug>
 #include <KStandardDirs>
 
-// Reasonable line size
-static const int LINE_SIZE = 1024;
+// Number of lines copied at once when the history changes type
+static const int COPY_BATCH_LINES = 1000;
 
 using namespace Konsole;
 
@@ -54,113 +62,310 @@ using namespace Konsole;
    at constant costs.
 */
 
+// Format run encoding shared by HistoryScrollFile and CompactHistoryLine.
+// A line is stored as its character values plus one CharacterFormat for each
+// run of characters with the same format.
+
+// returns the number of format runs in cells
+static int countFormatRuns(const Character* cells, int count)
+{
+    if (count == 0)
+        return 0;
+
+    int runs = 1;
+    const Character* format = &cells[0];
+    for (int i = 1; i < count; i++) {
+        if (!cells[i].equalsFormat(*format)) {
+            runs++; // format change detected
+            format = &cells[i];
+        }
+    }
+
+    return runs;
+}
+
+// records the format runs of cells in formats, which must have room for
+// countFormatRuns() entries, and the character values in text
+static void encodeFormatRuns(const Character* cells, int count, CharacterFormat* formats, quint16* text)
+{
+    if (count == 0)
+        return;
+
+    // there's always at least 1 format (for the entire line, unless a change happens)
+    const Character* format = &cells[0];
+    formats[0].setFormat(*format);
+    formats[0].startPos = 0;
+    text[0] = cells[0].character;
+
+    int run = 1;
+    for (int i = 1; i < count; i++) {
+        if (!cells[i].equalsFormat(*format)) {
+            format = &cells[i];
+            formats[run].setFormat(*format);
+            formats[run].startPos = i;
+            run++;
+        }
+        text[i] = cells[i].character;
+    }
+}
+
+// decodes count characters starting at startColumn from their text and format runs
+static void decodeFormatRuns(const quint16* text, const CharacterFormat* formats, int formatCount,
+                             int startColumn, int count, Character* result)
+{
+    // find the run containing the first character, then step through
+    // the runs rather than searching for each character's run
+    int run = 0;
+    while (run + 1 < formatCount && startColumn >= formats[run + 1].startPos)
+        run++;
+
+    for (int i = startColumn; i < startColumn + count; i++) {
+        while (run + 1 < formatCount && i >= formats[run + 1].startPos)
+            run++;
+
+        Character& r = result[i - startColumn];
+        r.character = text[i];
+        r.rendition = formats[run].rendition;
+        r.foregroundColor = formats[run].fgColor;
+        r.backgroundColor = formats[run].bgColor;
+        r.isRealCharacter = formats[run].isRealCharacter;
+    }
+}
+
 // History File ///////////////////////////////////////////
-HistoryFile::HistoryFile()
-    : _fd(-1),
-      _length(0),
-      _fileMap(0),
-      _readWriteBalance(0)
+HistoryFile::Segment::Segment()
+    : fd(-1),
+      length(0),
+      fileMap(0)
 {
     const QString tmpFormat = KStandardDirs::locateLocal("tmp", QString())
                               + "konsole-XXXXXX.history";
-    _tmpFile.setFileTemplate(tmpFormat);
-    if (_tmpFile.open()) {
-        _tmpFile.setAutoRemove(true);
-        _fd = _tmpFile.handle();
+
+    // QTemporaryFile keeps its descriptor open until it is destroyed, so
+    // the segment uses a duplicate which it can close once it is full
+    QTemporaryFile file(tmpFormat);
+    file.setAutoRemove(false);
+    if (file.open()) {
+        fileName = file.fileName();
+        fd = dup(file.handle());
     }
 }
 
-HistoryFile::~HistoryFile()
+HistoryFile::Segment::~Segment()
 {
-    if (_fileMap)
+    if (fileMap)
         unmap();
+    close();
+
+    if (!fileName.isEmpty())
+        unlink(QFile::encodeName(fileName));
 }
 
-//TODO:  Mapping the entire file in will cause problems if the history file becomes exceedingly large,
-//(ie. larger than available memory).  HistoryFile::map() should only map in sections of the file at a time,
-//to avoid this.
-void HistoryFile::map()
+bool HistoryFile::Segment::open()
+{
+    if (fd >= 0)
+        return true;
+
+    // full segments are only read
+    fd = KDE_open(QFile::encodeName(fileName), O_RDONLY);
+    if (fd < 0) {
+        perror("HistoryFile::Segment::open");
+        return false;
+    }
+
+    return true;
+}
+
+void HistoryFile::Segment::close()
+{
+    if (fd >= 0) {
+        ::close(fd);
+        fd = -1;
+    }
+}
+
+bool HistoryFile::Segment::map()
 {
-    Q_ASSERT(_fileMap == 0);
+    Q_ASSERT(fileMap == 0);
+    Q_ASSERT(fd >= 0);
 
-    _fileMap = (char*)mmap(0 , _length , PROT_READ , MAP_PRIVATE , _fd , 0);
+    fileMap = (char*)mmap(0 , length , PROT_READ , MAP_PRIVATE , fd , 0);
 
-    //if mmap'ing fails, fall back to the read-lseek combination
-    if (_fileMap == MAP_FAILED) {
-        _readWriteBalance = 0;
-        _fileMap = 0;
+    //if mmap'ing fails, fall back to reading
+    if (fileMap == MAP_FAILED) {
+        fileMap = 0;
         kWarning() << "mmap'ing history failed.  errno = " << errno;
+        return false;
     }
+
+    return true;
 }
 
-void HistoryFile::unmap()
+void HistoryFile::Segment::unmap()
 {
-    int result = munmap(_fileMap , _length);
+    int result = munmap(fileMap , length);
     Q_ASSERT(result == 0);
     Q_UNUSED(result);
 
-    _fileMap = 0;
+    fileMap = 0;
+}
+
+HistoryFile::HistoryFile(qint64 segmentSize)
+    : _segmentSize(segmentSize),
+      _length(0),
+      _openSegment(0),
+      _mapped(false),
+      _readWriteBalance(0)
+{
+    Q_ASSERT(_segmentSize > 0);
+}
+
+HistoryFile::~HistoryFile()
+{
+    qDeleteAll(_segments);
+}
+
+void HistoryFile::map()
+{
+    _mapped = true;
+}
+
+void HistoryFile::unmap()
+{
+    foreach(Segment* segment, _segments) {
+        if (segment->fileMap)
+            segment->unmap();
+    }
+
+    _mapped = false;
 }
 
 bool HistoryFile::isMapped() const
 {
-    return (_fileMap != 0);
+    return _mapped;
 }
 
-void HistoryFile::add(const unsigned char* buffer, int count)
+qint64 HistoryFile::segmentSize() const
 {
-    if (_fileMap)
-        unmap();
+    return _segmentSize;
+}
 
+HistoryFile::Segment* HistoryFile::segmentAt(qint64 position) const
+{
+    return _segments[position / _segmentSize];
+}
+
+bool HistoryFile::openForReading(Segment* segment)
+{
+    if (segment->fd >= 0)
+        return true;
+
+    if (_openSegment)
+        _openSegment->close();
+    _openSegment = 0;
+
+    if (!segment->open())
+        return false;
+
+    _openSegment = segment;
+    return true;
+}
+
+void HistoryFile::add(const unsigned char* buffer, qint64 count)
+{
     _readWriteBalance++;
 
-    int rc = 0;
+    while (count > 0) {
+        // start a new segment when the last one is full
+        if (_length == _segments.count() * _segmentSize)
+            _segments << new Segment;
+
+        Segment* segment = _segments.last();
+        const qint64 chunk = qMin(count, _segmentSize - segment->length);
+
+        // only full segments are mmap'ed, so there is no mapping of this
+        // segment which would have to be discarded
+        Q_ASSERT(segment->fileMap == 0);
+
+        qint64 written = 0;
+        while (written < chunk) {
+            const ssize_t rc = pwrite(segment->fd, buffer + written, chunk - written,
+                                      segment->length + written);
+            if (rc < 0) {
+                if (errno == EINTR)
+                    continue;
+                perror("HistoryFile::add.write");
+                return;
+            }
+            written += rc;
+        }
 
-    rc = KDE_lseek(_fd, _length, SEEK_SET);
-    if (rc < 0) {
-        perror("HistoryFile::add.seek");
-        return;
-    }
-    rc = write(_fd, buffer, count);
-    if (rc < 0) {
-        perror("HistoryFile::add.write");
-        return;
+        segment->length += chunk;
+        _length += chunk;
+        buffer += chunk;
+        count -= chunk;
+
+        // a full segment is not written to again
+        if (segment->length == _segmentSize)
+            segment->close();
     }
-    _length += rc;
 }
 
-void HistoryFile::get(unsigned char* buffer, int size, int loc)
+void HistoryFile::get(unsigned char* buffer, qint64 size, qint64 loc)
 {
+    if (loc < 0 || size < 0 || loc + size > _length) {
+        fprintf(stderr, "getHist(...,%lld,%lld): invalid args.\n", size, loc);
+        return;
+    }
+
     //count number of get() calls vs. number of add() calls.
     //If there are many more get() calls compared with add()
-    //calls (decided by using MAP_THRESHOLD) then mmap the log
-    //file to improve performance.
+    //calls (decided by using MAP_THRESHOLD) then mmap the
+    //segments to improve performance.
     _readWriteBalance--;
-    if (!_fileMap && _readWriteBalance < MAP_THRESHOLD)
+    if (!_mapped && _readWriteBalance < MAP_THRESHOLD)
         map();
 
-    if (_fileMap) {
-        for (int i = 0; i < size; i++)
-            buffer[i] = _fileMap[loc + i];
-    } else {
-        int rc = 0;
+    while (size > 0) {
+        Segment* segment = segmentAt(loc);
+        const qint64 offset = loc % _segmentSize;
+        const qint64 chunk = qMin(size, _segmentSize - offset);
 
-        if (loc < 0 || size < 0 || loc + size > _length)
-            fprintf(stderr, "getHist(...,%d,%d): invalid args.\n", size, loc);
-        rc = KDE_lseek(_fd, loc, SEEK_SET);
-        if (rc < 0) {
-            perror("HistoryFile::get.seek");
+        if (!segment->fileMap && !openForReading(segment))
             return;
+
+        // the last segment is still growing, so it is always read.  A mapping
+        // doesn't need the descriptor, so the segment is closed again
+        if (_mapped && !segment->fileMap && segment->length == _segmentSize
+                && segment->map()) {
+            segment->close();
+            if (segment == _openSegment)
+                _openSegment = 0;
         }
-        rc = read(_fd, buffer, size);
-        if (rc < 0) {
-            perror("HistoryFile::get.read");
-            return;
+
+        if (segment->fileMap) {
+            memcpy(buffer, segment->fileMap + offset, chunk);
+        } else {
+            qint64 done = 0;
+            while (done < chunk) {
+                const ssize_t rc = pread(segment->fd, buffer + done, chunk - done, offset + done);
+                if (rc < 0 && errno == EINTR)
+                    continue;
+                if (rc <= 0) {
+                    perror("HistoryFile::get.read");
+                    return;
+                }
+                done += rc;
+            }
         }
+
+        buffer += chunk;
+        loc += chunk;
+        size -= chunk;
     }
 }
 
-int HistoryFile::len() const
+qint64 HistoryFile::len() const
 {
     return _length;
 }
@@ -177,27 +382,100 @@ HistoryScroll::~HistoryScroll()
     delete _historyType;
 }
 
+namespace Konsole
+{
+// Deletes a history on the thread pool
+class DeleteHistoryJob : public QRunnable
+{
+public:
+    explicit DeleteHistoryJob(HistoryScroll* history)
+        : _history(history) {
+    }
+
+    virtual void run() {
+        delete _history;
+    }
+
+private:
+    HistoryScroll* _history;
+};
+}
+
+void HistoryScroll::deleteInBackground(HistoryScroll* history)
+{
+    if (history)
+        QThreadPool::globalInstance()->start(new DeleteHistoryJob(history));
+}
+
 bool HistoryScroll::hasScroll()
 {
     return true;
 }
 
+void HistoryScroll::readLines(int firstLine, int count, LineBlock* block)
+{
+    for (int line = firstLine; line < firstLine + count; line++) {
+        const int length = getLineLen(line);
+        const LineProperty properties = isWrappedLine(line) ? LINE_WRAPPED : LINE_DEFAULT;
+        Character* cells = block->appendLine(length, properties);
+        getCells(line, 0, length, cells);
+    }
+}
+
+void HistoryScroll::addLines(const LineBlock& block)
+{
+    for (int line = 0; line < block.lineCount(); line++) {
+        addCells(block.characters(line), block.lineLength(line));
+        addLine(block.lineProperties(line) & LINE_WRAPPED);
+    }
+}
+
 // History Scroll File //////////////////////////////////////
 
 /*
-   The history scroll makes a Row(Row(Cell)) from
-   two history buffers. The index buffer contains
-   start of line positions which refer to the cells
-   buffer.
-
-   Note that index[0] addresses the second line
-   (line #1), while the first line (line #0) starts
-   at 0 in cells.
+   The history scroll stores each line as a record in a single history
+   file, using the same text and format run encoding as CompactHistoryLine:
+
+       quint16          number of format runs
+       CharacterFormat  format runs
+       quint16          character values
+
+   The offset of each record, and the length and wrap flag of each line,
+   are kept in memory so that the line metadata can be queried without
+   touching the file.
 */
 
+// returns the size of the record for a line of length characters
+static int recordSize(int formatCount, int length)
+{
+    return sizeof(quint16) + formatCount * sizeof(CharacterFormat) + length * sizeof(quint16);
+}
+
+// writes the record for a line to record, which must have room for recordSize() bytes
+static void encodeRecord(const Character* cells, int length, quint16 formatCount, unsigned char* record)
+{
+    memcpy(record, &formatCount, sizeof(quint16));
+    CharacterFormat* formats = reinterpret_cast<CharacterFormat*>(record + sizeof(quint16));
+    quint16* text = reinterpret_cast<quint16*>(formats + formatCount);
+    encodeFormatRuns(cells, length, formats, text);
+}
+
+// decodes count characters starting at startColumn from a line's record
+static void decodeRecord(const unsigned char* record, int startColumn, int count, Character* result)
+{
+    quint16 formatCount;
+    memcpy(&formatCount, record, sizeof(quint16));
+
+    const CharacterFormat* formats = reinterpret_cast<const CharacterFormat*>(record + sizeof(quint16));
+    const quint16* text = reinterpret_cast<const quint16*>(formats + formatCount);
+
+    decodeFormatRuns(text, formats, formatCount, startColumn, count, result);
+}
+
 HistoryScrollFile::HistoryScrollFile(const QString& logFileName)
     : HistoryScroll(new HistoryTypeFile(logFileName))
 {
+    _lineOffsets << 0;
 }
 
 HistoryScrollFile::~HistoryScrollFile()
@@ -206,57 +484,131 @@ HistoryScrollFile::~HistoryScrollFile()
 
 int HistoryScrollFile::getLines()
 {
-    return _index.len() / sizeof(int);
+    return _lineLengths.count();
 }
 
 int HistoryScrollFile::getLineLen(int lineno)
 {
-    return (startOfLine(lineno + 1) - startOfLine(lineno)) / sizeof(Character);
+    if (lineno < 0 || lineno >= _lineLengths.count())
+        return 0;
+
+    return _lineLengths[lineno] & ~LINE_WRAPPED_FLAG;
 }
 
 bool HistoryScrollFile::isWrappedLine(int lineno)
 {
-    if (lineno >= 0 && lineno <= getLines()) {
-        unsigned char flag;
-        _lineflags.get((unsigned char*)&flag, sizeof(unsigned char), (lineno)*sizeof(unsigned char));
-        return flag;
-    }
-    return false;
+    if (lineno < 0 || lineno >= _lineLengths.count())
+        return false;
+
+    return _lineLengths[lineno] & LINE_WRAPPED_FLAG;
 }
 
-int HistoryScrollFile::startOfLine(int lineno)
+void HistoryScrollFile::getCells(int lineno, int colno, int count, Character res[])
 {
-    if (lineno <= 0) return 0;
-    if (lineno <= getLines()) {
-        if (!_index.isMapped())
-            _index.map();
+    if (count <= 0)
+        return;
+
+    Q_ASSERT(lineno >= 0 && lineno < _lineLengths.count());
+    Q_ASSERT(colno >= 0 && colno + count <= getLineLen(lineno));
+
+    // read the whole record at once rather than the format runs and text separately
+    const qint64 start = _lineOffsets[lineno];
+    QVarLengthArray<unsigned char, 4096> record(_lineOffsets[lineno + 1] - start);
+    _records.get(record.data(), record.size(), start);
+
+    decodeRecord(record.data(), colno, count, res);
+}
 
-        int res;
-        _index.get((unsigned char*)&res, sizeof(int), (lineno - 1)*sizeof(int));
-        return res;
+void HistoryScrollFile::readLines(int firstLine, int count, LineBlock* block)
+{
+    if (count <= 0)
+        return;
+
+    Q_ASSERT(firstLine >= 0 && firstLine + count <= _lineLengths.count());
+
+    // the records of consecutive lines are next to each other in the file,
+    // so they are read with a single call
+    const qint64 start = _lineOffsets[firstLine];
+    QByteArray records;
+    records.resize(_lineOffsets[firstLine + count] - start);
+    _records.get(reinterpret_cast<unsigned char*>(records.data()), records.size(), start);
+
+    const unsigned char* data = reinterpret_cast<const unsigned char*>(records.constData());
+    for (int line = firstLine; line < firstLine + count; line++) {
+        const int length = _lineLengths[line] & ~LINE_WRAPPED_FLAG;
+        const LineProperty properties = (_lineLengths[line] & LINE_WRAPPED_FLAG) ? LINE_WRAPPED : LINE_DEFAULT;
+
+        Character* cells = block->appendLine(length, properties);
+        if (length > 0)
+            decodeRecord(data + (_lineOffsets[line] - start), 0, length, cells);
     }
-    return _cells.len();
 }
 
-void HistoryScrollFile::getCells(int lineno, int colno, int count, Character res[])
+HistoryScroll::MemoryUsage HistoryScrollFile::memoryUsage() const
 {
-    _cells.get((unsigned char*)res, count * sizeof(Character), startOfLine(lineno) + colno * sizeof(Character));
+    MemoryUsage usage;
+    usage.memoryBytes = _lineOffsets.capacity() * sizeof(qint64)
+                        + _lineLengths.capacity() * sizeof(quint32)
+                        + _pendingLine.capacity() * sizeof(Character);
+    usage.fileBytes = _records.len();
+    return usage;
 }
 
 void HistoryScrollFile::addCells(const Character text[], int count)
 {
-    _cells.add((unsigned char*)text, count * sizeof(Character));
+    const int start = _pendingLine.size();
+    _pendingLine.resize(start + count);
+    qCopy(text, text + count, _pendingLine.begin() + start);
+}
+
+void HistoryScrollFile::addCellsVector(const QVector<Character>& cells)
+{
+    // share the vector rather than copying it in the common case
+    if (_pendingLine.isEmpty())
+        _pendingLine = cells;
+    else
+        _pendingLine += cells;
 }
 
 void HistoryScrollFile::addLine(bool previousWrapped)
 {
-    if (_index.isMapped())
-        _index.unmap();
+    const int length = _pendingLine.size();
+    const Character* cells = _pendingLine.constData();
+
+    const quint16 formatCount = countFormatRuns(cells, length);
+    QVarLengthArray<unsigned char, 4096> record(recordSize(formatCount, length));
+    encodeRecord(cells, length, formatCount, record.data());
+
+    _records.add(record.data(), record.size());
+    _lineOffsets << _records.len();
+    _lineLengths << (quint32(length) | (previousWrapped ? LINE_WRAPPED_FLAG : 0));
+
+    _pendingLine.clear();
+}
+
+void HistoryScrollFile::addLines(const LineBlock& block)
+{
+    Q_ASSERT(_pendingLine.isEmpty());
+
+    // the records of all the lines are written to the file at once
+    QByteArray records;
+    qint64 offset = _records.len();
+    for (int line = 0; line < block.lineCount(); line++) {
+        const Character* cells = block.characters(line);
+        const int length = block.lineLength(line);
+        const bool wrapped = block.lineProperties(line) & LINE_WRAPPED;
+
+        const quint16 formatCount = countFormatRuns(cells, length);
+        const int start = records.size();
+        records.resize(start + recordSize(formatCount, length));
+        encodeRecord(cells, length, formatCount, reinterpret_cast<unsigned char*>(records.data()) + start);
+
+        offset += records.size() - start;
+        _lineOffsets << offset;
+        _lineLengths << (quint32(length) | (wrapped ? LINE_WRAPPED_FLAG : 0));
+    }
 
-    int locn = _cells.len();
-    _index.add((unsigned char*)&locn, sizeof(int));
-    unsigned char flags = previousWrapped ? 0x01 : 0x00;
-    _lineflags.add((unsigned char*)&flags, sizeof(unsigned char));
+    _records.add(reinterpret_cast<const unsigned char*>(records.constData()), records.size());
 }
 
 // History Scroll None //////////////////////////////////////
@@ -294,6 +646,14 @@ void HistoryScrollNone::getCells(int, int, int, Character [])
 {
 }
 
+HistoryScroll::MemoryUsage HistoryScrollNone::memoryUsage() const
+{
+    MemoryUsage usage;
+    usage.memoryBytes = 0;
+    usage.fileBytes = 0;
+    return usage;
+}
+
 void HistoryScrollNone::addCells(const Character [], int)
 {
 }
@@ -360,6 +720,15 @@ void CompactHistoryBlockList::deallocate(void* ptr)
     }
 }
 
+qint64 CompactHistoryBlockList::allocatedBytes() const
+{
+    qint64 bytes = 0;
+    foreach(CompactHistoryBlock* block, list) {
+        bytes += block->length();
+    }
+    return bytes;
+}
+
 CompactHistoryBlockList::~CompactHistoryBlockList()
 {
     qDeleteAll(list.begin(), list.end());
@@ -373,23 +742,15 @@ void* CompactHistoryLine::operator new(size_t size, CompactHistoryBlockList& blo
 
 CompactHistoryLine::CompactHistoryLine(const TextLine& line, CompactHistoryBlockList& bList)
     : _blockListRef(bList),
-      _formatLength(0)
+      _formatLength(0),
+      _refCount(1),
+      _hash(0)
 {
     _length = line.size();
+    _wrapped = false;
 
     if (line.size() > 0) {
-        _formatLength = 1;
-        int k = 1;
-
-        // count number of different formats in this text line
-        Character c = line[0];
-        while (k < _length) {
-            if (!(line[k].equalsFormat(c))) {
-                _formatLength++; // format change detected
-                c = line[k];
-            }
-            k++;
-        }
+        _formatLength = countFormatRuns(line.constData(), _length);
 
         //kDebug() << "number of different formats in string: " << _formatLength;
         _formatArray = (CharacterFormat*) _blockListRef.allocate(sizeof(CharacterFormat) * _formatLength);
@@ -397,32 +758,7 @@ CompactHistoryLine::CompactHistoryLine(const TextLine& line, CompactHistoryBlock
         _text = (quint16*) _blockListRef.allocate(sizeof(quint16) * line.size());
         Q_ASSERT(_text != 0);
 
-        _length = line.size();
-        _wrapped = false;
-
-        // record formats and their positions in the format array
-        c = line[0];
-        _formatArray[0].setFormat(c);
-        _formatArray[0].startPos = 0;                      // there's always at least 1 format (for the entire line, unless a change happens)
-
-        k = 1;                                            // look for possible format changes
-        int j = 1;
-        while (k < _length && j < _formatLength) {
-            if (!(line[k].equalsFormat(c))) {
-                c = line[k];
-                _formatArray[j].setFormat(c);
-                _formatArray[j].startPos = k;
-                //kDebug() << "format entry " << j << " at pos " << _formatArray[j].startPos << " " << &(_formatArray[j].startPos) ;
-                j++;
-            }
-            k++;
-        }
-
-        // copy character values
-        for (int i = 0; i < line.size(); i++) {
-            _text[i] = line[i].character;
-            //kDebug() << "char " << i << " at mem " << &(text[i]);
-        }
+        encodeFormatRuns(line.constData(), _length, _formatArray, _text);
     }
     //kDebug() << "line created, length " << length << " at " << &(length);
 }
@@ -455,15 +791,67 @@ void CompactHistoryLine::getCharacters(Character* array, int size, int startColu
     Q_ASSERT(startColumn >= 0 && size >= 0);
     Q_ASSERT(startColumn + size <= static_cast<int>(getLength()));
 
-    for (int i = startColumn; i < size + startColumn; i++) {
-        getCharacter(i, array[i - startColumn]);
+    decodeFormatRuns(_text, _formatArray, _formatLength, startColumn, size, array);
+}
+
+bool CompactHistoryLine::equals(const TextLine& line, bool wrapped) const
+{
+    if (line.size() != _length || wrapped != _wrapped)
+        return false;
+
+    // compare the characters and the format runs which encodeFormatRuns()
+    // would record for line
+    int run = -1;
+    const Character* format = 0;
+    for (int i = 0; i < _length; i++) {
+        const Character& c = line[i];
+        if (c.character != _text[i])
+            return false;
+
+        if (!format || !c.equalsFormat(*format)) {
+            format = &c;
+            run++;
+            if (run >= _formatLength)
+                return false;
+
+            const CharacterFormat& f = _formatArray[run];
+            if (f.startPos != i || f.rendition != c.rendition || f.fgColor != c.foregroundColor
+                    || f.bgColor != c.backgroundColor || f.isRealCharacter != c.isRealCharacter)
+                return false;
+        }
     }
+
+    return run + 1 == _formatLength;
+}
+
+int CompactHistoryLine::payloadSize() const
+{
+    return sizeof(CompactHistoryLine) + _formatLength * sizeof(CharacterFormat)
+           + _length * sizeof(quint16);
+}
+
+// hashes the text, renditions and wrap flag of a line.  lines which only
+// differ in color collide, equals() tells them apart
+static uint hashLine(const TextLine& line, bool wrapped)
+{
+    uint hash = wrapped ? 1 : 0;
+    const Character* cells = line.constData();
+    for (int i = 0; i < line.size(); i++)
+        hash = hash * 31 + (cells[i].character ^ (cells[i].rendition << 16));
+
+    return hash;
 }
 
 CompactHistoryScroll::CompactHistoryScroll(unsigned int maxLineCount)
     : HistoryScroll(new CompactHistoryType(maxLineCount))
     , _lines()
     , _blockList()
+    , _deduplicate(false)
+    , _storedLineCount(0)
+    , _savedBytes(0)
+    , _linesSinceFlush(0)
+    , _linesBeforeFlush(0)
+    , _skippedLineCount(0)
 {
     //kDebug() << "scroll of length " << maxLineCount << " created";
     setMaxNbLines(maxLineCount);
@@ -471,19 +859,44 @@ CompactHistoryScroll::CompactHistoryScroll(unsigned int maxLineCount)
 
 CompactHistoryScroll::~CompactHistoryScroll()
 {
-    qDeleteAll(_lines.begin(), _lines.end());
-    _lines.clear();
+    // the stored lines and their text and formats only use memory from
+    // _blockList, which is released a block at a time when it is destroyed.
+    // releasing the lines one by one would search the block list three
+    // times for each line, which takes seconds for a large history
 }
 
 void CompactHistoryScroll::addCellsVector(const TextLine& cells)
 {
-    CompactHistoryLine* line;
-    line = new(_blockList) CompactHistoryLine(cells, _blockList);
-
-    if (_lines.size() > static_cast<int>(_maxLineCount)) {
-        delete _lines.takeAt(0);
+    // lines are only queued here, sharing the screen's line vector, and
+    // compacted in batches by flush().  if the history is full, lines which
+    // are dropped before the next flush() are never compacted at all.
+    if (getLines() > static_cast<int>(_maxLineCount)) {
+        removeFirstLine();
     }
-    _lines.append(line);
+
+    PendingLine line;
+    line.cells = cells;
+    line.wrapped = false;
+    _pendingLines.append(line);
+    _linesSinceFlush++;
+
+    // while output floods in, the queue only holds lines which are going
+    // to be dropped before they can be displayed, so don't compact them
+    // unless the queue has grown too large
+    const int pending = _pendingLines.count();
+    if (pending > MAX_DEFERRED_LINES || (pending > MAX_PENDING_LINES && !pendingLinesWillBeDropped()))
+        storePendingLines();
+}
+
+bool CompactHistoryScroll::pendingLinesWillBeDropped() const
+{
+    // assume that output keeps arriving as fast as it did during the
+    // interval before the last flush()
+    const int expectedLines = qMax(0, _linesBeforeFlush - _linesSinceFlush);
+
+    // the oldest pending line is dropped once there are more than
+    // _maxLineCount lines after it
+    return _pendingLines.count() - 1 + expectedLines > static_cast<int>(_maxLineCount);
 }
 
 void CompactHistoryScroll::addCells(const Character a[], int count)
@@ -495,19 +908,167 @@ void CompactHistoryScroll::addCells(const Character a[], int count)
 
 void CompactHistoryScroll::addLine(bool previousWrapped)
 {
-    CompactHistoryLine* line = _lines.last();
-    //kDebug() << "last line at address " << line;
-    line->setWrapped(previousWrapped);
+    if (!_pendingLines.isEmpty()) {
+        _pendingLines.last().wrapped = previousWrapped;
+    } else {
+        CompactHistoryLine* line = _lines.last();
+        //kDebug() << "last line at address " << line;
+        if (line->isWrapped() == previousWrapped)
+            return;
+
+        // the line may be shared with other lines which must not change,
+        // so store it again with the new flag
+        TextLine cells(line->getLength());
+        line->getCharacters(cells.data(), cells.size(), 0);
+        _lines.last() = storeLine(cells, previousWrapped);
+        releaseLine(line);
+    }
+}
+
+void CompactHistoryScroll::addLines(const LineBlock& block)
+{
+    // only the last lines of a block which is larger than the history
+    // remain, the lines before them would be dropped as soon as they
+    // were queued
+    const int retainedLines = static_cast<int>(_maxLineCount) + 1;
+    const int skippedLines = qMax(0, block.lineCount() - retainedLines);
+
+    _skippedLineCount += skippedLines;
+    _linesSinceFlush += skippedLines;
+
+    for (int line = skippedLines; line < block.lineCount(); line++) {
+        addCells(block.characters(line), block.lineLength(line));
+        addLine(block.lineProperties(line) & LINE_WRAPPED);
+    }
+}
+
+void CompactHistoryScroll::flush()
+{
+    storePendingLines();
+
+    _linesBeforeFlush = _linesSinceFlush;
+    _linesSinceFlush = 0;
+}
+
+void CompactHistoryScroll::storePendingLines()
+{
+    foreach(const PendingLine& pending, _pendingLines) {
+        _lines.append(storeLine(pending.cells, pending.wrapped));
+    }
+
+    _pendingLines.clear();
+}
+
+CompactHistoryLine* CompactHistoryScroll::storeLine(const TextLine& cells, bool wrapped)
+{
+    uint hash = 0;
+    if (_deduplicate) {
+        hash = hashLine(cells, wrapped);
+
+        QMultiHash<uint, CompactHistoryLine*>::const_iterator iter = _sharedLines.constFind(hash);
+        while (iter != _sharedLines.constEnd() && iter.key() == hash) {
+            CompactHistoryLine* line = iter.value();
+            if (line->equals(cells, wrapped)) {
+                line->ref();
+                _savedBytes += line->payloadSize();
+                return line;
+            }
+            ++iter;
+        }
+    }
+
+    CompactHistoryLine* line = new(_blockList) CompactHistoryLine(cells, _blockList);
+    line->setWrapped(wrapped);
+    _storedLineCount++;
+
+    if (_deduplicate) {
+        line->setHash(hash);
+        _sharedLines.insert(hash, line);
+    }
+
+    return line;
+}
+
+void CompactHistoryScroll::releaseLine(CompactHistoryLine* line)
+{
+    if (line->deref()) {
+        _savedBytes -= line->payloadSize();
+        return;
+    }
+
+    // the line is only in the table if it was stored while deduplication was enabled
+    if (!_sharedLines.isEmpty())
+        _sharedLines.remove(line->hash(), line);
+
+    _storedLineCount--;
+    delete line;
+}
+
+void CompactHistoryScroll::removeFirstLine()
+{
+    if (!_lines.isEmpty()) {
+        releaseLine(_lines.takeAt(0));
+    } else {
+        _pendingLines.removeFirst();
+        _skippedLineCount++;
+    }
+}
+
+qint64 CompactHistoryScroll::skippedLineCount() const
+{
+    return _skippedLineCount;
+}
+
+qint64 CompactHistoryScroll::takeSkippedLineCount()
+{
+    const qint64 count = _skippedLineCount;
+    _skippedLineCount = 0;
+    return count;
+}
+
+void CompactHistoryScroll::setDeduplicationEnabled(bool enable)
+{
+    if (enable == _deduplicate)
+        return;
+
+    _deduplicate = enable;
+
+    // lines which are already shared stay shared, but new lines won't be
+    // matched against them
+    if (!enable)
+        _sharedLines.clear();
+
+    delete _historyType;
+    _historyType = new CompactHistoryType(_maxLineCount, _deduplicate);
+}
+
+bool CompactHistoryScroll::isDeduplicationEnabled() const
+{
+    return _deduplicate;
+}
+
+CompactHistoryScroll::DeduplicationStatistics CompactHistoryScroll::deduplicationStatistics() const
+{
+    DeduplicationStatistics statistics;
+    statistics.lines = _lines.size() + _pendingLines.size();
+    // lines waiting for flush() are not stored yet, count them as distinct
+    statistics.storedLines = _storedLineCount + _pendingLines.size();
+    statistics.savedBytes = _savedBytes;
+    return statistics;
 }
 
 int CompactHistoryScroll::getLines()
 {
-    return _lines.size();
+    return _lines.size() + _pendingLines.size();
 }
 
 int CompactHistoryScroll::getLineLen(int lineNumber)
 {
-    Q_ASSERT(lineNumber >= 0 && lineNumber < _lines.size());
+    Q_ASSERT(lineNumber >= 0 && lineNumber < getLines());
+
+    if (lineNumber >= _lines.size())
+        return _pendingLines[lineNumber - _lines.size()].cells.size();
+
     CompactHistoryLine* line = _lines[lineNumber];
     //kDebug() << "request for line at address " << line;
     return line->getLength();
@@ -516,26 +1077,77 @@ int CompactHistoryScroll::getLineLen(int lineNumber)
 void CompactHistoryScroll::getCells(int lineNumber, int startColumn, int count, Character buffer[])
 {
     if (count == 0) return;
-    Q_ASSERT(lineNumber < _lines.size());
-    CompactHistoryLine* line = _lines[lineNumber];
+    Q_ASSERT(lineNumber < getLines());
     Q_ASSERT(startColumn >= 0);
+
+    if (lineNumber >= _lines.size()) {
+        const TextLine& cells = _pendingLines[lineNumber - _lines.size()].cells;
+        Q_ASSERT(startColumn + count <= cells.size());
+        qCopy(cells.constBegin() + startColumn, cells.constBegin() + startColumn + count, buffer);
+        return;
+    }
+
+    CompactHistoryLine* line = _lines[lineNumber];
     Q_ASSERT((unsigned int)startColumn <= line->getLength() - count);
     line->getCharacters(buffer, count, startColumn);
 }
 
+void CompactHistoryScroll::readLines(int firstLine, int count, LineBlock* block)
+{
+    Q_ASSERT(firstLine >= 0 && firstLine + count <= getLines());
+
+    for (int line = firstLine; line < firstLine + count; line++) {
+        if (line >= _lines.size()) {
+            const PendingLine& pending = _pendingLines[line - _lines.size()];
+            Character* cells = block->appendLine(pending.cells.size(), pending.wrapped ? LINE_WRAPPED : LINE_DEFAULT);
+            qCopy(pending.cells.constBegin(), pending.cells.constEnd(), cells);
+        } else {
+            CompactHistoryLine* stored = _lines[line];
+            const int length = stored->getLength();
+            Character* cells = block->appendLine(length, stored->isWrapped() ? LINE_WRAPPED : LINE_DEFAULT);
+            stored->getCharacters(cells, length, 0);
+        }
+    }
+}
+
+HistoryScroll::MemoryUsage CompactHistoryScroll::memoryUsage() const
+{
+    // lines waiting for flush() may share their cells with the screen, they
+    // are counted as if they did not
+    qint64 pendingBytes = 0;
+    foreach(const PendingLine& pending, _pendingLines) {
+        pendingBytes += sizeof(PendingLine) + pending.cells.capacity() * sizeof(Character);
+    }
+
+    MemoryUsage usage;
+    usage.memoryBytes = _blockList.allocatedBytes()
+                        + _lines.size() * sizeof(CompactHistoryLine*)
+                        + _sharedLines.size() * (sizeof(uint) + sizeof(CompactHistoryLine*))
+                        + pendingBytes;
+    usage.fileBytes = 0;
+    return usage;
+}
+
 void CompactHistoryScroll::setMaxNbLines(unsigned int lineCount)
 {
     _maxLineCount = lineCount;
 
-    while (_lines.size() > static_cast<int>(lineCount)) {
-        delete _lines.takeAt(0);
+    while (getLines() > static_cast<int>(lineCount)) {
+        removeFirstLine();
     }
     //kDebug() << "set max lines to: " << _maxLineCount;
+
+    delete _historyType;
+    _historyType = new CompactHistoryType(_maxLineCount, _deduplicate);
 }
 
 bool CompactHistoryScroll::isWrappedLine(int lineNumber)
 {
-    Q_ASSERT(lineNumber < _lines.size());
+    Q_ASSERT(lineNumber < getLines());
+
+    if (lineNumber >= _lines.size())
+        return _pendingLines[lineNumber - _lines.size()].wrapped;
+
     return _lines[lineNumber]->isWrapped();
 }
 
@@ -551,6 +1163,21 @@ HistoryType::~HistoryType()
 {
 }
 
+void HistoryType::copyLines(HistoryScroll* source, HistoryScroll* destination) const
+{
+    const int lineCount = source->getLines();
+    int firstLine = 0;
+    if (!isUnlimited())
+        firstLine = qMax(0, lineCount - maximumLineCount());
+
+    LineBlock block;
+    for (int line = firstLine; line < lineCount; line += COPY_BATCH_LINES) {
+        block.clear();
+        source->readLines(line, qMin(COPY_BATCH_LINES, lineCount - line), &block);
+        destination->addLines(block);
+    }
+}
+
 //////////////////////////////
 
 HistoryTypeNone::HistoryTypeNone()
@@ -564,7 +1191,7 @@ bool HistoryTypeNone::isEnabled() const
 
 HistoryScroll* HistoryTypeNone::scroll(HistoryScroll* old) const
 {
-    delete old;
+    HistoryScroll::deleteInBackground(old);
     return new HistoryScrollNone();
 }
 
@@ -587,29 +1214,16 @@ bool HistoryTypeFile::isEnabled() const
 
 HistoryScroll* HistoryTypeFile::scroll(HistoryScroll* old) const
 {
-    if (dynamic_cast<HistoryFile *>(old))
+    if (dynamic_cast<HistoryScrollFile*>(old))
         return old; // Unchanged.
 
     HistoryScroll* newScroll = new HistoryScrollFile(_fileName);
 
-    Character line[LINE_SIZE];
-    int lines = (old != 0) ? old->getLines() : 0;
-    for (int i = 0; i < lines; i++) {
-        int size = old->getLineLen(i);
-        if (size > LINE_SIZE) {
-            Character* tmp_line = new Character[size];
-            old->getCells(i, 0, size, tmp_line);
-            newScroll->addCells(tmp_line, size);
-            newScroll->addLine(old->isWrappedLine(i));
-            delete [] tmp_line;
-        } else {
-            old->getCells(i, 0, size, line);
-            newScroll->addCells(line, size);
-            newScroll->addLine(old->isWrappedLine(i));
-        }
+    if (old) {
+        copyLines(old, newScroll);
+        HistoryScroll::deleteInBackground(old);
     }
 
-    delete old;
     return newScroll;
 }
 
@@ -620,11 +1234,17 @@ int HistoryTypeFile::maximumLineCount() const
 
 //////////////////////////////
 
-CompactHistoryType::CompactHistoryType(unsigned int nbLines)
+CompactHistoryType::CompactHistoryType(unsigned int nbLines, bool deduplicate)
     : _maxLines(nbLines)
+    , _deduplicate(deduplicate)
 {
 }
 
+bool CompactHistoryType::isDeduplicationEnabled() const
+{
+    return _deduplicate;
+}
+
 bool CompactHistoryType::isEnabled() const
 {
     return true;
@@ -641,9 +1261,17 @@ HistoryScroll* CompactHistoryType::scroll(HistoryScroll* old) const
         CompactHistoryScroll* oldBuffer = dynamic_cast<CompactHistoryScroll*>(old);
         if (oldBuffer) {
             oldBuffer->setMaxNbLines(_maxLines);
+            oldBuffer->setDeduplicationEnabled(_deduplicate);
             return oldBuffer;
         }
-        delete old;
     }
-    return new CompactHistoryScroll(_maxLines);
+    CompactHistoryScroll* newScroll = new CompactHistoryScroll(_maxLines);
+    newScroll->setDeduplicationEnabled(_deduplicate);
+
+    if (old) {
+        copyLines(old, newScroll);
+        HistoryScroll::deleteInBackground(old);
+    }
+
+    return newScroll;
 }
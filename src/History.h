@@ -26,51 +26,96 @@
 
 // Qt
 #include <QtCore/QList>
+#include <QtCore/QMultiHash>
 #include <QtCore/QVector>
-#include <QtCore/QTemporaryFile>
+#include <QtCore/QString>
 
 // Konsole
 #include "Character.h"
+#include "LineBlock.h"
 
 namespace Konsole
 {
 /*
    An extendable tmpfile(1) based buffer.
+
+   The data is split into a series of fixed-size segment files, so that the
+   buffer is not limited by the size of an int, and each segment can be
+   mapped in independently of the others.  Only the segment being written
+   to and the full segment which was read last keep a file descriptor open,
+   so a large history doesn't use up descriptors.
 */
 
 class HistoryFile
 {
 public:
-    HistoryFile();
+    explicit HistoryFile(qint64 segmentSize = DEFAULT_SEGMENT_SIZE);
     virtual ~HistoryFile();
 
-    virtual void add(const unsigned char* bytes, int len);
-    virtual void get(unsigned char* bytes, int len, int loc);
-    virtual int  len() const;
+    virtual void add(const unsigned char* bytes, qint64 len);
+    virtual void get(unsigned char* bytes, qint64 len, qint64 loc);
+    virtual qint64 len() const;
 
-    //mmaps the file in read-only mode
+    //mmaps full segments in read-only mode as they are read
     void map();
-    //un-mmaps the file
+    //un-mmaps all segments
     void unmap();
-    //returns true if the file is mmap'ed
+    //returns true if segments are mmap'ed when they are read
     bool isMapped() const;
 
+    //size of each segment file
+    qint64 segmentSize() const;
+
+    static const qint64 DEFAULT_SEGMENT_SIZE = 64 * 1024 * 1024;
 
 private:
-    int  _fd;
-    int  _length;
-    QTemporaryFile _tmpFile;
+    class Segment
+    {
+    public:
+        Segment();
+        ~Segment();
+
+        //mmaps the segment, returns false if that failed
+        bool map();
+        void unmap();
+
+        //opens the segment file for reading if it is closed, returns false if that failed
+        bool open();
+        //closes the segment file, the segment can still be read after open()
+        void close();
+
+        QString fileName;
+        //descriptor of the segment file, or -1 if it is closed
+        int fd;
+        qint64 length;
+
+        //pointer to start of mmap'ed segment data, or 0 if the segment is not mmap'ed
+        char* fileMap;
+    };
+
+    //returns the segment containing position
+    Segment* segmentAt(qint64 position) const;
+    //opens a full segment for reading, and closes the one opened before
+    bool openForReading(Segment* segment);
+
+    //segments in order
+    QList<Segment*> _segments;
+    qint64 _segmentSize;
+    qint64 _length;
+
+    //the full segment which was last opened by openForReading(), or 0
+    Segment* _openSegment;
 
-    //pointer to start of mmap'ed file data, or 0 if the file is not mmap'ed
-    char* _fileMap;
+    //true if full segments are mmap'ed when they are read
+    bool _mapped;
 
     //incremented whenever 'add' is called and decremented whenever
     //'get' is called.
     //this is used to detect when a large number of lines are being read and processed from the history
-    //and automatically mmap the file for better performance (saves the overhead of many lseek-read calls).
+    //and automatically mmap the segments for better performance (saves the overhead of many read calls).
     int _readWriteBalance;
 
-    //when _readWriteBalance goes below this threshold, the file will be mmap'ed automatically
+    //when _readWriteBalance goes below this threshold, the segments will be mmap'ed automatically
     static const int MAP_THRESHOLD = -1000;
 };
 
@@ -78,6 +123,10 @@ private:
 
 //////////////////////////////////////////////////////////////////////
 // Abstract base class for file and buffer versions
+//
+// A new way of storing the history only needs a subclass of HistoryScroll
+// and a HistoryType which creates it.  Every store must pass the checks in
+// tests/HistoryConformanceTest, which also measures its performance.
 //////////////////////////////////////////////////////////////////////
 class HistoryType;
 
@@ -87,6 +136,11 @@ public:
     explicit HistoryScroll(HistoryType*);
     virtual ~HistoryScroll();
 
+    // deletes 'history' on QThreadPool::globalInstance(), so that releasing
+    // the storage of a large history doesn't block the caller.  'history'
+    // must not be used once this has been called
+    static void deleteInBackground(HistoryScroll* history);
+
     virtual bool hasScroll();
 
     // access to history
@@ -95,6 +149,22 @@ public:
     virtual void getCells(int lineno, int colno, int count, Character res[]) = 0;
     virtual bool isWrappedLine(int lineno) = 0;
 
+    // appends 'count' lines starting at 'firstLine' to 'block', wrapped
+    // lines have the LINE_WRAPPED property.  the default implementation
+    // reads one line at a time with the methods above, stores which can
+    // read a range of lines at once should override it
+    virtual void readLines(int firstLine, int count, LineBlock* block);
+
+    // memory used by a history, see memoryUsage()
+    struct MemoryUsage {
+        // bytes of memory used by the lines and the information about them
+        qint64 memoryBytes;
+        // bytes of temporary files used by the lines
+        qint64 fileBytes;
+    };
+    // returns an estimate of the memory and disk space used by the history
+    virtual MemoryUsage memoryUsage() const = 0;
+
     // adding lines.
     virtual void addCells(const Character a[], int count) = 0;
     // convenience method - this is virtual so that subclasses can take advantage
@@ -105,6 +175,18 @@ public:
 
     virtual void addLine(bool previousWrapped = false) = 0;
 
+    // adds the lines of 'block', which are wrapped if they have the
+    // LINE_WRAPPED property.  cells added with addCells() must be ended
+    // with addLine() first.  the default implementation adds one line at
+    // a time with the methods above, stores which can add many lines at
+    // once should override it
+    virtual void addLines(const LineBlock& block);
+
+    // stores lines which have been added but are still held in the form they
+    // were added in.  this is called once per display update, so that the
+    // cost of converting lines is taken out of the terminal output processing
+    virtual void flush() {}
+
     //
     // FIXME:  Passing around constant references to HistoryType instances
     // is very unsafe, because those references will no longer
@@ -133,15 +215,27 @@ public:
     virtual void getCells(int lineno, int colno, int count, Character res[]);
     virtual bool isWrappedLine(int lineno);
 
+    virtual void readLines(int firstLine, int count, LineBlock* block);
+    virtual MemoryUsage memoryUsage() const;
+
     virtual void addCells(const Character a[], int count);
+    virtual void addCellsVector(const QVector<Character>& cells);
     virtual void addLine(bool previousWrapped = false);
+    virtual void addLines(const LineBlock& block);
 
 private:
-    int startOfLine(int lineno);
+    // cells added since the last call to addLine()
+    QVector<Character> _pendingLine;
+
+    // line records, see the comment in History.cpp for the format
+    HistoryFile _records;
+
+    // offset of each line's record in _records, followed by the end of the last record
+    QVector<qint64> _lineOffsets;
+    // length of each line, with LINE_WRAPPED_FLAG set if the line is wrapped
+    QVector<quint32> _lineLengths;
 
-    HistoryFile _index; // lines Row(int)
-    HistoryFile _cells; // text  Row(Character)
-    HistoryFile _lineflags; // flags Row(unsigned char)
+    static const quint32 LINE_WRAPPED_FLAG = 0x80000000;
 };
 
 //////////////////////////////////////////////////////////////////////
@@ -159,6 +253,7 @@ public:
     virtual int  getLineLen(int lineno);
     virtual void getCells(int lineno, int colno, int count, Character res[]);
     virtual bool isWrappedLine(int lineno);
+    virtual MemoryUsage memoryUsage() const;
 
     virtual void addCells(const Character a[], int count);
     virtual void addLine(bool previousWrapped = false);
@@ -246,6 +341,8 @@ public:
     int length() {
         return list.size();
     }
+    // returns the total size of the blocks
+    qint64 allocatedBytes() const;
 private:
     QList<CompactHistoryBlock*> list;
 };
@@ -274,6 +371,31 @@ public:
         return _length;
     };
 
+    // returns true if this line holds the same text, formats and wrap flag
+    bool equals(const TextLine& line, bool wrapped) const;
+    // returns the number of bytes used by this line and its text and formats
+    int payloadSize() const;
+
+    // lines with the same contents may be shared when deduplication is enabled
+    // in CompactHistoryScroll, the line is deleted when the last reference is released
+    void ref() {
+        _refCount++;
+    }
+    bool deref() {
+        return --_refCount != 0;
+    }
+    int refCount() const {
+        return _refCount;
+    }
+
+    // hash of the line's contents, used to find identical lines
+    uint hash() const {
+        return _hash;
+    }
+    void setHash(uint hash) {
+        _hash = hash;
+    }
+
 protected:
     CompactHistoryBlockList& _blockListRef;
     CharacterFormat* _formatArray;
@@ -281,6 +403,8 @@ protected:
     quint16* _text;
     quint16 _formatLength;
     bool _wrapped;
+    int _refCount;
+    uint _hash;
 };
 
 class CompactHistoryScroll : public HistoryScroll
@@ -296,18 +420,105 @@ public:
     virtual void getCells(int lineno, int colno, int count, Character res[]);
     virtual bool isWrappedLine(int lineno);
 
+    virtual void readLines(int firstLine, int count, LineBlock* block);
+    virtual MemoryUsage memoryUsage() const;
+
     virtual void addCells(const Character a[], int count);
     virtual void addCellsVector(const TextLine& cells);
     virtual void addLine(bool previousWrapped = false);
+    virtual void addLines(const LineBlock& block);
+
+    virtual void flush();
 
     void setMaxNbLines(unsigned int nbLines);
 
+    /**
+     * Returns the number of lines which were dropped from the history
+     * before they were compacted, either because a larger block of lines
+     * than the history can hold was added with addLines() or because
+     * newer lines pushed them out before the next flush().
+     *
+     * While output arrives faster than the history limit allows lines to
+     * be displayed, queued lines are not compacted until flush() is called,
+     * so most lines are dropped this way instead of being compacted first.
+     */
+    qint64 skippedLineCount() const;
+    /** Returns skippedLineCount() and starts counting from zero again. */
+    qint64 takeSkippedLineCount();
+
+    /**
+     * Enables or disables sharing of storage between identical lines.
+     * When enabled, each line which is stored is looked up in a table of
+     * the lines already in the history, and if a line with the same text,
+     * formats and wrap flag exists then it is referenced instead of
+     * storing another copy.  This saves memory when the output contains
+     * many repeated lines, at the cost of hashing each line as it is stored.
+     *
+     * Only lines stored after deduplication is enabled are shared.
+     */
+    void setDeduplicationEnabled(bool enable);
+    /** Returns true if identical lines share their storage. */
+    bool isDeduplicationEnabled() const;
+
+    struct DeduplicationStatistics {
+        /** Number of lines in the history. */
+        int lines;
+        /** Number of distinct stored lines which the lines refer to. */
+        int storedLines;
+        /** Bytes which would be needed to store the shared lines separately. */
+        qint64 savedBytes;
+    };
+    /** Returns statistics about the storage saved by sharing identical lines. */
+    DeduplicationStatistics deduplicationStatistics() const;
+
 private:
+    // a line which has been added to the history but not compacted yet.
+    // the cells are shared with the screen line they came from
+    struct PendingLine {
+        TextLine cells;
+        bool wrapped;
+    };
+
+    // removes the oldest line, compacted or not
+    void removeFirstLine();
+    // compacts all pending lines
+    void storePendingLines();
+    // returns true if the oldest pending line is expected to be dropped
+    // before the next flush(), judging by the output of the last interval
+    bool pendingLinesWillBeDropped() const;
+    // returns a stored line for cells, sharing an existing one if possible
+    CompactHistoryLine* storeLine(const TextLine& cells, bool wrapped);
+    // releases a reference to a stored line, deleting it if it was the last
+    void releaseLine(CompactHistoryLine* line);
+
     bool hasDifferentColors(const TextLine& line) const;
     HistoryArray _lines;
     CompactHistoryBlockList _blockList;
 
+    // lines which come after _lines, waiting for flush()
+    QList<PendingLine> _pendingLines;
+
     unsigned int _maxLineCount;
+
+    // stored lines which can be shared, by hash of their contents
+    bool _deduplicate;
+    QMultiHash<uint, CompactHistoryLine*> _sharedLines;
+    int _storedLineCount;
+    qint64 _savedBytes;
+
+    // lines added since the last flush() and in the interval before it
+    int _linesSinceFlush;
+    int _linesBeforeFlush;
+    qint64 _skippedLineCount;
+
+    // pending lines are compacted when there are more pending lines than this,
+    // to limit the memory used by uncompacted lines between display updates,
+    // unless they are expected to be dropped before the next update anyway
+    static const int MAX_PENDING_LINES = 1024;
+    // pending lines which are expected to be dropped are compacted anyway
+    // when there are more of them than this, so that a large history limit
+    // doesn't let the queue of uncompacted lines grow to that size
+    static const int MAX_DEFERRED_LINES = 8 * MAX_PENDING_LINES;
 };
 
 //////////////////////////////////////////////////////////////////////
@@ -340,6 +551,14 @@ public:
     bool isUnlimited() const {
         return maximumLineCount() == -1;
     }
+
+protected:
+    /**
+     * Adds the lines of @p source to @p destination in batches, or only the
+     * most recent maximumLineCount() lines if the history is limited.
+     * scroll() uses this to keep the lines of a history of another type.
+     */
+    void copyLines(HistoryScroll* source, HistoryScroll* destination) const;
 };
 
 class HistoryTypeNone : public HistoryType
@@ -370,15 +589,22 @@ protected:
 class CompactHistoryType : public HistoryType
 {
 public:
-    explicit CompactHistoryType(unsigned int size);
+    explicit CompactHistoryType(unsigned int size, bool deduplicate = false);
 
     virtual bool isEnabled() const;
     virtual int maximumLineCount() const;
 
+    /**
+     * Returns true if identical lines share their storage.
+     * See CompactHistoryScroll::setDeduplicationEnabled()
+     */
+    bool isDeduplicationEnabled() const;
+
     virtual HistoryScroll* scroll(HistoryScroll *) const;
 
 protected:
     unsigned int _maxLines;
+    bool _deduplicate;
 };
 }
 
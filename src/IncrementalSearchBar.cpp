@@ -40,6 +40,7 @@ IncrementalSearchBar::IncrementalSearchBar(QWidget* aParent)
     : QWidget(aParent)
     , _foundMatch(false)
     , _searchEdit(0)
+    , _matchCountLabel(0)
     , _caseSensitive(0)
     , _regExpression(0)
     , _highlightMatches(0)
@@ -91,6 +92,10 @@ IncrementalSearchBar::IncrementalSearchBar(QWidget* aParent)
     findPrev->setToolTip(i18nc("@info:tooltip", "Find the previous match for the current search phrase"));
     connect(findPrev , SIGNAL(clicked()) , this , SIGNAL(findPreviousClicked()));
 
+    _matchCountLabel = new QLabel(this);
+    _matchCountLabel->setObjectName(QLatin1String("match-count-label"));
+    _matchCountLabel->hide();
+
     QToolButton* optionsButton = new QToolButton(this);
     optionsButton->setObjectName(QLatin1String("find-options-button"));
     optionsButton->setText(i18nc("@action:button Display options menu", "Options"));
@@ -105,6 +110,7 @@ IncrementalSearchBar::IncrementalSearchBar(QWidget* aParent)
     barLayout->addWidget(_searchEdit);
     barLayout->addWidget(findNext);
     barLayout->addWidget(findPrev);
+    barLayout->addWidget(_matchCountLabel);
     barLayout->addWidget(optionsButton);
 
     // Fill the options menu
@@ -181,6 +187,21 @@ void IncrementalSearchBar::setVisible(bool visible)
     }
 }
 
+void IncrementalSearchBar::setMatchCount(int current, int total)
+{
+    if (total < 0 || _searchEdit->text().isEmpty()) {
+        _matchCountLabel->hide();
+        return;
+    }
+
+    if (current > 0)
+        _matchCountLabel->setText(i18nc("@label The current match and the number of matches", "%1 of %2", current, total));
+    else
+        _matchCountLabel->setText(i18ncp("@label", "%1 match", "%1 matches", total));
+
+    _matchCountLabel->show();
+}
+
 void IncrementalSearchBar::setFoundMatch(bool match)
 {
     if (!match && !_searchEdit->text().isEmpty()) {
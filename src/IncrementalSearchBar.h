@@ -90,6 +90,14 @@ public:
      */
     void setFoundMatch(bool match);
 
+    /**
+     * Shows the number of matches for the current search text next to the
+     * buttons, as "current of total" or just the total if @p current is 0.
+     * The count is hidden if @p total is negative, which means that the
+     * matches have not been counted.
+     */
+    void setMatchCount(int current, int total);
+
     /** Returns the current search text */
     QString searchText();
 
@@ -137,6 +145,7 @@ private:
     bool _foundMatch;
 
     KLineEdit* _searchEdit;
+    QLabel* _matchCountLabel;
     QAction* _caseSensitive;
     QAction* _regExpression;
     QAction* _highlightMatches;
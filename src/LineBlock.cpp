@@ -0,0 +1,65 @@
+/*
+    Copyright 2013 by Konsole Developers <konsole-devel@kde.org>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+    02110-1301  USA.
+*/
+
+// Own
+#include "LineBlock.h"
+
+using namespace Konsole;
+
+LineBlock::LineBlock()
+{
+    _lineStarts << 0;
+}
+
+Character* LineBlock::appendLine(int count, LineProperty properties)
+{
+    const int start = _characters.count();
+    _characters.resize(start + count);
+    _lineStarts << start + count;
+    _lineProperties << properties;
+
+    return _characters.data() + start;
+}
+
+void LineBlock::clear()
+{
+    _characters.clear();
+    _lineStarts.resize(1);
+    _lineProperties.clear();
+}
+
+int LineBlock::lineCount() const
+{
+    return _lineProperties.count();
+}
+
+const Character* LineBlock::characters(int line) const
+{
+    return _characters.constData() + _lineStarts[line];
+}
+
+int LineBlock::lineLength(int line) const
+{
+    return _lineStarts[line + 1] - _lineStarts[line];
+}
+
+LineProperty LineBlock::lineProperties(int line) const
+{
+    return _lineProperties[line];
+}
@@ -0,0 +1,77 @@
+/*
+    Copyright 2013 by Konsole Developers <konsole-devel@kde.org>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+    02110-1301  USA.
+*/
+
+#ifndef LINEBLOCK_H
+#define LINEBLOCK_H
+
+// Qt
+#include <QtCore/QVector>
+
+// Konsole
+#include "Character.h"
+#include "konsole_export.h"
+
+namespace Konsole
+{
+/**
+ * A range of lines of terminal output, with the properties of each line.
+ *
+ * Lines of a screen's output, including its history, are copied into a
+ * block with Screen::copyLines() on the thread which owns the screen, after
+ * which the copy can be read from any thread.
+ *
+ * Blocks are also used to add and read lines in batches with
+ * HistoryScroll::addLines() and HistoryScroll::readLines().
+ */
+class KONSOLEPRIVATE_EXPORT LineBlock
+{
+public:
+    /** Constructs an empty block */
+    LineBlock();
+
+    /**
+     * Appends a line of @p count characters with the given @p properties to
+     * the block and returns the space for its characters, which the caller
+     * fills in.  The returned pointer is only valid until the next line is
+     * appended.
+     */
+    Character* appendLine(int count, LineProperty properties);
+
+    /** Removes all lines from the block */
+    void clear();
+
+    /** Returns the number of lines in the block */
+    int lineCount() const;
+    /** Returns the characters of @p line, counting from the first line in the block */
+    const Character* characters(int line) const;
+    /** Returns the number of characters on @p line */
+    int lineLength(int line) const;
+    /** Returns the properties of @p line, such as LINE_WRAPPED */
+    LineProperty lineProperties(int line) const;
+
+private:
+    QVector<Character> _characters;
+    // offset of each line in _characters, followed by the total number
+    // of characters
+    QVector<int> _lineStarts;
+    QVector<LineProperty> _lineProperties;
+};
+}
+
+#endif // LINEBLOCK_H
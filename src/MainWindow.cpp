@@ -89,6 +89,7 @@ MainWindow::MainWindow()
 
     // create view manager
     _viewManager = new ViewManager(this, actionCollection());
+    _viewManager->setupActions();
     connect(_viewManager, SIGNAL(empty()), this, SLOT(close()));
     connect(_viewManager, SIGNAL(activeViewChanged(SessionController*)), this,
             SLOT(activeViewChanged(SessionController*)));
@@ -0,0 +1,202 @@
+/*
+    Copyright 2013 by Konsole Developers <konsole-devel@kde.org>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+    02110-1301  USA.
+*/
+
+// Own
+#include "ParallelLineDecoder.h"
+
+// Qt
+#include <QtCore/QMutex>
+#include <QtCore/QRunnable>
+#include <QtCore/QScopedPointer>
+#include <QtCore/QSharedPointer>
+#include <QtCore/QTextStream>
+#include <QtCore/QThread>
+#include <QtCore/QThreadPool>
+#include <QtCore/QWaitCondition>
+
+// Konsole
+#include "TerminalCharacterDecoder.h"
+
+using namespace Konsole;
+
+namespace Konsole
+{
+// The chunks of a block being decoded by a ParallelLineDecoder.  The jobs on
+// the thread pool keep it alive if they start after the decoding has finished.
+class ParallelDecodeState
+{
+public:
+    struct Chunk {
+        QString text;
+        QVector<int> linePositions;
+    };
+
+    ParallelDecodeState(const LineBlock* block , const TerminalCharacterDecoder* decoder ,
+                        int chunkLines , int chunkCount)
+        : block(block)
+        , decoder(decoder)
+        , chunkLines(chunkLines)
+        , chunks(chunkCount)
+        , remainingChunks(chunkCount) {
+        chunkData = chunks.data();
+    }
+
+    // decodes chunks until there are none left to start
+    void decodeChunks() {
+        forever {
+            const int index = nextChunk.fetchAndAddOrdered(1);
+            if (index >= chunks.count())
+                return;
+
+            // each chunk is only ever written by the thread which took it
+            decodeChunk(index, chunkData[index]);
+
+            QMutexLocker locker(&mutex);
+            if (--remainingChunks == 0)
+                finished.wakeAll();
+        }
+    }
+
+    void waitForChunks() {
+        QMutexLocker locker(&mutex);
+        while (remainingChunks > 0)
+            finished.wait(&mutex);
+    }
+
+    const LineBlock* block;
+    const TerminalCharacterDecoder* decoder;
+    const int chunkLines;
+    QVector<Chunk> chunks;
+    Chunk* chunkData;
+
+    QAtomicInt nextChunk;
+    QMutex mutex;
+    QWaitCondition finished;
+    // protected by mutex
+    int remainingChunks;
+
+private:
+    void decodeChunk(int index , Chunk& chunk) {
+        const int firstLine = index * chunkLines;
+        const int endLine = qMin(firstLine + chunkLines, block->lineCount());
+
+        QScopedPointer<TerminalCharacterDecoder> chunkDecoder(decoder->clone());
+        QTextStream stream(&chunk.text);
+        chunkDecoder->begin(&stream);
+
+        QVector<Character> buffer;
+        chunk.linePositions.reserve(endLine - firstLine);
+        for (int line = firstLine; line < endLine; line++) {
+            const int length = block->lineLength(line);
+            const LineProperty properties = block->lineProperties(line);
+
+            buffer.resize(length + 1);
+            qCopy(block->characters(line), block->characters(line) + length, buffer.data());
+
+            int count = length;
+            if (!(properties & LINE_WRAPPED))
+                buffer[count++] = Character('\n');
+
+            chunk.linePositions << chunk.text.length();
+            chunkDecoder->decodeLine(buffer.constData(), count, properties);
+        }
+
+        chunkDecoder->end();
+    }
+};
+
+// Decodes chunks of a block on the thread pool
+class ParallelDecodeJob : public QRunnable
+{
+public:
+    explicit ParallelDecodeJob(QSharedPointer<ParallelDecodeState> state)
+        : _state(state) {
+    }
+
+    virtual void run() {
+        _state->decodeChunks();
+    }
+
+private:
+    QSharedPointer<ParallelDecodeState> _state;
+};
+}
+
+ParallelLineDecoder::ParallelLineDecoder(const TerminalCharacterDecoder* decoder)
+    : _decoder(decoder)
+    , _chunkLines(500)
+{
+    Q_ASSERT(decoder);
+}
+
+void ParallelLineDecoder::setChunkLines(int lines)
+{
+    _chunkLines = qMax(1, lines);
+}
+
+int ParallelLineDecoder::chunkLines() const
+{
+    return _chunkLines;
+}
+
+QString ParallelLineDecoder::decode(const LineBlock& block)
+{
+    _linePositions.clear();
+
+    const int lineCount = block.lineCount();
+    const int chunkCount = (lineCount + _chunkLines - 1) / _chunkLines;
+    if (chunkCount == 0)
+        return QString();
+
+    QSharedPointer<ParallelDecodeState> state(new ParallelDecodeState(&block, _decoder,
+            _chunkLines, chunkCount));
+
+    // the calling thread decodes chunks as well, rather than sitting idle
+    // while the jobs wait for a free thread in the pool
+    const int jobCount = qMin(chunkCount, QThread::idealThreadCount()) - 1;
+    for (int i = 0; i < jobCount; i++)
+        QThreadPool::globalInstance()->start(new ParallelDecodeJob(state));
+
+    state->decodeChunks();
+    state->waitForChunks();
+
+    int length = 0;
+    foreach(const ParallelDecodeState::Chunk& chunk, state->chunks) {
+        length += chunk.text.length();
+    }
+
+    QString text;
+    text.reserve(length);
+    _linePositions.reserve(lineCount);
+
+    foreach(const ParallelDecodeState::Chunk& chunk, state->chunks) {
+        const int offset = text.length();
+        foreach(int position, chunk.linePositions) {
+            _linePositions << offset + position;
+        }
+        text.append(chunk.text);
+    }
+
+    return text;
+}
+
+QVector<int> ParallelLineDecoder::linePositions() const
+{
+    return _linePositions;
+}
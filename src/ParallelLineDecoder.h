@@ -0,0 +1,80 @@
+/*
+    Copyright 2013 by Konsole Developers <konsole-devel@kde.org>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+    02110-1301  USA.
+*/
+
+#ifndef PARALLELLINEDECODER_H
+#define PARALLELLINEDECODER_H
+
+// Qt
+#include <QtCore/QString>
+#include <QtCore/QVector>
+
+// Konsole
+#include "LineBlock.h"
+#include "konsole_export.h"
+
+namespace Konsole
+{
+class TerminalCharacterDecoder;
+
+/**
+ * Decodes the lines of a LineBlock into text, using all of the processors.
+ *
+ * The lines are split into chunks of chunkLines() lines, which are decoded at
+ * the same time by QThreadPool::globalInstance() and the calling thread, each
+ * with its own copy of the decoder and its own output buffer.  The output of
+ * the chunks is then joined in order.
+ *
+ * Each line is followed by a new line unless it is wrapped onto the next one,
+ * so the text is the same as when every line is decoded in turn by a single
+ * decoder.
+ */
+class KONSOLEPRIVATE_EXPORT ParallelLineDecoder
+{
+public:
+    /**
+     * Constructs a decoder which decodes lines with copies of @p decoder,
+     * made with TerminalCharacterDecoder::clone()
+     */
+    explicit ParallelLineDecoder(const TerminalCharacterDecoder* decoder);
+
+    /** Sets the number of lines in each chunk.  Defaults to 500. */
+    void setChunkLines(int lines);
+    /** Returns the number of lines in each chunk.  See setChunkLines() */
+    int chunkLines() const;
+
+    /**
+     * Decodes the lines of @p block and returns the text.  This returns once
+     * every chunk has been decoded.
+     */
+    QString decode(const LineBlock& block);
+
+    /**
+     * Returns the position in the text returned by the last call to decode()
+     * at which each line of the block starts.
+     */
+    QVector<int> linePositions() const;
+
+private:
+    const TerminalCharacterDecoder* _decoder;
+    int _chunkLines;
+    QVector<int> _linePositions;
+};
+}
+
+#endif // PARALLELLINEDECODER_H
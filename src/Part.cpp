@@ -23,6 +23,7 @@
 // Qt
 #include <QtCore/QStringList>
 #include <QtCore/QDir>
+#include <QtCore/QTimer>
 #include <QtGui/QKeyEvent>
 
 // KDE
@@ -53,15 +54,13 @@ Part::Part(QWidget* parentWidget , QObject* parent, const QVariantList&)
     , _viewManager(0)
     , _pluggedController(0)
     , _manageProfilesAction(0)
+    , _guiInitialized(false)
 {
     // make sure the konsole catalog is loaded
     KGlobal::locale()->insertCatalog("konsole");
     // make sure the libkonq catalog is loaded( needed for drag & drop )
     KGlobal::locale()->insertCatalog("libkonq");
 
-    // setup global actions
-    createGlobalActions();
-
     // create view widget
     _viewManager = new ViewManager(this, actionCollection());
     _viewManager->setNavigationMethod(ViewManager::NoNavigation);
@@ -74,16 +73,17 @@ Part::Part(QWidget* parentWidget , QObject* parent, const QVariantList&)
     _viewManager->widget()->setParent(parentWidget);
 
     setWidget(_viewManager->widget());
-    actionCollection()->addAssociatedWidget(_viewManager->widget());
-    foreach(QAction* action, actionCollection()->actions()) {
-        action->setShortcutContext(Qt::WidgetWithChildrenShortcut);
-    }
 
     // Enable translucency support.
     _viewManager->widget()->setAttribute(Qt::WA_TranslucentBackground, true);
 
     // create basic session
     createSession();
+
+    // only what is needed to show the terminal is done synchronously,
+    // creating the actions and plugging them into the host's GUI waits
+    // until the host has returned to the event loop
+    QTimer::singleShot(0, this, SLOT(delayedInit()));
 }
 
 Part::~Part()
@@ -97,6 +97,37 @@ void Part::createGlobalActions()
     connect(_manageProfilesAction, SIGNAL(triggered()), this, SLOT(showManageProfilesDialog()));
 }
 
+void Part::delayedInit()
+{
+    if (_guiInitialized)
+        return;
+
+    _guiInitialized = true;
+
+    _viewManager->setupActions();
+    createGlobalActions();
+
+    actionCollection()->addAssociatedWidget(_viewManager->widget());
+    foreach(QAction* action, actionCollection()->actions()) {
+        action->setShortcutContext(Qt::WidgetWithChildrenShortcut);
+    }
+
+    SessionController* controller = _viewManager->activeViewController();
+    if (controller)
+        plugController(controller);
+}
+
+void Part::plugController(SessionController* controller)
+{
+    insertChildClient(controller);
+    setupActionsForSession(controller);
+
+    // insertChildClient() does not merge the controller into a GUI which
+    // the host has already built from this part
+    if (factory())
+        factory()->addClient(controller);
+}
+
 void Part::setupActionsForSession(SessionController* controller)
 {
     KActionCollection* collection = controller->actionCollection();
@@ -237,16 +268,21 @@ void Part::activeViewChanged(SessionController* controller)
 
     // remove existing controller
     if (_pluggedController) {
-        removeChildClient(_pluggedController);
+        if (_guiInitialized) {
+            if (_pluggedController->factory())
+                _pluggedController->factory()->removeClient(_pluggedController);
+            removeChildClient(_pluggedController);
+        }
         disconnect(_pluggedController, SIGNAL(titleChanged(ViewProperties*)), this,
                    SLOT(activeViewTitleChanged(ViewProperties*)));
         disconnect(_pluggedController, SIGNAL(currentDirectoryChanged(QString)), this,
                    SIGNAL(currentDirectoryChanged(QString)));
     }
 
-    // insert new controller
-    insertChildClient(controller);
-    setupActionsForSession(controller);
+    // insert new controller, delayedInit() does this for the first
+    // controller if it is not done yet
+    if (_guiInitialized)
+        plugController(controller);
 
     connect(controller, SIGNAL(titleChanged(ViewProperties*)), this,
             SLOT(activeViewTitleChanged(ViewProperties*)));
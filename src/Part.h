@@ -202,16 +202,19 @@ private slots:
     void newTab();
     void overrideTerminalShortcut(QKeyEvent*, bool& override);
     void sessionStateChanged(int state);
+    void delayedInit();
 
 private:
     Session* activeSession() const;
     void createGlobalActions();
     void setupActionsForSession(SessionController*);
+    void plugController(SessionController* controller);
 
 private:
     ViewManager* _viewManager;
     SessionController* _pluggedController;
     QAction* _manageProfilesAction;
+    bool _guiInitialized; // set to true once delayedInit() has run
 };
 }
 
@@ -79,6 +79,7 @@ const Profile::PropertyInfo Profile::DefaultPropertyNames[] = {
     , { AntiAliasFonts, "AntiAliasFonts" , APPEARANCE_GROUP , QVariant::Bool }
     , { BoldIntense, "BoldIntense", APPEARANCE_GROUP, QVariant::Bool }
     , { LineSpacing , "LineSpacing" , APPEARANCE_GROUP , QVariant::Int }
+    , { ParallelRendering , "ParallelRendering" , APPEARANCE_GROUP , QVariant::Bool }
 
     // Keyboard
     , { KeyBindings , "KeyBindings" , KEYBOARD_GROUP , QVariant::String }
@@ -86,6 +87,7 @@ const Profile::PropertyInfo Profile::DefaultPropertyNames[] = {
     // Scrolling
     , { HistoryMode , "HistoryMode" , SCROLLING_GROUP , QVariant::Int }
     , { HistorySize , "HistorySize" , SCROLLING_GROUP , QVariant::Int }
+    , { HistoryDeduplication , "HistoryDeduplication" , SCROLLING_GROUP , QVariant::Bool }
     , { ScrollBarPosition , "ScrollBarPosition" , SCROLLING_GROUP , QVariant::Int }
 
     // Terminal Features
@@ -94,6 +96,8 @@ const Profile::PropertyInfo Profile::DefaultPropertyNames[] = {
     , { BidiRenderingEnabled , "BidiRenderingEnabled" , TERMINAL_GROUP , QVariant::Bool }
     , { BlinkingCursorEnabled , "BlinkingCursorEnabled" , TERMINAL_GROUP , QVariant::Bool }
     , { BellMode , "BellMode" , TERMINAL_GROUP , QVariant::Int }
+    , { ClipboardPayloadLimit , "ClipboardPayloadLimit" , TERMINAL_GROUP , QVariant::Int }
+    , { DiscardBinaryOutput , "DiscardBinaryOutput" , TERMINAL_GROUP , QVariant::Bool }
 
     // Cursor
     , { UseCustomCursorColor , "UseCustomCursorColor" , CURSOR_GROUP , QVariant::Bool}
@@ -168,6 +172,7 @@ FallbackProfile::FallbackProfile()
 
     setProperty(HistoryMode, Enum::FixedSizeHistory);
     setProperty(HistorySize, 1000);
+    setProperty(HistoryDeduplication, false);
     setProperty(ScrollBarPosition, Enum::ScrollBarRight);
 
     setProperty(FlowControlEnabled, true);
@@ -189,10 +194,13 @@ FallbackProfile::FallbackProfile()
     setProperty(UseCustomCursorColor, false);
     setProperty(CustomCursorColor, Qt::black);
     setProperty(BellMode, Enum::NotifyBell);
+    setProperty(ClipboardPayloadLimit, 1024 * 1024);
+    setProperty(DiscardBinaryOutput, true);
 
     setProperty(DefaultEncoding, QString(QTextCodec::codecForLocale()->name()));
     setProperty(AntiAliasFonts, true);
     setProperty(BoldIntense, true);
+    setProperty(ParallelRendering, false);
 
     // default taken from KDE 3
     setProperty(WordCharacters, ":@-./_~?&=%+#");
@@ -249,7 +249,24 @@ public:
         /** (bool) If true, mouse wheel scroll with Ctrl key pressed
          * increases/decreases the terminal font size.
          */
-        MouseWheelZoomEnabled
+        MouseWheelZoomEnabled,
+        /** (int) The maximum size in bytes of text which programs may
+         * copy to the clipboard using the OSC 52 escape sequence.
+         * 0 disables remote clipboard access.
+         */
+        ClipboardPayloadLimit,
+        /** (bool) If true, identical lines in a fixed size history share
+         * their storage.  Saves memory when the output repeats lines often.
+         */
+        HistoryDeduplication,
+        /** (bool) If true, large repaints of the terminal display are
+         * drawn by several threads at once.
+         */
+        ParallelRendering,
+        /** (bool) If true, output which looks like binary data is
+         * discarded until the user chooses to resume it.
+         */
+        DiscardBinaryOutput
     };
 
     /**
@@ -69,6 +69,7 @@ static void sortByNameProfileList(QList<Profile::Ptr>& list)
 ProfileManager::ProfileManager()
     : _loadedAllProfiles(false)
     , _loadedFavorites(false)
+    , _loadedShortcuts(false)
 {
     //load fallback profile
     _fallbackProfile = Profile::Ptr(new FallbackProfile);
@@ -100,10 +101,9 @@ ProfileManager::ProfileManager()
     Q_ASSERT(_profiles.count() > 0);
     Q_ASSERT(_defaultProfile);
 
-    // get shortcuts and paths of profiles associated with
-    // them - this doesn't load the shortcuts themselves,
-    // that is done on-demand.
-    loadShortcuts();
+    // the shortcut -> profile path mappings are read on first use by
+    // loadShortcuts(), so that hosts of konsolepart which never touch
+    // profile shortcuts don't pay for parsing them at startup.
 }
 
 ProfileManager::~ProfileManager()
@@ -305,6 +305,32 @@ QList<Profile::Ptr> ProfileManager::loadedProfiles() const
     return _profiles.toList();
 }
 
+Profile::Ptr ProfileManager::findProfileByName(const QString& name)
+{
+    foreach(const Profile::Ptr& profile, _profiles) {
+        if (profile->name() == name)
+            return profile;
+    }
+
+    // profiles are usually stored in a file named after the profile
+    if (!name.isEmpty()) {
+        Profile::Ptr profile = loadProfile(name);
+        if (profile && profile->name() == name)
+            return profile;
+    }
+
+    if (!_loadedAllProfiles) {
+        loadAllProfiles();
+
+        foreach(const Profile::Ptr& profile, _profiles) {
+            if (profile->name() == name)
+                return profile;
+        }
+    }
+
+    return Profile::Ptr();
+}
+
 Profile::Ptr ProfileManager::defaultProfile() const
 {
     return _defaultProfile;
@@ -454,6 +480,11 @@ void ProfileManager::setFavorite(Profile::Ptr profile , bool favorite)
 }
 void ProfileManager::loadShortcuts()
 {
+    if (_loadedShortcuts)
+        return;
+
+    _loadedShortcuts = true;
+
     KSharedConfigPtr appConfig = KGlobal::config();
     KConfigGroup shortcutGroup = appConfig->group("Profile Shortcuts");
 
@@ -480,6 +511,11 @@ void ProfileManager::loadShortcuts()
 }
 void ProfileManager::saveShortcuts()
 {
+    // nothing can have changed if the shortcuts were never loaded, and
+    // rewriting the group from the empty map would wipe it
+    if (!_loadedShortcuts)
+        return;
+
     KSharedConfigPtr appConfig = KGlobal::config();
     KConfigGroup shortcutGroup = appConfig->group("Profile Shortcuts");
     shortcutGroup.deleteGroup();
@@ -599,11 +635,15 @@ void ProfileManager::saveFavorites()
 
 QList<QKeySequence> ProfileManager::shortcuts()
 {
+    loadShortcuts();
+
     return _shortcuts.keys();
 }
 
 Profile::Ptr ProfileManager::findByShortcut(const QKeySequence& shortcut)
 {
+    loadShortcuts();
+
     Q_ASSERT(_shortcuts.contains(shortcut));
 
     if (!_shortcuts[shortcut].profileKey) {
@@ -619,8 +659,10 @@ Profile::Ptr ProfileManager::findByShortcut(const QKeySequence& shortcut)
 }
 
 
-QKeySequence ProfileManager::shortcut(Profile::Ptr profile) const
+QKeySequence ProfileManager::shortcut(Profile::Ptr profile)
 {
+    loadShortcuts();
+
     QMapIterator<QKeySequence, ShortcutData> iter(_shortcuts);
     while (iter.hasNext()) {
         iter.next();
@@ -117,6 +117,16 @@ public:
      */
     QStringList availableProfileNames() const;
 
+    /**
+     * Returns the profile called @p name, or a null pointer if there is no
+     * such profile.
+     *
+     * Already loaded profiles and the profile stored in the file named after
+     * @p name are searched first, all profiles are only loaded if neither
+     * of them matches.
+     */
+    Profile::Ptr findProfileByName(const QString& name);
+
     /**
      * Registers a new type of session.
      * The favorite status of the session ( as returned by isFavorite() ) is set to false by default.
@@ -193,7 +203,7 @@ public:
     void setShortcut(Profile::Ptr profile , const QKeySequence& shortcut);
 
     /** Returns the shortcut associated with a particular profile. */
-    QKeySequence shortcut(Profile::Ptr profile) const;
+    QKeySequence shortcut(Profile::Ptr profile);
 
     /**
      * Returns the list of shortcut key sequences which
@@ -247,7 +257,7 @@ private slots:
 
 private:
     // loads the mappings between shortcut key sequences and
-    // profile paths
+    // profile paths, the first time it is called
     void loadShortcuts();
     // saves the mappings between shortcut key sequences and
     // profile paths
@@ -277,6 +287,7 @@ private:
 
     bool _loadedAllProfiles; // set to true after loadAllProfiles has been called
     bool _loadedFavorites; // set to true after loadFavorites has been called
+    bool _loadedShortcuts; // set to true after loadShortcuts has been called
 
     struct ShortcutData {
         Profile::Ptr profileKey;
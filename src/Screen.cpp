@@ -29,6 +29,7 @@
 // Konsole
 #include "konsole_wcwidth.h"
 #include "TerminalCharacterDecoder.h"
+#include "LineBlock.h"
 #include "History.h"
 #include "ExtendedCharTable.h"
 
@@ -38,6 +39,10 @@ using namespace Konsole;
 //FIXME: see if we can get this from terminfo.
 const bool BS_CLEARS = false;
 
+//Maximum number of code points combined into one cell, the base character
+//included.  Further combining marks are dropped.
+const int MAX_COMBINED_CHARS = 32;
+
 //Macro to convert x,y position on screen to position within an image.
 //
 //Originally the image was stored as one large contiguous block of
@@ -90,7 +95,7 @@ Screen::Screen(int lines, int columns):
 Screen::~Screen()
 {
     delete[] _screenLines;
-    delete _history;
+    HistoryScroll::deleteInBackground(_history);
 }
 
 void Screen::cursorUp(int n)
@@ -416,11 +421,21 @@ void Screen::copyFromHistory(Character* dest, int startLine, int count) const
     }
 }
 
-void Screen::copyFromScreen(Character* dest , int startLine , int count) const
+void Screen::copyFromScreen(Character* dest , int startLine , int count, LineReference* references) const
 {
     Q_ASSERT(startLine >= 0 && count > 0 && startLine + count <= _lines);
 
     for (int line = startLine; line < (startLine + count) ; line++) {
+        if (references) {
+            // a line which still shares its characters with the one copied
+            // before is unchanged
+            LineReference& previous = references[line - startLine];
+            const LineReference reference = lineReference(line + _history->getLines());
+            if (reference.isSameLine(previous))
+                continue;
+            previous = reference;
+        }
+
         int srcLineStartIndex  = line * _columns;
         int destLineStartIndex = (line - startLine) * _columns;
 
@@ -437,7 +452,29 @@ void Screen::copyFromScreen(Character* dest , int startLine , int count) const
     }
 }
 
-void Screen::getImage(Character* dest, int size, int startLine, int endLine) const
+LineReference Screen::lineReference(int line) const
+{
+    LineReference reference;
+
+    const int screenLine = line - _history->getLines();
+    if (screenLine < 0 || screenLine >= _lines)
+        return reference;
+
+    // the cursor and reverse screen mode change the characters in getImage()
+    if (screenLine == _cuY || getMode(MODE_Screen))
+        return reference;
+
+    // and so does the selection
+    if (_selBegin != -1 && line >= _selTopLeft / _columns && line <= _selBottomRight / _columns)
+        return reference;
+
+    reference.characters = _screenLines[screenLine];
+    reference.valid = true;
+    return reference;
+}
+
+void Screen::getImage(Character* dest, int size, int startLine, int endLine,
+                      QVector<LineReference>* lineReferences) const
 {
     Q_ASSERT(startLine >= 0);
     Q_ASSERT(endLine >= startLine && endLine < _history->getLines() + _lines);
@@ -450,6 +487,16 @@ void Screen::getImage(Character* dest, int size, int startLine, int endLine) con
     const int linesInHistoryBuffer = qBound(0, _history->getLines() - startLine, mergedLines);
     const int linesInScreenBuffer = mergedLines - linesInHistoryBuffer;
 
+    LineReference* references = 0;
+    if (lineReferences) {
+        Q_ASSERT(lineReferences->count() >= mergedLines);
+        references = lineReferences->data();
+
+        // lines from the history are always copied
+        for (int i = 0; i < linesInHistoryBuffer; i++)
+            references[i] = LineReference();
+    }
+
     // copy _lines from history buffer
     if (linesInHistoryBuffer > 0)
         copyFromHistory(dest, startLine, linesInHistoryBuffer);
@@ -458,7 +505,8 @@ void Screen::getImage(Character* dest, int size, int startLine, int endLine) con
     if (linesInScreenBuffer > 0)
         copyFromScreen(dest + linesInHistoryBuffer * _columns,
                        startLine + linesInHistoryBuffer - _history->getLines(),
-                       linesInScreenBuffer);
+                       linesInScreenBuffer,
+                       references ? references + linesInHistoryBuffer : 0);
 
     // invert display when in screen mode
     if (getMode(MODE_Screen)) {
@@ -468,8 +516,13 @@ void Screen::getImage(Character* dest, int size, int startLine, int endLine) con
 
     // mark the character at the current cursor position
     int cursorIndex = loc(_cuX, _cuY + linesInHistoryBuffer);
-    if (getMode(MODE_Cursor) && cursorIndex < _columns * mergedLines)
+    if (getMode(MODE_Cursor) && cursorIndex < _columns * mergedLines) {
         dest[cursorIndex].rendition |= RE_CURSOR;
+
+        // the marked line has to be copied again once the cursor moves
+        if (references)
+            references[cursorIndex / _columns] = LineReference();
+    }
 }
 
 QVector<LineProperty> Screen::getLineProperties(int startLine , int endLine) const
@@ -662,14 +715,15 @@ void Screen::displayCharacter(unsigned short c)
             ushort extendedCharLength;
             const ushort* oldChars = ExtendedCharTable::instance.lookupExtendedChar(currentChar.character, extendedCharLength);
             Q_ASSERT(oldChars);
-            if (oldChars) {
+            // each mark copies the whole sequence and adds it to the extended
+            // character table, so unlimited sequences cost quadratic time and
+            // fill the table.  ignore marks beyond a sensible number per cell.
+            if (oldChars && extendedCharLength < MAX_COMBINED_CHARS) {
                 Q_ASSERT(extendedCharLength > 1);
-                Q_ASSERT(extendedCharLength < 65535);
-                ushort* chars = new ushort[extendedCharLength + 1];
+                ushort chars[MAX_COMBINED_CHARS];
                 memcpy(chars, oldChars, sizeof(ushort) * extendedCharLength);
                 chars[extendedCharLength] = c;
                 currentChar.character = ExtendedCharTable::instance.createExtendedChar(chars, extendedCharLength + 1);
-                delete[] chars;
             }
         }
         return;
@@ -1278,6 +1332,24 @@ void Screen::writeLinesToStream(TerminalCharacterDecoder* decoder, int fromLine,
     writeToStream(decoder, loc(0, fromLine), loc(_columns - 1, toLine));
 }
 
+void Screen::copyLines(LineBlock* block, int fromLine, int toLine) const
+{
+    Q_ASSERT(fromLine >= 0 && toLine < _history->getLines() + _lines);
+
+    const int historyLines = _history->getLines();
+    if (fromLine < historyLines)
+        _history->readLines(fromLine, qMin(toLine + 1, historyLines) - fromLine, block);
+
+    for (int line = qMax(fromLine, historyLines); line <= toLine; line++) {
+        const int screenLine = line - historyLines;
+        const ImageLine& image = _screenLines[screenLine];
+        const int length = qMin(image.count(), _columns);
+
+        Character* characters = block->appendLine(length, _lineProperties[screenLine]);
+        qCopy(image.constBegin(), image.constBegin() + length, characters);
+    }
+}
+
 void Screen::addHistLine()
 {
     // add line to history buffer
@@ -1336,6 +1408,17 @@ int Screen::getHistLines() const
     return _history->getLines();
 }
 
+void Screen::flushHistory()
+{
+    _history->flush();
+}
+
+qint64 Screen::takeSkippedHistoryLines()
+{
+    CompactHistoryScroll* compact = dynamic_cast<CompactHistoryScroll*>(_history);
+    return compact ? compact->takeSkippedLineCount() : 0;
+}
+
 void Screen::setScroll(const HistoryType& t , bool copyPreviousScroll)
 {
     clearSelection();
@@ -1343,9 +1426,11 @@ void Screen::setScroll(const HistoryType& t , bool copyPreviousScroll)
     if (copyPreviousScroll) {
         _history = t.scroll(_history);
     } else {
+        // the old history is released on another thread, so that clearing
+        // a large history takes effect immediately
         HistoryScroll* oldScroll = _history;
         _history = t.scroll(0);
-        delete oldScroll;
+        HistoryScroll::deleteInBackground(oldScroll);
     }
 }
 
@@ -45,9 +45,32 @@ namespace Konsole
 {
 class TerminalCharacterDecoder;
 class TerminalDisplay;
+class LineBlock;
 class HistoryType;
 class HistoryScroll;
 
+/**
+ * A reference to the characters of a line of the screen, which shares them
+ * with the screen.  The screen copies a shared line before changing it, so
+ * the characters of a reference never change.  See Screen::lineReference()
+ */
+struct LineReference {
+    LineReference() : valid(false) {}
+
+    /**
+     * Returns true if both references are valid and share their characters,
+     * in which case the lines are the same without comparing the characters.
+     */
+    bool isSameLine(const LineReference& other) const {
+        return valid && other.valid && characters.constData() == other.characters.constData();
+    }
+
+    /** The characters of the line */
+    QVector<Character> characters;
+    /** False if the line could not be shared */
+    bool valid;
+};
+
 /**
     \brief An image of characters with associated attributes.
 
@@ -367,8 +390,24 @@ public:
      * @param size Size of @p dest in Characters
      * @param startLine Index of first line to copy
      * @param endLine Index of last line to copy
+     * @param lineReferences If not null, holds a reference to each line copied
+     * into @p dest by the previous call with the same buffer.  Lines whose
+     * reference is the same as before are already in @p dest and are not
+     * copied again.  The references are updated for the next call.
+     */
+    void getImage(Character* dest , int size , int startLine , int endLine,
+                  QVector<LineReference>* lineReferences = 0) const;
+
+    /**
+     * Returns a reference to the characters of @p line, counting from the
+     * start of the history, which shares them with the screen.
+     *
+     * The reference is not valid if getImage() would change the characters of
+     * the line on their way to the display: lines in the history, the line
+     * with the cursor, lines with selected text, and all lines while the
+     * screen is shown in reverse.
      */
-    void getImage(Character* dest , int size , int startLine , int endLine) const;
+    LineReference lineReference(int line) const;
 
     /**
      * Returns the additional attributes associated with lines in the image.
@@ -388,6 +427,19 @@ public:
     }
     /** Return the number of lines in the history buffer. */
     int getHistLines() const;
+    /**
+     * Finishes storing the lines which have been added to the history
+     * since the last call.  Lines added while output is processed are
+     * queued cheaply, this is called at display updates to compact them
+     * in a batch.
+     */
+    void flushHistory();
+    /**
+     * Returns the number of lines which were dropped from a compact
+     * history without being compacted since the last call, see
+     * CompactHistoryScroll::skippedLineCount()
+     */
+    qint64 takeSkippedHistoryLines();
     /**
      * Sets the type of storage used to keep lines in the history.
      * If @p copyPreviousScroll is true then the contents of the previous
@@ -440,6 +492,9 @@ public:
       */
     bool isSelected(const int column, const int line) const;
 
+    /** Returns true if part of the screen or history is selected. */
+    bool isSelectionValid() const;
+
     /**
      * Convenience method.  Returns the currently selected text.
      * @param preserveLineBreaks Specifies whether new line characters should
@@ -469,6 +524,16 @@ public:
      */
     void writeLinesToStream(TerminalCharacterDecoder* decoder, int fromLine, int toLine) const;
 
+    /**
+     * Appends a copy of part of the output to @p block, which can then be
+     * decoded on other threads with ParallelLineDecoder.
+     *
+     * @param block The block to append the lines to
+     * @param fromLine The first line in the history to copy
+     * @param toLine The last line in the history to copy
+     */
+    void copyLines(LineBlock* block, int fromLine, int toLine) const;
+
     /**
      * Copies the selected characters, set using @see setSelBeginXY and @see setSelExtentXY
      * into a stream.
@@ -630,15 +695,14 @@ private:
 
     void updateEffectiveRendition();
     void reverseRendition(Character& p) const;
-
-    bool isSelectionValid() const;
     // copies text from 'startIndex' to 'endIndex' to a stream
     // startIndex and endIndex are positions generated using the loc(x,y) macro
     void writeToStream(TerminalCharacterDecoder* decoder, int startIndex,
                        int endIndex, bool preserveLineBreaks = true, bool trimTrailingSpaces = false) const;
     // copies 'count' lines from the screen buffer into 'dest',
-    // starting from 'startLine', where 0 is the first line in the screen buffer
-    void copyFromScreen(Character* dest, int startLine, int count) const;
+    // starting from 'startLine', where 0 is the first line in the screen buffer.
+    // lines whose reference is the same as in 'references' are skipped, see getImage()
+    void copyFromScreen(Character* dest, int startLine, int count, LineReference* references = 0) const;
     // copies 'count' lines from the history buffer into 'dest',
     // starting from 'startLine', where 0 is the first line in the history
     void copyFromHistory(Character* dest, int startLine, int count) const;
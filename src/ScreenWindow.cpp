@@ -61,13 +61,18 @@ Character* ScreenWindow::getImage()
         _windowBufferSize = size;
         _windowBuffer = new Character[size];
         _bufferNeedsUpdate = true;
+
+        // nothing from before is in the new buffer
+        _lineReferences.clear();
     }
 
     if (!_bufferNeedsUpdate)
         return _windowBuffer;
 
+    _lineReferences.resize(windowLines());
+
     _screen->getImage(_windowBuffer, size,
-                      currentLine(), endWindowLine());
+                      currentLine(), endWindowLine(), &_lineReferences);
 
     // this window may look beyond the end of the screen, in which
     // case there will be an unused area which needs to be filled
@@ -90,6 +95,9 @@ void ScreenWindow::fillUnusedArea()
     if (unusedLines <= 0)
         return;
 
+    for (int line = qMax(0, windowLines() - unusedLines); line < windowLines(); line++)
+        _lineReferences[line] = LineReference();
+
     int charsToFill = unusedLines * windowColumns();
 
     Screen::fillWithDefaultChar(_windowBuffer + _windowBufferSize - charsToFill, charsToFill);
@@ -107,6 +115,12 @@ int ScreenWindow::endWindowLine() const
     return qMin(currentLine() + windowLines() - 1,
                 lineCount() - 1);
 }
+QVector<LineReference> ScreenWindow::getLineReferences()
+{
+    getImage();
+    return _lineReferences;
+}
+
 QVector<LineProperty> ScreenWindow::getLineProperties()
 {
     QVector<LineProperty> result = _screen->getLineProperties(currentLine(), endWindowLine());
@@ -142,8 +156,21 @@ void ScreenWindow::setSelectionStart(int column , int line , bool columnMode)
 
 void ScreenWindow::setSelectionEnd(int column , int line)
 {
+    int startColumn, startLine, endColumn, endLine;
+    _screen->getSelectionStart(startColumn, startLine);
+    _screen->getSelectionEnd(endColumn, endLine);
+
     _screen->setSelectionEnd(column , line + currentLine());
 
+    // the mouse usually moves several times within the same character while
+    // a selection is dragged, which does not change the selection
+    int newStartColumn, newStartLine, newEndColumn, newEndLine;
+    _screen->getSelectionStart(newStartColumn, newStartLine);
+    _screen->getSelectionEnd(newEndColumn, newEndLine);
+    if (newStartColumn == startColumn && newStartLine == startLine &&
+            newEndColumn == endColumn && newEndLine == endLine)
+        return;
+
     _bufferNeedsUpdate = true;
     emit selectionChanged();
 }
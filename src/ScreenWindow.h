@@ -27,10 +27,10 @@
 
 // Konsole
 #include "Character.h"
+#include "Screen.h"
 
 namespace Konsole
 {
-class Screen;
 
 /**
  * Provides a window onto a section of a terminal screen.  A terminal widget can then render
@@ -80,6 +80,14 @@ public:
      */
     Character* getImage();
 
+    /**
+     * Returns a reference to each line of the image returned by getImage(),
+     * which shares the line's characters with the screen.  Lines whose
+     * references are the same in two images are unchanged, without comparing
+     * their characters.  See Screen::lineReference()
+     */
+    QVector<LineReference> getLineReferences();
+
     /**
      * Returns the line attributes associated with the lines of characters which
      * are currently visible through this window
@@ -258,6 +266,9 @@ private:
     Character* _windowBuffer;
     int _windowBufferSize;
     bool _bufferNeedsUpdate;
+    // references to the lines in _windowBuffer, lines whose reference is
+    // unchanged are not copied from the screen again
+    QVector<LineReference> _lineReferences;
 
     int  _windowLines;
     int  _currentLine; // see scrollTo() , currentLine()
@@ -0,0 +1,212 @@
+/*
+    Copyright 2013 by Konsole Developers <konsole-devel@kde.org>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+    02110-1301  USA.
+*/
+
+// Own
+#include "SearchAllSessionsDialog.h"
+
+// Qt
+#include <QtCore/QTimer>
+#include <QCheckBox>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QLabel>
+#include <QTreeWidget>
+#include <QVBoxLayout>
+
+// KDE
+#include <KLineEdit>
+#include <KLocalizedString>
+
+// Konsole
+#include "Session.h"
+
+using namespace Konsole;
+
+// roles used to store the details of a match in the result list
+static const int DistanceRole = Qt::UserRole;
+static const int LineRole = Qt::UserRole + 1;
+
+SearchAllSessionsDialog::SearchAllSessionsDialog(QWidget* parent)
+    : KDialog(parent)
+{
+    setCaption(i18nc("@title:window", "Search All Tabs"));
+    setButtons(KDialog::Close);
+
+    QWidget* widget = mainWidget();
+
+    _searchEdit = new KLineEdit(widget);
+    _searchEdit->setClearButtonShown(true);
+    _searchEdit->setClickMessage(i18nc("@label:textbox", "Find..."));
+
+    _matchCaseBox = new QCheckBox(i18nc("@option:check", "Match case"), widget);
+    _regExpBox = new QCheckBox(i18nc("@option:check", "Regular expression"), widget);
+
+    _resultList = new QTreeWidget(widget);
+    _resultList->setRootIsDecorated(false);
+    _resultList->setUniformRowHeights(true);
+    _resultList->setHeaderLabels(QStringList() << i18nc("@title:column", "Tab")
+                                 << i18nc("@title:column", "Line")
+                                 << i18nc("@title:column", "Text"));
+    _resultList->header()->setStretchLastSection(true);
+
+    _statusLabel = new QLabel(widget);
+
+    QHBoxLayout* searchLayout = new QHBoxLayout;
+    searchLayout->addWidget(_searchEdit);
+    searchLayout->addWidget(_matchCaseBox);
+    searchLayout->addWidget(_regExpBox);
+
+    QVBoxLayout* layout = new QVBoxLayout(widget);
+    layout->setMargin(0);
+    layout->addLayout(searchLayout);
+    layout->addWidget(_resultList);
+    layout->addWidget(_statusLabel);
+
+    // wait for the user to stop typing before searching
+    _searchTimer = new QTimer(this);
+    _searchTimer->setSingleShot(true);
+    _searchTimer->setInterval(250);
+    connect(_searchTimer, SIGNAL(timeout()), this, SLOT(startSearch()));
+
+    connect(_searchEdit, SIGNAL(textChanged(QString)), this, SLOT(scheduleSearch()));
+    connect(_searchEdit, SIGNAL(returnPressed()), this, SLOT(startSearch()));
+    connect(_matchCaseBox, SIGNAL(toggled(bool)), this, SLOT(startSearch()));
+    connect(_regExpBox, SIGNAL(toggled(bool)), this, SLOT(startSearch()));
+    connect(_resultList, SIGNAL(itemActivated(QTreeWidgetItem*,int)),
+            this, SLOT(itemActivated(QTreeWidgetItem*)));
+
+    _searchEdit->setFocus();
+
+    setInitialSize(QSize(640, 400));
+}
+SearchAllSessionsDialog::~SearchAllSessionsDialog()
+{
+    stopSearch();
+}
+void SearchAllSessionsDialog::setSessions(const QList<Session*>& sessions)
+{
+    _sessions.clear();
+    foreach(Session* session, sessions) {
+        _sessions << session;
+    }
+
+    startSearch();
+}
+void SearchAllSessionsDialog::scheduleSearch()
+{
+    _searchTimer->start();
+}
+void SearchAllSessionsDialog::stopSearch()
+{
+    if (_task) {
+        _task->cancel();
+        delete _task;
+    }
+}
+void SearchAllSessionsDialog::startSearch()
+{
+    _searchTimer->stop();
+    stopSearch();
+
+    _resultList->clear();
+    _itemSessions.clear();
+    _statusLabel->clear();
+
+    const QString text = _searchEdit->text();
+    if (text.isEmpty())
+        return;
+
+    QRegExp regExp(text,
+                   _matchCaseBox->isChecked() ? Qt::CaseSensitive : Qt::CaseInsensitive,
+                   _regExpBox->isChecked() ? QRegExp::RegExp : QRegExp::FixedString);
+    if (!regExp.isValid()) {
+        _statusLabel->setText(i18nc("@info:status", "Invalid regular expression"));
+        return;
+    }
+
+    _task = new SearchAllSessionsTask(this);
+    _task->setRegExp(regExp);
+    foreach(const SessionPtr& session, _sessions) {
+        if (session)
+            _task->addSession(session);
+    }
+
+    connect(_task, SIGNAL(matchesFound(QList<SearchAllSessionsTask::Match>)),
+            this, SLOT(addMatches(QList<SearchAllSessionsTask::Match>)));
+    connect(_task, SIGNAL(progressChanged(int,int)), this, SLOT(updateProgress(int,int)));
+    connect(_task, SIGNAL(completed(bool)), this, SLOT(searchCompleted(bool)));
+
+    _task->execute();
+}
+void SearchAllSessionsDialog::addMatches(const QList<SearchAllSessionsTask::Match>& matches)
+{
+    foreach(const SearchAllSessionsTask::Match& match, matches) {
+        if (!match.session)
+            continue;
+
+        QTreeWidgetItem* item = new QTreeWidgetItem;
+        item->setText(0, match.session->title(Session::DisplayedTitleRole));
+        item->setText(1, QString::number(match.line + 1));
+        item->setText(2, match.text.trimmed());
+        item->setData(0, DistanceRole, match.distance);
+        item->setData(0, LineRole, match.line);
+        _itemSessions.insert(item, match.session);
+
+        // keep the list ordered with the most recent output first, matches
+        // arrive roughly in that order so this is usually an append
+        int low = 0;
+        int high = _resultList->topLevelItemCount();
+        while (low < high) {
+            const int mid = (low + high) / 2;
+            if (_resultList->topLevelItem(mid)->data(0, DistanceRole).toInt() <= match.distance)
+                low = mid + 1;
+            else
+                high = mid;
+        }
+        _resultList->insertTopLevelItem(low, item);
+    }
+}
+void SearchAllSessionsDialog::updateProgress(int linesSearched , int totalLines)
+{
+    _statusLabel->setText(i18nc("@info:status", "Searching... %1 matches in %2 of %3 lines",
+                                _resultList->topLevelItemCount(), linesSearched, totalLines));
+}
+void SearchAllSessionsDialog::searchCompleted(bool success)
+{
+    if (!success)
+        return;
+
+    const int count = _resultList->topLevelItemCount();
+    if (count == 0)
+        _statusLabel->setText(i18nc("@info:status", "No matches found"));
+    else if (count >= _task->maximumMatches())
+        _statusLabel->setText(i18ncp("@info:status", "Showing the first match",
+                                     "Showing the first %1 matches", count));
+    else
+        _statusLabel->setText(i18ncp("@info:status", "1 match", "%1 matches", count));
+}
+void SearchAllSessionsDialog::itemActivated(QTreeWidgetItem* item)
+{
+    SessionPtr session = _itemSessions.value(item);
+    if (session)
+        emit matchActivated(session, item->data(0, LineRole).toInt());
+}
+
+#include "SearchAllSessionsDialog.moc"
+
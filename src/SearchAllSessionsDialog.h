@@ -0,0 +1,97 @@
+/*
+    Copyright 2013 by Konsole Developers <konsole-devel@kde.org>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+    02110-1301  USA.
+*/
+
+#ifndef SEARCHALLSESSIONSDIALOG_H
+#define SEARCHALLSESSIONSDIALOG_H
+
+// Qt
+#include <QtCore/QHash>
+#include <QtCore/QList>
+#include <QtCore/QPointer>
+
+// KDE
+#include <KDialog>
+
+// Konsole
+#include "SessionController.h"
+
+class QCheckBox;
+class QLabel;
+class QTimer;
+class QTreeWidget;
+class QTreeWidgetItem;
+class KLineEdit;
+
+namespace Konsole
+{
+class Session;
+
+/**
+ * A non-modal dialog which searches the output of a list of sessions for
+ * a pattern and lists the matching lines, the most recent first.
+ *
+ * The search is performed by a SearchAllSessionsTask and the list is filled
+ * in while it runs.  Activating a match emits matchActivated() so that the
+ * owner can show the session's view scrolled to the matching line.
+ */
+class SearchAllSessionsDialog : public KDialog
+{
+    Q_OBJECT
+
+public:
+    explicit SearchAllSessionsDialog(QWidget* parent = 0);
+    virtual ~SearchAllSessionsDialog();
+
+    /** Sets the sessions which are searched. */
+    void setSessions(const QList<Session*>& sessions);
+
+signals:
+    /**
+     * Emitted when the user activates a match in the list.
+     *
+     * @param session The session whose output contains the match
+     * @param line The line of the match, suitable for ScreenWindow::scrollTo()
+     */
+    void matchActivated(Session* session , int line);
+
+private slots:
+    void startSearch();
+    void scheduleSearch();
+    void addMatches(const QList<SearchAllSessionsTask::Match>& matches);
+    void updateProgress(int linesSearched , int totalLines);
+    void searchCompleted(bool success);
+    void itemActivated(QTreeWidgetItem* item);
+
+private:
+    void stopSearch();
+
+    KLineEdit* _searchEdit;
+    QCheckBox* _matchCaseBox;
+    QCheckBox* _regExpBox;
+    QTreeWidget* _resultList;
+    QLabel* _statusLabel;
+    QTimer* _searchTimer;
+
+    QList<SessionPtr> _sessions;
+    QPointer<SearchAllSessionsTask> _task;
+    QHash<QTreeWidgetItem*, SessionPtr> _itemSessions;
+};
+}
+
+#endif // SEARCHALLSESSIONSDIALOG_H
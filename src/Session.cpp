@@ -113,6 +113,8 @@ Session::Session(QObject* parent) :
     , _sessionProcessInfo(0)
     , _foregroundProcessInfo(0)
     , _foregroundPid(0)
+    , _dynamicTitlePid(0)
+    , _dynamicTitleValid(false)
     , _zmodemBusy(false)
     , _zmodemProc(0)
     , _zmodemProgress(0)
@@ -127,6 +129,7 @@ Session::Session(QObject* parent) :
 
     //create emulation backend
     _emulation = new Vt102Emulation();
+    _emulation->setUsage(&_usage);
 
     connect(_emulation, SIGNAL(titleChanged(int,QString)),
             this, SLOT(setUserTitle(int,QString)));
@@ -138,12 +141,16 @@ Session::Session(QObject* parent) :
             this, SIGNAL(changeTabTextColorRequest(int)));
     connect(_emulation, SIGNAL(profileChangeCommandReceived(QString)),
             this, SIGNAL(profileChangeCommandReceived(QString)));
+    connect(_emulation, SIGNAL(clipboardChangeRequest(QString,QString)),
+            this, SIGNAL(clipboardChangeRequest(QString,QString)));
     connect(_emulation, SIGNAL(flowControlKeyPressed(bool)),
             this, SLOT(updateFlowControlState(bool)));
+    connect(_emulation, SIGNAL(outputDiscardingChanged(bool)),
+            this, SLOT(updateOutputDiscardingState(bool)));
     connect(_emulation, SIGNAL(primaryScreenInUse(bool)),
             this, SLOT(onPrimaryScreenInUse(bool)));
-    connect(_emulation, SIGNAL(selectionChanged(QString)),
-            this, SIGNAL(selectionChanged(QString)));
+    connect(_emulation, SIGNAL(selectionChanged(bool)),
+            this, SIGNAL(selectionChanged(bool)));
     connect(_emulation, SIGNAL(imageResizeRequest(QSize)),
             this, SIGNAL(resizeRequest(QSize)));
     connect(_emulation, SIGNAL(sendData(const char*, int)),
@@ -322,6 +329,8 @@ void Session::addView(TerminalDisplay* widget)
             _emulation, SLOT(sendMouseEvent(int,int,int,int)));
     connect(widget, SIGNAL(sendStringToEmu(const char*)),
             _emulation, SLOT(sendString(const char*)));
+    connect(widget, SIGNAL(resumeOutputRequest()),
+            _emulation, SLOT(resumeOutput()));
 
     // allow emulation to notify view when the foreground process
     // indicates whether or not it is interested in mouse signals
@@ -330,6 +339,9 @@ void Session::addView(TerminalDisplay* widget)
 
     widget->setUsesMouse(_emulation->programUsesMouse());
 
+    if (_emulation->isDiscardingOutput())
+        widget->outputDiscarded(true);
+
     widget->setScreenWindow(_emulation->createWindow());
 
     //connect view signals and slots
@@ -635,6 +647,13 @@ void Session::updateFlowControlState(bool suspended)
     }
 }
 
+void Session::updateOutputDiscardingState(bool discarding)
+{
+    foreach(TerminalDisplay * display, _views) {
+        display->outputDiscarded(discarding);
+    }
+}
+
 void Session::onPrimaryScreenInUse(bool use)
 {
     emit primaryScreenInUse(use);
@@ -905,6 +924,16 @@ void Session::setKeyBindings(const QString& name)
     _emulation->setKeyBindings(name);
 }
 
+void Session::setClipboardPayloadLimit(int bytes)
+{
+    _emulation->setClipboardPayloadLimit(bytes);
+}
+
+void Session::setBinaryOutputGuardEnabled(bool enabled)
+{
+    _emulation->setBinaryOutputGuardEnabled(enabled);
+}
+
 void Session::setTitle(TitleRole role , const QString& newTitle)
 {
     if (title(role) != newTitle) {
@@ -990,16 +1019,39 @@ QString Session::getDynamicTitle()
     // update current directory from process
     ProcessInfo* process = updateWorkingDirectory();
 
-    // format tab titles using process info
     bool ok = false;
+    const QString processName = process->name(&ok);
+    const bool isRemote = (processName == "ssh" && ok);
+    const QString format = tabTitleFormat(isRemote ? Session::RemoteTabTitle
+                                                   : Session::LocalTabTitle);
+    const int pid = process->pid(&ok);
+
+    // formatting the title is comparatively expensive, only do it when
+    // the process, its name or working directory, or the format changed
+    if (_dynamicTitleValid &&
+            pid == _dynamicTitlePid &&
+            processName == _dynamicTitleProcessName &&
+            _currentWorkingDir == _dynamicTitleDir &&
+            format == _dynamicTitleFormat) {
+        return _dynamicTitle;
+    }
+
+    // format tab titles using process info
     QString title;
-    if (process->name(&ok) == "ssh" && ok) {
+    if (isRemote) {
         SSHProcessInfo sshInfo(*process);
-        title = sshInfo.format(tabTitleFormat(Session::RemoteTabTitle));
+        title = sshInfo.format(format);
     } else {
-        title = process->format(tabTitleFormat(Session::LocalTabTitle));
+        title = process->format(format);
     }
 
+    _dynamicTitleValid = true;
+    _dynamicTitle = title;
+    _dynamicTitleFormat = format;
+    _dynamicTitleProcessName = processName;
+    _dynamicTitleDir = _currentWorkingDir;
+    _dynamicTitlePid = pid;
+
     return title;
 }
 
@@ -1293,6 +1345,9 @@ void Session::zmodemFinished()
 
 void Session::onReceiveBlock(const char* buf, int len)
 {
+    SessionUsage::Scope scope(&_usage);
+    _usage.addReceivedBytes(len);
+
     _emulation->receiveData(buf, len);
 }
 
@@ -1319,6 +1374,11 @@ void Session::setPreferredSize(const QSize& size)
     _preferredSize = size;
 }
 
+SessionUsage* Session::usage()
+{
+    return &_usage;
+}
+
 int Session::processId() const
 {
     return _shellProcess->pid();
@@ -1385,7 +1445,8 @@ void Session::setHistorySize(int lines)
     } else if (lines == 0) {
         setHistoryType(HistoryTypeNone());
     } else {
-        setHistoryType(CompactHistoryType(lines));
+        const CompactHistoryType* current = dynamic_cast<const CompactHistoryType*>(&historyType());
+        setHistoryType(CompactHistoryType(lines, current && current->isDeduplicationEnabled()));
     }
 }
 
@@ -1404,6 +1465,26 @@ int Session::historySize() const
     }
 }
 
+double Session::cpuUsage()
+{
+    return _usage.rates().cpuMilliseconds;
+}
+
+double Session::outputRate()
+{
+    return _usage.rates().bytes;
+}
+
+double Session::frameRate()
+{
+    return _usage.rates().frames;
+}
+
+double Session::skippedHistoryLineRate()
+{
+    return _usage.rates().skippedHistoryLines;
+}
+
 int Session::foregroundProcessId()
 {
     int pid;
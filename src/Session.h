@@ -38,6 +38,7 @@
 
 // Konsole
 #include "konsole_export.h"
+#include "SessionUsage.h"
 
 class QColor;
 
@@ -234,6 +235,20 @@ public:
     /** Returns the name of the key bindings used by this session. */
     QString keyBindings() const;
 
+    /**
+     * Sets the maximum size in bytes of text which programs running in
+     * this session may place on the clipboard.  0 disables remote
+     * clipboard access.  See Emulation::setClipboardPayloadLimit()
+     */
+    void setClipboardPayloadLimit(int bytes);
+
+    /**
+     * Sets whether output which looks like binary data, such as the
+     * contents of a binary file, is discarded instead of being shown.
+     * See Emulation::setBinaryOutputGuardEnabled()
+     */
+    void setBinaryOutputGuardEnabled(bool enabled);
+
     /**
      * This enum describes the available title roles.
      */
@@ -311,6 +326,13 @@ public:
 
     void setPreferredSize(const QSize & size);
 
+    /**
+     * Returns the record of the work which the GUI thread does for this
+     * session: receiving its output, and updating, painting and finding
+     * the hotspots in its views.
+     */
+    SessionUsage* usage();
+
     /**
      * Sets whether the session has a dark background or not.  The session
      * uses this information to set the COLORFGBG variable in the process's
@@ -568,6 +590,25 @@ public slots:
      */
     Q_SCRIPTABLE int historySize() const;
 
+    /**
+     * Returns the milliseconds per second which the GUI thread recently
+     * spent on this session's output and views.  See usage()
+     */
+    Q_SCRIPTABLE double cpuUsage();
+
+    /** Returns the bytes of output per second which the session recently received. */
+    Q_SCRIPTABLE double outputRate();
+
+    /** Returns the number of times per second the session's image was recently updated. */
+    Q_SCRIPTABLE double frameRate();
+
+    /**
+     * Returns the number of lines per second which were recently dropped
+     * from the history without being compacted, because output arrived
+     * faster than the history limit allowed it to be displayed.
+     */
+    Q_SCRIPTABLE double skippedHistoryLineRate();
+
 signals:
 
     /** Emitted when the terminal process starts. */
@@ -643,6 +684,12 @@ signals:
      */
     void profileChangeCommandReceived(const QString& text);
 
+    /**
+     * Emitted when the terminal program requests that @p text be placed
+     * on the clipboard.  See Emulation::clipboardChangeRequest()
+     */
+    void clipboardChangeRequest(const QString& targets, const QString& text);
+
     /**
      * Emitted when the flow control state changes.
      *
@@ -662,10 +709,10 @@ signals:
     /**
      * Emitted when the text selection is changed.
      *
-     * This signal serves as a relayer of Emulation::selectedText(QString),
+     * This signal serves as a relayer of Emulation::selectionChanged(bool),
      * making it usable for higher level component.
      */
-    void selectionChanged(const QString& text);
+    void selectionChanged(bool hasSelection);
 
 private slots:
     void done(int, QProcess::ExitStatus);
@@ -689,6 +736,7 @@ private slots:
     void zmodemFinished();
 
     void updateFlowControlState(bool suspended);
+    void updateOutputDiscardingState(bool discarding);
     void updateWindowSize(int lines, int columns);
 
     // signal relayer
@@ -757,6 +805,15 @@ private:
     ProcessInfo*   _foregroundProcessInfo;
     int            _foregroundPid;
 
+    // the last title returned by getDynamicTitle() and the inputs it
+    // was formatted from
+    QString        _dynamicTitle;
+    QString        _dynamicTitleFormat;
+    QString        _dynamicTitleProcessName;
+    QString        _dynamicTitleDir;
+    int            _dynamicTitlePid;
+    bool           _dynamicTitleValid;
+
     // ZModem
     bool           _zmodemBusy;
     KProcess*      _zmodemProc;
@@ -766,6 +823,8 @@ private:
 
     QSize _preferredSize;
 
+    SessionUsage _usage;
+
     static int lastSessionId;
 };
 
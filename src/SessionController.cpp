@@ -22,7 +22,13 @@
 #include "SessionController.h"
 
 // Qt
+#include <QtCore/QMutex>
+#include <QtCore/QRunnable>
+#include <QtCore/QThread>
+#include <QtCore/QThreadPool>
+#include <QtCore/QTimer>
 #include <QApplication>
+#include <QClipboard>
 #include <QMenu>
 #include <QtGui/QKeyEvent>
 #include <QPrinter>
@@ -82,6 +88,7 @@
 #include <KIO/Job>
 #include <KJob>
 #include "TerminalCharacterDecoder.h"
+#include "ParallelLineDecoder.h"
 
 // For Unix signal names
 #include <signal.h>
@@ -97,6 +104,14 @@ const KIcon SessionController::_broadcastIcon("emblem-important");
 QSet<SessionController*> SessionController::_allControllers;
 int SessionController::_lastControllerId;
 
+// searches give up keeping track of matching lines when there are more than
+// this, a search for a longer text is likely to find fewer
+static const int MAX_INCREMENTAL_SEARCH_LINES = 100000;
+
+// longest time in milliseconds that counting matches is put off while the
+// output keeps changing
+static const int MAX_MATCH_COUNT_DELAY = 2000;
+
 SessionController::SessionController(Session* session , TerminalDisplay* view, QObject* parent)
     : ViewProperties(parent)
     , KXMLGUIClient()
@@ -107,6 +122,8 @@ SessionController::SessionController(Session* session , TerminalDisplay* view, Q
     , _previousState(-1)
     , _viewUrlFilter(0)
     , _searchFilter(0)
+    , _matchCountGeneration(0)
+    , _matchLineCount(-1)
     , _copyInputToAllTabsAction(0)
     , _findAction(0)
     , _findNextAction(0)
@@ -119,26 +136,23 @@ SessionController::SessionController(Session* session , TerminalDisplay* view, Q
     , _listenForScreenWindowUpdates(false)
     , _preventClose(false)
     , _keepIconUntilInteraction(false)
+    , _hasSelection(false)
     , _showMenuAction(0)
     , _isSearchBarEnabled(false)
+    , _actionsCreated(false)
+    , _primaryScreenInUse(true)
 {
     Q_ASSERT(session);
     Q_ASSERT(view);
 
     // handle user interface related to session (menus etc.)
-    if (isKonsolePart()) {
+    //
+    // the actions themselves are created by setupActions() once the
+    // controller is activated
+    if (isKonsolePart())
         setXMLFile("konsole/partui.rc");
-        setupCommonActions();
-    } else {
+    else
         setXMLFile("konsole/sessionui.rc");
-        setupCommonActions();
-        setupExtraActions();
-    }
-
-    actionCollection()->addAssociatedWidget(view);
-    foreach(QAction * action, actionCollection()->actions()) {
-        action->setShortcutContext(Qt::WidgetWithChildrenShortcut);
-    }
 
     setIdentifier(++_lastControllerId);
     sessionTitleChanged();
@@ -150,6 +164,10 @@ SessionController::SessionController(Session* session , TerminalDisplay* view, Q
     connect(_session, SIGNAL(resizeRequest(QSize)), this,
             SLOT(sessionResizeRequest(QSize)));
 
+    // listen for requests from the terminal program to set the clipboard
+    connect(_session, SIGNAL(clipboardChangeRequest(QString,QString)), this,
+            SLOT(sessionClipboardChangeRequest(QString,QString)));
+
     // listen for popup menu requests
     connect(_view, SIGNAL(configureRequest(QPoint)), this,
             SLOT(showDisplayContextMenu(QPoint)));
@@ -197,6 +215,13 @@ SessionController::SessionController(Session* session , TerminalDisplay* view, Q
     connect(_interactionTimer, SIGNAL(timeout()), this, SLOT(snapshot()));
     connect(_view, SIGNAL(keyPressedSignal(QKeyEvent*)), this, SLOT(interactionHandler()));
 
+    // count the matches for the current search again once the output
+    // stops changing for a moment
+    _matchCountTimer = new QTimer(this);
+    _matchCountTimer->setSingleShot(true);
+    _matchCountTimer->setInterval(500);
+    connect(_matchCountTimer, SIGNAL(timeout()), this, SLOT(updateMatchCount()));
+
     // take a snapshot of the session state periodically in the background
     QTimer* backgroundTimer = new QTimer(_session);
     backgroundTimer->setSingleShot(false);
@@ -256,6 +281,8 @@ void SessionController::snapshot()
 {
     Q_ASSERT(_session != 0);
 
+    SessionUsage::Scope scope(_session->usage());
+
     QString title = _session->getDynamicTitle();
     title         = title.simplified();
 
@@ -352,8 +379,34 @@ void SessionController::openUrl(const KUrl& url)
     }
 }
 
+void SessionController::setupActions()
+{
+    if (_actionsCreated)
+        return;
+
+    _actionsCreated = true;
+
+    setupCommonActions();
+    if (!isKonsolePart())
+        setupExtraActions();
+
+    actionCollection()->addAssociatedWidget(_view);
+    foreach(QAction * action, actionCollection()->actions()) {
+        action->setShortcutContext(Qt::WidgetWithChildrenShortcut);
+    }
+
+    // bring the actions up to date with the state of the session
+    setupPrimaryScreenSpecificActions(_primaryScreenInUse);
+    updateCopyAction(_hasSelection);
+}
+
 void SessionController::setupPrimaryScreenSpecificActions(bool use)
 {
+    _primaryScreenInUse = use;
+
+    if (!_actionsCreated)
+        return;
+
     KActionCollection* collection = actionCollection();
     QAction* clearAction = collection->action("clear-history");
     QAction* resetAction = collection->action("clear-history-and-reset");
@@ -365,18 +418,21 @@ void SessionController::setupPrimaryScreenSpecificActions(bool use)
     selectAllAction->setEnabled(use);
 }
 
-void SessionController::selectionChanged(const QString& selectedText)
+void SessionController::selectionChanged(bool hasSelection)
 {
-    _selectedText = selectedText;
-    updateCopyAction(selectedText);
+    _hasSelection = hasSelection;
+    updateCopyAction(hasSelection);
 }
 
-void SessionController::updateCopyAction(const QString& selectedText)
+void SessionController::updateCopyAction(bool hasSelection)
 {
+    if (!_actionsCreated)
+        return;
+
     QAction* copyAction = actionCollection()->action("edit_copy");
 
     // copy action is meaningful only when some text is selected.
-    copyAction->setEnabled(!selectedText.isEmpty());
+    copyAction->setEnabled(hasSelection);
 }
 
 void SessionController::updateWebSearchMenu()
@@ -385,10 +441,12 @@ void SessionController::updateWebSearchMenu()
     _webSearchMenu->setVisible(false);
     _webSearchMenu->menu()->clear();
 
-    if (_selectedText.isEmpty())
+    if (!_hasSelection)
         return;
 
-    QString searchText = _selectedText;
+    // the selected text is only built here, when the context menu is shown,
+    // rather than each time the selection changes
+    QString searchText = _view->screenWindow()->selectedText(true);
     searchText = searchText.replace('\n', ' ').replace('\r', ' ').simplified();
 
     if (searchText.isEmpty())
@@ -1070,6 +1128,8 @@ void SessionController::listenForScreenWindowUpdates()
             SLOT(updateSearchFilter()));
     connect(_view->screenWindow(), SIGNAL(scrolled(int)), this,
             SLOT(updateSearchFilter()));
+    connect(_view->screenWindow(), SIGNAL(outputChanged()), this,
+            SLOT(scheduleMatchCountUpdate()));
 
     _listenForScreenWindowUpdates = true;
 }
@@ -1142,12 +1202,21 @@ void SessionController::searchHistory(bool showSearchBar)
 
             removeSearchFilter();
 
+            stopCountingMatches();
+            _matchCountRegExp = QRegExp();
+            _matchLines.clear();
+            _matchLineCount = -1;
+            _view->setSearchMatchLines(_matchLines, 0);
+
             _view->setFocus(Qt::ActiveWindowFocusReason);
         }
     }
 }
 void SessionController::setFindNextPrevEnabled(bool enabled)
 {
+    if (!_actionsCreated)
+        return;
+
     _findNextAction->setEnabled(enabled);
     _findPreviousAction->setEnabled(enabled);
 }
@@ -1166,19 +1235,194 @@ void SessionController::searchCompleted(bool success)
 {
     if (_searchBar)
         _searchBar->setFoundMatch(success);
+
+    updateMatchCount();
 }
 
-void SessionController::beginSearch(const QString& text , int direction)
+void SessionController::updateMatchCount()
 {
-    Q_ASSERT(_searchBar);
-    Q_ASSERT(_searchFilter);
+    if (!_searchBar || !_searchBar->isVisible())
+        return;
+
+    const QRegExp regExp = searchRegExp(_searchBar->searchText());
+    const quint32 outputGeneration = _session->emulation()->outputGeneration();
+
+    if (regExp.isEmpty() || !regExp.isValid()) {
+        stopCountingMatches();
+        _matchCountRegExp = regExp;
+        _matchCountGeneration = outputGeneration;
+        _matchLines.clear();
+        _matchLineCount = -1;
+    } else if (isIncrementalSearchCurrent(regExp)) {
+        // the matching lines are already known, or known to be too many
+        stopCountingMatches();
+        _matchCountRegExp = regExp;
+        _matchCountGeneration = outputGeneration;
+        _matchLines = _incrementalSearch.lines;
+        _matchLineCount = _incrementalSearch.tooManyLines ? -1 : _incrementalSearch.lineCount;
+    } else if (regExp != _matchCountRegExp || outputGeneration != _matchCountGeneration) {
+        // while the output is searched again, the previous count for the
+        // same search remains visible
+        if (regExp != _matchCountRegExp) {
+            _matchLines.clear();
+            _matchLineCount = -1;
+        }
+        startCountingMatches(regExp);
+    }
+
+    showMatchCount();
+}
+
+void SessionController::scheduleMatchCountUpdate()
+{
+    // a count which is in progress starts another one when it finishes
+    // if the output has changed in the meantime.  Otherwise the timer is
+    // restarted for each change, so counting waits until the output has
+    // been quiet for a moment rather than repeating during a flood.  Output
+    // which never stops still gets counted every MAX_MATCH_COUNT_DELAY ms
+    if (_searchBar && _searchBar->isVisible() && !_matchCountTask
+            && _session->emulation()->outputGeneration() != _matchCountGeneration) {
+        if (!_matchCountTimer->isActive()) {
+            _matchCountDelay.start();
+            _matchCountTimer->start();
+        } else if (_matchCountDelay.elapsed() + _matchCountTimer->interval() < MAX_MATCH_COUNT_DELAY) {
+            _matchCountTimer->start();
+        }
+    }
+}
+
+void SessionController::startCountingMatches(const QRegExp& regExp)
+{
+    stopCountingMatches();
+
+    _matchCountRegExp = regExp;
+    _matchCountGeneration = _session->emulation()->outputGeneration();
+    _countedMatchLines.clear();
+
+    _matchCountTask = new SearchAllSessionsTask(this);
+    _matchCountTask->setRegExp(regExp);
+    _matchCountTask->setMaximumMatches(MAX_INCREMENTAL_SEARCH_LINES + 1);
+    _matchCountTask->setAutoDelete(true);
+    _matchCountTask->addSession(_session);
+
+    connect(_matchCountTask, SIGNAL(matchesFound(QList<SearchAllSessionsTask::Match>)),
+            this, SLOT(addCountedMatches(QList<SearchAllSessionsTask::Match>)));
+    connect(_matchCountTask, SIGNAL(completed(bool)), this, SLOT(matchCountCompleted(bool)));
+
+    _matchCountTask->execute();
+}
+
+void SessionController::stopCountingMatches()
+{
+    _matchCountTimer->stop();
+
+    if (_matchCountTask) {
+        _matchCountTask->disconnect(this);
+        _matchCountTask->cancel();
+        _matchCountTask = 0;
+    }
+}
 
+void SessionController::addCountedMatches(const QList<SearchAllSessionsTask::Match>& matches)
+{
+    foreach(const SearchAllSessionsTask::Match& match, matches) {
+        _countedMatchLines << match.line;
+    }
+}
+
+void SessionController::matchCountCompleted(bool success)
+{
+    _matchCountTask = 0;
+
+    if (!success)
+        return;
+
+    Emulation* emulation = _session->emulation();
+
+    // the matches are found starting with the most recent output
+    qSort(_countedMatchLines.begin(), _countedMatchLines.end());
+
+    const bool tooManyLines = _countedMatchLines.count() > MAX_INCREMENTAL_SEARCH_LINES;
+    if (tooManyLines) {
+        _matchLines.clear();
+        _matchLineCount = -1;
+    } else {
+        _matchLines = _countedMatchLines;
+        _matchLineCount = emulation->lineCount();
+    }
+    _countedMatchLines.clear();
+
+    // next, previous and a longer search text can start from the matches
+    // unless the output changed while it was being searched
+    if (emulation->outputGeneration() == _matchCountGeneration) {
+        _incrementalSearch.valid = !tooManyLines;
+        _incrementalSearch.tooManyLines = tooManyLines;
+        _incrementalSearch.regExp = _matchCountRegExp;
+        _incrementalSearch.outputGeneration = _matchCountGeneration;
+        _incrementalSearch.lineCount = emulation->lineCount();
+        _incrementalSearch.lines = _matchLines;
+    }
+
+    showMatchCount();
+    scheduleMatchCountUpdate();
+}
+
+void SessionController::showMatchCount()
+{
+    if (!_searchBar)
+        return;
+
+    if (_matchLineCount < 0) {
+        _searchBar->setMatchCount(-1, -1);
+        _view->setSearchMatchLines(QVector<int>(), 0);
+        return;
+    }
+
+    // the selection is on the line of the current match after a search
+    int current = 0;
+    if (_hasSelection) {
+        ScreenWindow* window = _view->screenWindow();
+        int column = 0;
+        int line = 0;
+        window->getSelectionStart(column, line);
+        line += window->currentLine();
+
+        QVector<int>::const_iterator match = qBinaryFind(_matchLines.constBegin(),
+                                             _matchLines.constEnd(), line);
+        if (match != _matchLines.constEnd())
+            current = match - _matchLines.constBegin() + 1;
+    }
+
+    _searchBar->setMatchCount(current, _matchLines.count());
+    _view->setSearchMatchLines(_matchLines, _matchLineCount);
+}
+
+bool SessionController::isIncrementalSearchCurrent(const QRegExp& regExp) const
+{
+    const Emulation* emulation = _session->emulation();
+
+    return (_incrementalSearch.valid || _incrementalSearch.tooManyLines)
+           && _incrementalSearch.regExp == regExp
+           && _incrementalSearch.outputGeneration == emulation->outputGeneration()
+           && _incrementalSearch.lineCount == emulation->lineCount();
+}
+
+QRegExp SessionController::searchRegExp(const QString& text) const
+{
     QBitArray options = _searchBar->optionsChecked();
 
     Qt::CaseSensitivity caseHandling = options.at(IncrementalSearchBar::MatchCase) ? Qt::CaseSensitive : Qt::CaseInsensitive;
     QRegExp::PatternSyntax syntax = options.at(IncrementalSearchBar::RegExp) ? QRegExp::RegExp : QRegExp::FixedString;
 
-    QRegExp regExp(text ,  caseHandling , syntax);
+    return QRegExp(text , caseHandling , syntax);
+}
+
+void SessionController::beginSearch(const QString& text , int direction)
+{
+    Q_ASSERT(_searchBar);
+    Q_ASSERT(_searchFilter);
+
+    QRegExp regExp = searchRegExp(text);
     _searchFilter->setRegExp(regExp);
 
     if (!regExp.isEmpty()) {
@@ -1188,6 +1432,7 @@ void SessionController::beginSearch(const QString& text , int direction)
 
         task->setRegExp(regExp);
         task->setSearchDirection((SearchHistoryTask::SearchDirection)direction);
+        task->setIncrementalState(&_incrementalSearch);
         task->setAutoDelete(true);
         task->addScreenWindow(_session , _view->screenWindow());
         task->execute();
@@ -1261,15 +1506,29 @@ void SessionController::sessionResizeRequest(const QSize& size)
     //kDebug() << "View resize requested to " << size;
     _view->setSize(size.width(), size.height());
 }
+void SessionController::sessionClipboardChangeRequest(const QString& targets, const QString& text)
+{
+    // xterm selection targets: 'c' is the clipboard, 'p' and 's' the X11
+    // selection.  Cut buffers ('0'-'7') are not supported.
+    const bool toClipboard = targets.isEmpty() || targets.contains('c');
+    const bool toSelection = targets.contains('p') || targets.contains('s');
+
+    if (toClipboard)
+        QApplication::clipboard()->setText(text, QClipboard::Clipboard);
+    if (toSelection)
+        QApplication::clipboard()->setText(text, QClipboard::Selection);
+}
 void SessionController::scrollBackOptionsChanged(int mode, int lines)
 {
     switch (mode) {
     case Enum::NoHistory:
         _session->setHistoryType(HistoryTypeNone());
         break;
-    case Enum::FixedSizeHistory:
-        _session->setHistoryType(CompactHistoryType(lines));
-        break;
+    case Enum::FixedSizeHistory: {
+        const CompactHistoryType* current = dynamic_cast<const CompactHistoryType*>(&_session->historyType());
+        _session->setHistoryType(CompactHistoryType(lines, current && current->isDeduplicationEnabled()));
+    }
+    break;
     case Enum::UnlimitedHistory:
         _session->setHistoryType(HistoryTypeFile());
         break;
@@ -1394,6 +1653,8 @@ void SessionController::sessionTitleChanged()
 
 void SessionController::showDisplayContextMenu(const QPoint& position)
 {
+    setupActions();
+
     // needed to make sure the popup menu is available, even if a hosting
     // application did not merge our GUI.
     if (!factory()) {
@@ -1647,8 +1908,9 @@ void SaveHistoryTask::jobDataRequested(KIO::Job* job , QByteArray& data)
 {
     // TODO - Report progress information for the job
 
-    // PERFORMANCE:  Do some tests and tweak this value to get faster saving
-    const int LINES_PER_REQUEST = 500;
+    // the lines of each request are decoded in chunks on all of the
+    // processors, so enough lines are sent at once to keep them busy
+    const int LINES_PER_REQUEST = 5000;
 
     SaveJob& info = _jobSession[job];
 
@@ -1666,9 +1928,14 @@ void SaveHistoryTask::jobDataRequested(KIO::Job* job , QByteArray& data)
         int copyUpToLine = qMin(info.lastLineFetched + LINES_PER_REQUEST ,
                                 sessionLines - 1);
 
+        LineBlock block;
+        info.session->emulation()->copyLines(&block, info.lastLineFetched + 1, copyUpToLine);
+
+        ParallelLineDecoder parallelDecoder(info.decoder);
+
         QTextStream stream(&data, QIODevice::ReadWrite);
         info.decoder->begin(&stream);
-        info.session->emulation()->writeToStream(info.decoder , info.lastLineFetched + 1 , copyUpToLine);
+        stream << parallelDecoder.decode(block);
         info.decoder->end();
 
         info.lastLineFetched = copyUpToLine;
@@ -1725,13 +1992,43 @@ void SearchHistoryTask::executeOnScreenWindow(SessionPtr session , ScreenWindowP
         // Temporary fix for #205495
         if (startLine < 0) startLine = 0;
         const int lastLine = window->lineCount() - 1;
-        QString string;
 
-        //text stream to read history into string for pattern or regular expression searching
-        QTextStream searchStream(&string);
+        if (_incrementalState && updateMatchingLines(emulation)) {
+            const QVector<int>& lines = _incrementalState->lines;
+
+            if (!lines.isEmpty()) {
+                // the first match after the start line, or before it when
+                // searching backwards, wrapping around at the end of the output
+                int findPos;
+                if (forwards) {
+                    QVector<int>::const_iterator match = qLowerBound(lines.begin(), lines.end(), startLine);
+                    findPos = (match != lines.end()) ? *match : lines.first();
+                } else {
+                    QVector<int>::const_iterator match = qUpperBound(lines.begin(), lines.end(), startLine);
+                    findPos = (match != lines.begin()) ? *(match - 1) : lines.last();
+                }
+
+                highlightResult(window, findPos);
+
+                emit completed(true);
+
+                return;
+            }
+
+            window->clearSelection();
+            window->notifyOutputChanged();
+
+            emit completed(false);
+
+            return;
+        }
 
+        //the lines of each block are decoded on all of the processors,
+        //the text is searched for a pattern or regular expression afterwards
+        QString string;
+        LineBlock block;
         PlainTextDecoder decoder;
-        decoder.setRecordLinePositions(true);
+        ParallelLineDecoder parallelDecoder(&decoder);
 
         //setup first and last lines depending on search direction
         int line = startLine;
@@ -1779,9 +2076,9 @@ void SearchHistoryTask::executeOnScreenWindow(SessionPtr session , ScreenWindowP
                 }
             }
 
-            decoder.begin(&searchStream);
-            emulation->writeToStream(&decoder, qMin(endLine, line) , qMax(endLine, line));
-            decoder.end();
+            block.clear();
+            emulation->copyLines(&block, qMin(endLine, line) , qMax(endLine, line));
+            string = parallelDecoder.decode(block);
 
             // line number search below assumes that the buffer ends with a new-line
             string.append('\n');
@@ -1795,11 +2092,11 @@ void SearchHistoryTask::executeOnScreenWindow(SessionPtr session , ScreenWindowP
             //if a match is found, position the cursor on that line and update the screen
             if (pos != -1) {
                 int newLines = 0;
-                QList<int> linePositions = decoder.linePositions();
+                const QVector<int> linePositions = parallelDecoder.linePositions();
                 while (newLines < linePositions.count() && linePositions[newLines] <= pos)
                     newLines++;
 
-                // ignore the new line at the start of the buffer
+                // ignore the position of the first line, at the start of the buffer
                 newLines--;
 
                 int findPos = qMin(line, endLine) + newLines;
@@ -1838,11 +2135,108 @@ void SearchHistoryTask::highlightResult(ScreenWindowPtr window , int findPos)
     window->notifyOutputChanged();
 }
 
+// the number of matching lines searched between processing events
+static const int INCREMENTAL_SEARCH_BLOCK_LINES = 10000;
+
+// returns true if state still describes the search for regExp in the output
+// of emulation as it was at outputGeneration.  another search, or new output,
+// may have replaced it while events were processed
+static bool isSearchStateCurrent(const IncrementalSearchState* state, const QRegExp& regExp,
+                                 quint32 outputGeneration, Emulation* emulation)
+{
+    return state->regExp == regExp
+           && state->outputGeneration == outputGeneration
+           && emulation->outputGeneration() == outputGeneration;
+}
+
+bool SearchHistoryTask::updateMatchingLines(Emulation* emulation)
+{
+    IncrementalSearchState* state = _incrementalState;
+    const quint32 outputGeneration = emulation->outputGeneration();
+    const int lineCount = emulation->lineCount();
+
+    const bool current = state->valid
+                         && state->outputGeneration == outputGeneration
+                         && state->lineCount == lineCount;
+
+    // searching for the same text again, to find the next match
+    if (current && state->regExp == _regExp)
+        return true;
+
+    // only the lines where a shorter fixed string matched are searched
+    // here.  Every other search finds the next match with a plain search,
+    // and the matching lines are found by SessionController's count of the
+    // matches in the background
+    const QString text = _regExp.pattern();
+    const Qt::CaseSensitivity caseSensitivity = _regExp.caseSensitivity();
+    const QRegExp& previous = state->regExp;
+    const bool refine = current
+                        && _regExp.patternSyntax() == QRegExp::FixedString
+                        && previous.patternSyntax() == QRegExp::FixedString
+                        && previous.caseSensitivity() == caseSensitivity
+                        && text.startsWith(previous.pattern(), caseSensitivity);
+    if (!refine)
+        return false;
+
+    // the generation is recorded before searching, in case output arrives
+    // while events are processed below.  the lines are not valid until the
+    // search is complete, so that a search started meanwhile doesn't use them
+    state->regExp = _regExp;
+    state->outputGeneration = outputGeneration;
+    state->lineCount = lineCount;
+    state->valid = false;
+    state->tooManyLines = false;
+
+    QString string;
+    QTextStream searchStream(&string);
+    PlainTextDecoder decoder;
+    decoder.setRecordLinePositions(true);
+
+    // a match starting on a line continues on the following lines if
+    // they are wrapped, so enough of them are read to hold the whole text
+    const int columns = qMax(1, emulation->imageSize().width());
+    const int extraLines = text.length() / columns + 1;
+
+    // the state may be replaced by a count of the matches or another
+    // search while events are processed, so the lines are refined in a copy
+    const QVector<int> candidates = state->lines;
+    QVector<int> lines;
+    for (int i = 0; i < candidates.count(); i++) {
+        if (i % INCREMENTAL_SEARCH_BLOCK_LINES == 0)
+            QApplication::processEvents();
+
+        const int line = candidates[i];
+
+        string.clear();
+        decoder.begin(&searchStream);
+        emulation->writeToStream(&decoder, line, qMin(line + extraLines, lineCount - 1));
+        decoder.end();
+
+        const QList<int> linePositions = decoder.linePositions();
+        const int lineEnd = (linePositions.count() > 1) ? linePositions[1] : string.length();
+        const int pos = string.indexOf(text, 0, caseSensitivity);
+        if (pos != -1 && pos < lineEnd)
+            lines << line;
+    }
+
+    if (!isSearchStateCurrent(state, _regExp, outputGeneration, emulation))
+        return false;
+
+    state->lines = lines;
+    state->valid = true;
+    return true;
+}
+
 SearchHistoryTask::SearchHistoryTask(QObject* parent)
     : SessionTask(parent)
     , _direction(ForwardsSearch)
+    , _incrementalState(0)
 {
 }
+void SearchHistoryTask::setIncrementalState(IncrementalSearchState* state)
+{
+    _incrementalState = state;
+}
 void SearchHistoryTask::setSearchDirection(SearchDirection direction)
 {
     _direction = direction;
@@ -1860,6 +2254,293 @@ QRegExp SearchHistoryTask::regExp() const
     return _regExp;
 }
 
+namespace Konsole
+{
+// State shared between a SearchAllSessionsTask and the jobs searching
+// blocks of its sessions' output on the thread pool.  The jobs keep it alive
+// if the task is destroyed before they finish.
+class SearchAllSessionsState
+{
+public:
+    struct BlockResult {
+        int cursor;
+        QList<int> lines;
+        QStringList texts;
+    };
+
+    SearchAllSessionsState()
+        : pendingBlocks(0)
+        , linesSearched(0) {
+    }
+
+    QAtomicInt cancelled;
+    QMutex mutex;
+    // the following are protected by mutex
+    int pendingBlocks;
+    int linesSearched;
+    QList<BlockResult> results;
+};
+
+// Searches one block of lines copied from a session's output
+class SearchAllSessionsJob : public QRunnable
+{
+public:
+    SearchAllSessionsJob(QSharedPointer<SearchAllSessionsState> state , int cursor ,
+                         int firstLine , const QStringList& lines , const QRegExp& regExp)
+        : _state(state)
+        , _cursor(cursor)
+        , _firstLine(firstLine)
+        , _lines(lines)
+        , _regExp(regExp) {
+    }
+
+    virtual void run() {
+        SearchAllSessionsState::BlockResult result;
+        result.cursor = _cursor;
+
+        if (!_state->cancelled) {
+            for (int i = 0; i < _lines.count(); i++) {
+                if (_regExp.indexIn(_lines[i]) != -1) {
+                    result.lines << _firstLine + i;
+                    result.texts << _lines[i];
+                }
+            }
+        }
+
+        QMutexLocker locker(&_state->mutex);
+        _state->pendingBlocks--;
+        _state->linesSearched += _lines.count();
+        if (!result.lines.isEmpty())
+            _state->results << result;
+    }
+
+private:
+    QSharedPointer<SearchAllSessionsState> _state;
+    int _cursor;
+    int _firstLine;
+    QStringList _lines;
+    QRegExp _regExp;
+};
+}
+
+// number of lines copied from a session's output into each block
+static const int SEARCH_BLOCK_LINES = 2000;
+// number of lines copied on the GUI thread per event loop iteration
+static const int SEARCH_LINES_PER_ITERATION = 10000;
+
+SearchAllSessionsTask::SearchAllSessionsTask(QObject* parent)
+    : SessionTask(parent)
+    , _maximumMatches(1000)
+    , _matchCount(0)
+    , _totalLines(0)
+    , _nextCursor(0)
+    , _running(false)
+{
+    _timer = new QTimer(this);
+    _timer->setInterval(0);
+    connect(_timer, SIGNAL(timeout()), this, SLOT(processBlocks()));
+}
+SearchAllSessionsTask::~SearchAllSessionsTask()
+{
+    // let jobs which have not started yet return without searching
+    if (_state)
+        _state->cancelled = 1;
+}
+void SearchAllSessionsTask::setRegExp(const QRegExp& expression)
+{
+    _regExp = expression;
+}
+QRegExp SearchAllSessionsTask::regExp() const
+{
+    return _regExp;
+}
+void SearchAllSessionsTask::setMaximumMatches(int count)
+{
+    _maximumMatches = count;
+}
+int SearchAllSessionsTask::maximumMatches() const
+{
+    return _maximumMatches;
+}
+void SearchAllSessionsTask::execute()
+{
+    Q_ASSERT(!_running);
+
+    if (_regExp.isEmpty()) {
+        emit completed(false);
+        if (autoDelete())
+            deleteLater();
+        return;
+    }
+
+    _state = QSharedPointer<SearchAllSessionsState>(new SearchAllSessionsState);
+    _cursors.clear();
+    _nextCursor = 0;
+    _matchCount = 0;
+    _totalLines = 0;
+
+    foreach(const SessionPtr& session, sessions()) {
+        if (!session)
+            continue;
+
+        Cursor cursor;
+        cursor.session = session;
+        cursor.lineCount = session->emulation()->lineCount();
+        cursor.nextEndLine = cursor.lineCount;
+        _cursors << cursor;
+
+        _totalLines += cursor.lineCount;
+    }
+
+    _running = true;
+    _timer->start();
+}
+void SearchAllSessionsTask::cancel()
+{
+    if (_running)
+        finish(false);
+}
+void SearchAllSessionsTask::processBlocks()
+{
+    collectResults();
+    if (!_running)
+        return;
+
+    int linesQueued = 0;
+    while (linesQueued < SEARCH_LINES_PER_ITERATION && queueNextBlock(linesQueued)) {
+    }
+
+    int pendingBlocks = 0;
+    int linesSearched = 0;
+    {
+        QMutexLocker locker(&_state->mutex);
+        pendingBlocks = _state->pendingBlocks;
+        linesSearched = _state->linesSearched;
+    }
+
+    emit progressChanged(linesSearched, _totalLines);
+
+    // poll less often while only waiting for the thread pool
+    _timer->setInterval(linesQueued > 0 ? 0 : 20);
+
+    if (linesQueued == 0 && pendingBlocks == 0) {
+        // everything has been searched, pick up the results of the last blocks
+        collectResults();
+        if (_running)
+            finish(true);
+    }
+}
+bool SearchAllSessionsTask::queueNextBlock(int& linesQueued)
+{
+    // keep the number of blocks waiting for a thread small, so that copies
+    // of the output don't pile up faster than they can be searched
+    {
+        QMutexLocker locker(&_state->mutex);
+        if (_state->pendingBlocks >= 2 * QThread::idealThreadCount())
+            return false;
+    }
+
+    // find the next session with output left to copy, round-robin so that
+    // the most recent output of every session is searched first
+    for (int i = 0; i < _cursors.count(); i++) {
+        const int index = (_nextCursor + i) % _cursors.count();
+        Cursor& cursor = _cursors[index];
+
+        if (cursor.nextEndLine <= 0)
+            continue;
+
+        if (!cursor.session) {
+            cursor.nextEndLine = 0;
+            continue;
+        }
+
+        // the output may have been cleared since the search began
+        const int lineCount = cursor.session->emulation()->lineCount();
+        const int endLine = qMin(cursor.nextEndLine, lineCount);
+        const int startLine = qMax(0, endLine - SEARCH_BLOCK_LINES);
+        cursor.nextEndLine = startLine;
+
+        _nextCursor = (index + 1) % _cursors.count();
+
+        if (endLine <= startLine)
+            return true;
+
+        LineBlock block;
+        cursor.session->emulation()->copyLines(&block, startLine, endLine - 1);
+
+        PlainTextDecoder decoder;
+        ParallelLineDecoder parallelDecoder(&decoder);
+        const QString string = parallelDecoder.decode(block);
+
+        // split the block into lines using the positions recorded while decoding
+        const QVector<int> positions = parallelDecoder.linePositions();
+        const int count = positions.count();
+        QStringList lines;
+        for (int line = 0; line < count; line++) {
+            const int start = positions[line];
+            const int end = (line + 1 < positions.count()) ? positions[line + 1] : string.length();
+            QString text = string.mid(start, end - start);
+            if (text.endsWith('\n'))
+                text.chop(1);
+            lines << text;
+        }
+
+        {
+            QMutexLocker locker(&_state->mutex);
+            _state->pendingBlocks++;
+        }
+        QThreadPool::globalInstance()->start(new SearchAllSessionsJob(_state, index, startLine,
+                                             lines, _regExp));
+
+        linesQueued += count;
+        return true;
+    }
+
+    return false;
+}
+void SearchAllSessionsTask::collectResults()
+{
+    QList<SearchAllSessionsState::BlockResult> results;
+    {
+        QMutexLocker locker(&_state->mutex);
+        results.swap(_state->results);
+    }
+
+    QList<Match> matches;
+    foreach(const SearchAllSessionsState::BlockResult& result, results) {
+        const Cursor& cursor = _cursors[result.cursor];
+        if (!cursor.session)
+            continue;
+
+        for (int i = 0; i < result.lines.count() && _matchCount < _maximumMatches; i++) {
+            Match match;
+            match.session = cursor.session;
+            match.line = result.lines[i];
+            match.text = result.texts[i];
+            match.distance = cursor.lineCount - 1 - match.line;
+            matches << match;
+            _matchCount++;
+        }
+    }
+
+    if (!matches.isEmpty())
+        emit matchesFound(matches);
+
+    if (_running && _matchCount >= _maximumMatches)
+        finish(true);
+}
+void SearchAllSessionsTask::finish(bool success)
+{
+    _running = false;
+    _timer->stop();
+    _state->cancelled = 1;
+
+    emit completed(success);
+
+    if (autoDelete())
+        deleteLater();
+}
+
 QString SessionController::userTitle() const
 {
     if (_session) {
@@ -22,11 +22,15 @@
 #define SESSIONCONTROLLER_H
 
 // Qt
+#include <QtCore/QElapsedTimer>
 #include <QtCore/QList>
 #include <QtCore/QSet>
 #include <QtCore/QPointer>
 #include <QtCore/QString>
 #include <QtCore/QHash>
+#include <QtCore/QRegExp>
+#include <QtCore/QSharedPointer>
+#include <QtCore/QVector>
 
 // KDE
 #include <KIcon>
@@ -54,6 +58,7 @@ class KActionMenu;
 
 namespace Konsole
 {
+class Emulation;
 class Session;
 class SessionGroup;
 class ScreenWindow;
@@ -68,6 +73,197 @@ class TerminalCharacterDecoder;
 
 typedef QPointer<Session> SessionPtr;
 
+/**
+ * The lines of a session's output which contain matches for a search,
+ * kept from one search to the next.
+ *
+ * The lines are found by SessionController's count of the matches, which
+ * searches the output in the background.  Every match for a text is also a
+ * match for the start of that text.  So when a fixed search text is
+ * extended, as happens while the user types it, SearchHistoryTask only has
+ * to look at the lines where the shorter text matched.  Otherwise it finds
+ * the next match with a plain search until the matches have been counted.
+ */
+struct IncrementalSearchState {
+    IncrementalSearchState()
+        : valid(false)
+        , tooManyLines(false)
+        , outputGeneration(0)
+        , lineCount(0) {
+    }
+
+    /** True if lines contains every line with a match for regExp */
+    bool valid;
+    /**
+     * True if regExp matched too many lines to keep.  The output is not
+     * counted again for the same search until it changes
+     */
+    bool tooManyLines;
+    QRegExp regExp;
+    /** See Emulation::outputGeneration() */
+    quint32 outputGeneration;
+    int lineCount;
+    /** The lines which contain the start of a match, in ascending order */
+    QVector<int> lines;
+};
+
+/**
+ * Abstract class representing a task which can be performed on a group of sessions.
+ *
+ * Create a new instance of the appropriate sub-class for the task you want to perform and
+ * call the addSession() method to add each session which needs to be processed.
+ *
+ * Finally, call the execute() method to perform the sub-class specific action on each
+ * of the sessions.
+ */
+class SessionTask : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit SessionTask(QObject* parent = 0);
+
+    /**
+     * Sets whether the task automatically deletes itself when the task has been finished.
+     * Depending on whether the task operates synchronously or asynchronously, the deletion
+     * may be scheduled immediately after execute() returns or it may happen some time later.
+     */
+    void setAutoDelete(bool enable);
+    /** Returns true if the task automatically deletes itself.  See setAutoDelete() */
+    bool autoDelete() const;
+
+    /** Adds a new session to the group */
+    void addSession(Session* session);
+
+    /**
+     * Executes the task on each of the sessions in the group.
+     * The completed() signal is emitted when the task is finished, depending on the specific sub-class
+     * execute() may be synchronous or asynchronous
+     */
+    virtual void execute() = 0;
+
+signals:
+    /**
+     * Emitted when the task has completed.
+     * Depending on the task this may occur just before execute() returns, or it
+     * may occur later
+     *
+     * @param success Indicates whether the task completed successfully or not
+     */
+    void completed(bool success);
+
+protected:
+    /** Returns a list of sessions in the group */
+    QList< SessionPtr > sessions() const;
+
+private:
+    bool _autoDelete;
+    QList< SessionPtr > _sessions;
+};
+
+class SearchAllSessionsState;
+
+/**
+ * A task which finds every line matching a regular expression in the output
+ * of all the sessions added with addSession().
+ *
+ * The output of each session is copied in blocks of lines on the GUI thread,
+ * starting with the most recent output, and the blocks are searched by
+ * QThreadPool::globalInstance().  Only a limited number of blocks are copied
+ * per event loop iteration and in flight at any time, so the user interface
+ * stays responsive and memory use stays bounded no matter how many sessions
+ * or lines of history there are.
+ *
+ * Matches are reported in batches with the matchesFound() signal while the
+ * search is running.  completed() is emitted once every line has been searched,
+ * or maximumMatches() matches have been found.
+ */
+class SearchAllSessionsTask : public SessionTask
+{
+    Q_OBJECT
+
+public:
+    /** Describes a line of output which matches the search. */
+    struct Match {
+        /** The session whose output contains the match. */
+        SessionPtr session;
+        /**
+         * The number of the matching line, counting from the start of the
+         * session's history.  This is suitable for ScreenWindow::scrollTo()
+         */
+        int line;
+        /** The text of the matching line. */
+        QString text;
+        /**
+         * The number of lines between the match and the end of the session's
+         * output.  Matches with a smaller distance are more recent.
+         */
+        int distance;
+    };
+
+    /** Constructs a new search task. */
+    explicit SearchAllSessionsTask(QObject* parent = 0);
+    virtual ~SearchAllSessionsTask();
+
+    /** Sets the regular expression which is searched for when execute() is called */
+    void setRegExp(const QRegExp& regExp);
+    /** Returns the regular expression which is searched for when execute() is called */
+    QRegExp regExp() const;
+
+    /**
+     * Sets the number of matches after which the search stops.
+     * Defaults to 1000.
+     */
+    void setMaximumMatches(int count);
+    /** Returns the number of matches after which the search stops. */
+    int maximumMatches() const;
+
+    /**
+     * Starts searching the output of the sessions added with addSession().
+     * The search continues asynchronously after execute() returns.
+     */
+    virtual void execute();
+
+    /** Stops a search which is in progress and emits completed(false) */
+    void cancel();
+
+signals:
+    /** Emitted with each batch of matches as they are found. */
+    void matchesFound(const QList<SearchAllSessionsTask::Match>& matches);
+
+    /**
+     * Emitted periodically while the search is running with the number of
+     * lines which have been searched so far and the total number of lines.
+     */
+    void progressChanged(int linesSearched , int totalLines);
+
+private slots:
+    void processBlocks();
+
+private:
+    // position of the next block to copy from a session's output,
+    // blocks are copied from the end of the output towards the start
+    struct Cursor {
+        SessionPtr session;
+        int lineCount;
+        int nextEndLine;
+    };
+
+    void collectResults();
+    bool queueNextBlock(int& linesQueued);
+    void finish(bool success);
+
+    QRegExp _regExp;
+    int _maximumMatches;
+    int _matchCount;
+    int _totalLines;
+    int _nextCursor;
+    bool _running;
+    QList<Cursor> _cursors;
+    QTimer* _timer;
+    QSharedPointer<SearchAllSessionsState> _state;
+};
+
 /**
  * Provides the menu actions to manipulate a single terminal session and view pair.
  * The actions provided by this class are defined in the sessionui.rc XML file.
@@ -154,6 +350,13 @@ public:
     // Reimplemented to watch for events happening to the view
     virtual bool eventFilter(QObject* watched , QEvent* event);
 
+    /**
+     * Creates the actions of this controller, if that has not been done
+     * yet.  This happens lazily, when the controller is activated or its
+     * context menu is shown, since many tabs are never visited.
+     */
+    void setupActions();
+
     /** Returns the set of all controllers that exist. */
     static QSet<SessionController*> allControllers() {
         return _allControllers;
@@ -195,7 +398,7 @@ public slots:
     /**
      * update actions which are closely related with the selected text.
      */
-    void selectionChanged(const QString& selectedText);
+    void selectionChanged(bool hasSelection);
 
     /**
      * close the associated session. This might involve user interaction for
@@ -250,6 +453,12 @@ private slots:
     void sessionTitleChanged();
     void searchTextChanged(const QString& text);
     void searchCompleted(bool success);
+    // counts the matches for the current search in the background and
+    // shows them in the search bar and on the view's scroll bar
+    void updateMatchCount();
+    void scheduleMatchCountUpdate();
+    void addCountedMatches(const QList<SearchAllSessionsTask::Match>& matches);
+    void matchCountCompleted(bool success);
     void searchClosed(); // called when the user clicks on the
     // history search bar's close button
 
@@ -262,6 +471,7 @@ private slots:
     void highlightMatches(bool highlight);
     void scrollBackOptionsChanged(int mode , int lines);
     void sessionResizeRequest(const QSize& size);
+    void sessionClipboardChangeRequest(const QString& targets, const QString& text);
     void trackOutput(QKeyEvent* event);  // move view to end of current output
     // when a key press occurs in the
     // display area
@@ -275,7 +485,7 @@ private slots:
     bool isKonsolePart() const;
 
     // update actions related with selected text
-    void updateCopyAction(const QString& selectedText);
+    void updateCopyAction(bool hasSelection);
     void updateWebSearchMenu();
 
 private:
@@ -284,6 +494,15 @@ private:
     // direction - value from SearchHistoryTask::SearchDirection enum to specify
     //             the search direction
     void beginSearch(const QString& text , int direction);
+    // returns the expression to search for with the search bar's options
+    QRegExp searchRegExp(const QString& text) const;
+    // returns true if _incrementalSearch holds every line matching regExp,
+    // or records that there are too many of them
+    // in the current output
+    bool isIncrementalSearchCurrent(const QRegExp& regExp) const;
+    void startCountingMatches(const QRegExp& regExp);
+    void stopCountingMatches();
+    void showMatchCount();
     void setupCommonActions();
     void setupExtraActions();
     void removeSearchFilter(); // remove and delete the current search filter if set
@@ -305,6 +524,19 @@ private:
 
     UrlFilter*      _viewUrlFilter;
     RegExpFilter*   _searchFilter;
+    IncrementalSearchState _incrementalSearch;
+
+    // the lines with matches for _matchCountRegExp shown by showMatchCount(),
+    // _matchLineCount is negative if they have not been counted
+    QRegExp _matchCountRegExp;
+    quint32 _matchCountGeneration;
+    QVector<int> _matchLines;
+    int _matchLineCount;
+    QVector<int> _countedMatchLines;
+    QPointer<SearchAllSessionsTask> _matchCountTask;
+    QTimer* _matchCountTimer;
+    // started when the first output change since the last count arrives
+    QElapsedTimer _matchCountDelay;
 
     KAction* _copyInputToAllTabsAction;
 
@@ -328,7 +560,7 @@ private:
 
     bool _keepIconUntilInteraction;
 
-    QString _selectedText;
+    bool _hasSelection;
 
     QAction* _showMenuAction;
 
@@ -341,66 +573,15 @@ private:
     QStringList _bookmarkValidProgramsToClear;
 
     bool _isSearchBarEnabled;
+
+    bool _actionsCreated;
+    bool _primaryScreenInUse;
 };
 inline bool SessionController::isValid() const
 {
     return !_session.isNull() && !_view.isNull();
 }
 
-/**
- * Abstract class representing a task which can be performed on a group of sessions.
- *
- * Create a new instance of the appropriate sub-class for the task you want to perform and
- * call the addSession() method to add each session which needs to be processed.
- *
- * Finally, call the execute() method to perform the sub-class specific action on each
- * of the sessions.
- */
-class SessionTask : public QObject
-{
-    Q_OBJECT
-
-public:
-    explicit SessionTask(QObject* parent = 0);
-
-    /**
-     * Sets whether the task automatically deletes itself when the task has been finished.
-     * Depending on whether the task operates synchronously or asynchronously, the deletion
-     * may be scheduled immediately after execute() returns or it may happen some time later.
-     */
-    void setAutoDelete(bool enable);
-    /** Returns true if the task automatically deletes itself.  See setAutoDelete() */
-    bool autoDelete() const;
-
-    /** Adds a new session to the group */
-    void addSession(Session* session);
-
-    /**
-     * Executes the task on each of the sessions in the group.
-     * The completed() signal is emitted when the task is finished, depending on the specific sub-class
-     * execute() may be synchronous or asynchronous
-     */
-    virtual void execute() = 0;
-
-signals:
-    /**
-     * Emitted when the task has completed.
-     * Depending on the task this may occur just before execute() returns, or it
-     * may occur later
-     *
-     * @param success Indicates whether the task completed successfully or not
-     */
-    void completed(bool success);
-
-protected:
-    /** Returns a list of sessions in the group */
-    QList< SessionPtr > sessions() const;
-
-private:
-    bool _autoDelete;
-    QList< SessionPtr > _sessions;
-};
-
 /**
  * A task which prompts for a URL for each session and saves that session's output
  * to the given URL
@@ -491,6 +672,14 @@ public:
     /** Returns the current search direction.  See setSearchDirection(). */
     SearchDirection searchDirection() const;
 
+    /**
+     * Sets the state which is used and updated by fixed string searches so
+     * that searching for an extended text only needs to look at the lines
+     * which matched before.  The state must remain valid until the task is
+     * finished, and may only be used with the output of one screen window.
+     */
+    void setIncrementalState(IncrementalSearchState* state);
+
     /**
      * Performs a search through the session's history, starting at the position
      * of the current selection, in the direction specified by setSearchDirection().
@@ -509,12 +698,19 @@ private:
     void executeOnScreenWindow(SessionPtr session , ScreenWindowPtr window);
     void highlightResult(ScreenWindowPtr window , int position);
 
+    // brings the lines in _incrementalState up to date for the current
+    // search text, if they are known or can be found among the lines
+    // matching a shorter text.  returns false otherwise
+    bool updateMatchingLines(Emulation* emulation);
+
     QMap< SessionPtr , ScreenWindowPtr > _windows;
     QRegExp _regExp;
     SearchDirection _direction;
+    IncrementalSearchState* _incrementalState;
 
     //static QPointer<SearchHistoryThread> _thread;
 };
+
 }
 
 #endif //SESSIONCONTROLLER_H
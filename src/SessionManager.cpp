@@ -209,7 +209,8 @@ void SessionManager::applyProfile(Session* session, const Profile::Ptr profile ,
                                    profile->remoteTabTitleFormat());
 
     // History
-    if (apply.shouldApply(Profile::HistoryMode) || apply.shouldApply(Profile::HistorySize)) {
+    if (apply.shouldApply(Profile::HistoryMode) || apply.shouldApply(Profile::HistorySize)
+            || apply.shouldApply(Profile::HistoryDeduplication)) {
         const int mode = profile->property<int>(Profile::HistoryMode);
         switch (mode) {
         case Enum::NoHistory:
@@ -218,7 +219,8 @@ void SessionManager::applyProfile(Session* session, const Profile::Ptr profile ,
 
         case Enum::FixedSizeHistory: {
             int lines = profile->historySize();
-            session->setHistoryType(CompactHistoryType(lines));
+            bool deduplicate = profile->property<bool>(Profile::HistoryDeduplication);
+            session->setHistoryType(CompactHistoryType(lines, deduplicate));
         }
         break;
 
@@ -231,6 +233,10 @@ void SessionManager::applyProfile(Session* session, const Profile::Ptr profile ,
     // Terminal features
     if (apply.shouldApply(Profile::FlowControlEnabled))
         session->setFlowControlEnabled(profile->flowControlEnabled());
+    if (apply.shouldApply(Profile::ClipboardPayloadLimit))
+        session->setClipboardPayloadLimit(profile->property<int>(Profile::ClipboardPayloadLimit));
+    if (apply.shouldApply(Profile::DiscardBinaryOutput))
+        session->setBinaryOutputGuardEnabled(profile->property<bool>(Profile::DiscardBinaryOutput));
 
     // Encoding
     if (apply.shouldApply(Profile::DefaultEncoding)) {
@@ -0,0 +1,96 @@
+/*
+    Copyright 2013 by Konsole Developers <konsole-devel@kde.org>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+    02110-1301  USA.
+*/
+
+// Own
+#include "SessionUsage.h"
+
+using namespace Konsole;
+
+int SessionUsage::Scope::_depth = 0;
+
+SessionUsage::SessionUsage()
+{
+    const Sample empty = { 0, 0, 0, 0, 0 };
+    _totals = empty;
+    _previousSample = empty;
+    _lastSample = empty;
+
+    _clock.start();
+}
+
+void SessionUsage::addReceivedBytes(int bytes)
+{
+    _totals.bytes += bytes;
+}
+
+void SessionUsage::addFrame()
+{
+    _totals.frames++;
+}
+
+void SessionUsage::addSkippedHistoryLines(qint64 lines)
+{
+    _totals.skippedHistoryLines += lines;
+}
+
+SessionUsage::Rates SessionUsage::rates()
+{
+    const qint64 now = _clock.elapsed();
+    if (now - _lastSample.time >= SAMPLE_INTERVAL) {
+        _previousSample = _lastSample;
+        _lastSample = _totals;
+        _lastSample.time = now;
+    }
+
+    // during the first second, report the rates since the usage was created
+    Sample from = _previousSample;
+    Sample to = _lastSample;
+    if (to.time == 0) {
+        to = _totals;
+        to.time = now;
+    }
+
+    Rates rates = { 0, 0, 0, 0 };
+    const double seconds = (to.time - from.time) / 1000.0;
+    if (seconds > 0) {
+        rates.cpuMilliseconds = (to.cpuNanoseconds - from.cpuNanoseconds) / 1000000.0 / seconds;
+        rates.bytes = (to.bytes - from.bytes) / seconds;
+        rates.frames = (to.frames - from.frames) / seconds;
+        rates.skippedHistoryLines = (to.skippedHistoryLines - from.skippedHistoryLines) / seconds;
+    }
+
+    return rates;
+}
+
+SessionUsage::Scope::Scope(SessionUsage* usage)
+    : _usage(_depth == 0 ? usage : 0)
+{
+    _depth++;
+
+    if (_usage)
+        _timer.start();
+}
+
+SessionUsage::Scope::~Scope()
+{
+    _depth--;
+
+    if (_usage)
+        _usage->_totals.cpuNanoseconds += _timer.nsecsElapsed();
+}
@@ -0,0 +1,118 @@
+/*
+    Copyright 2013 by Konsole Developers <konsole-devel@kde.org>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+    02110-1301  USA.
+*/
+
+#ifndef SESSIONUSAGE_H
+#define SESSIONUSAGE_H
+
+// Qt
+#include <QtCore/QElapsedTimer>
+
+namespace Konsole
+{
+
+/**
+ * Records the work which the GUI thread does on behalf of a session, so
+ * that the sessions responsible for a busy GUI thread can be found.
+ *
+ * All sessions share the GUI thread, so the time spent processing a
+ * session's output, updating and painting its views and finding the
+ * hotspots in them is measured with a Scope around each of those calls.
+ * The time is wall-clock time spent in the calls, which is CPU time as long
+ * as they don't block.  The output received and the display updates are
+ * counted as well.
+ */
+class SessionUsage
+{
+public:
+    SessionUsage();
+
+    /** Counts @p bytes of output received from the terminal program. */
+    void addReceivedBytes(int bytes);
+    /** Counts an update of the session's image which is sent to its views. */
+    void addFrame();
+    /**
+     * Counts @p lines which were dropped from the history without being
+     * compacted because output arrived faster than it could be displayed.
+     */
+    void addSkippedHistoryLines(qint64 lines);
+
+    struct Rates {
+        /** Milliseconds per second spent on the session by the GUI thread. */
+        double cpuMilliseconds;
+        /** Bytes of output received per second. */
+        double bytes;
+        /** Image updates per second. */
+        double frames;
+        /** History lines per second which were dropped without being compacted. */
+        double skippedHistoryLines;
+    };
+
+    /**
+     * Returns the average rates between the last two samples of the usage.
+     * A sample is taken when the last one is at least a second old, so
+     * calling this about once a second gives the rates for the last second.
+     */
+    Rates rates();
+
+    /**
+     * Attributes the time until it is destroyed to a session.
+     *
+     * A scope which is created while another scope exists records nothing,
+     * so that the time spent in nested calls, such as the views being
+     * updated by the emulation, is only counted once.  It is attributed to
+     * the session of the outermost scope.
+     */
+    class Scope
+    {
+    public:
+        /** Creates a scope for @p usage, which may be null to record nothing */
+        explicit Scope(SessionUsage* usage);
+        ~Scope();
+
+    private:
+        Q_DISABLE_COPY(Scope)
+
+        SessionUsage* _usage;
+        QElapsedTimer _timer;
+
+        // number of scopes which exist, only used from the GUI thread
+        static int _depth;
+    };
+
+private:
+    struct Sample {
+        qint64 time;
+        qint64 cpuNanoseconds;
+        qint64 bytes;
+        qint64 frames;
+        qint64 skippedHistoryLines;
+    };
+
+    QElapsedTimer _clock;
+    // totals since the usage was created, the time is unused
+    Sample _totals;
+    Sample _previousSample;
+    Sample _lastSample;
+
+    static const int SAMPLE_INTERVAL = 1000;
+};
+
+}
+
+#endif // SESSIONUSAGE_H
@@ -0,0 +1,127 @@
+/*
+    Copyright 2013 by Konsole Developers <konsole-devel@kde.org>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+    02110-1301  USA.
+*/
+
+// Own
+#include "SessionUsageDialog.h"
+
+// Qt
+#include <QtCore/QTimer>
+#include <QHeaderView>
+#include <QLabel>
+#include <QTreeWidget>
+#include <QVBoxLayout>
+
+// KDE
+#include <KLocalizedString>
+
+// Konsole
+#include "Session.h"
+#include "SessionManager.h"
+
+using namespace Konsole;
+
+// rounds a rate to one decimal place for display
+static double roundRate(double rate)
+{
+    return qRound(rate * 10) / 10.0;
+}
+
+SessionUsageDialog::SessionUsageDialog(QWidget* parent)
+    : KDialog(parent)
+{
+    setCaption(i18nc("@title:window", "Tab Activity"));
+    setButtons(KDialog::Close);
+
+    QWidget* widget = mainWidget();
+
+    QLabel* descriptionLabel = new QLabel(i18nc("@info", "The time Konsole spends on each tab, "
+                                          "in milliseconds per second, with the output "
+                                          "it receives and the updates of its display."), widget);
+    descriptionLabel->setWordWrap(true);
+
+    _usageList = new QTreeWidget(widget);
+    _usageList->setRootIsDecorated(false);
+    _usageList->setUniformRowHeights(true);
+    _usageList->setHeaderLabels(QStringList() << i18nc("@title:column", "Tab")
+                                << i18nc("@title:column", "CPU (ms/s)")
+                                << i18nc("@title:column", "Output (KiB/s)")
+                                << i18nc("@title:column", "Updates/s")
+                                << i18nc("@title:column", "Skipped History Lines/s"));
+    _usageList->header()->setResizeMode(0, QHeaderView::Stretch);
+    _usageList->header()->setStretchLastSection(false);
+    _usageList->setSortingEnabled(true);
+    _usageList->sortByColumn(1, Qt::DescendingOrder);
+
+    QVBoxLayout* layout = new QVBoxLayout(widget);
+    layout->setMargin(0);
+    layout->addWidget(descriptionLabel);
+    layout->addWidget(_usageList);
+
+    _updateTimer = new QTimer(this);
+    _updateTimer->setInterval(1000);
+    connect(_updateTimer, SIGNAL(timeout()), this, SLOT(updateUsage()));
+    _updateTimer->start();
+
+    connect(_usageList, SIGNAL(itemActivated(QTreeWidgetItem*,int)),
+            this, SLOT(itemActivated(QTreeWidgetItem*)));
+
+    updateUsage();
+
+    setInitialSize(QSize(680, 320));
+}
+void SessionUsageDialog::updateUsage()
+{
+    const QList<Session*> sessions = SessionManager::instance()->sessions();
+
+    // remove the sessions which have been closed
+    QMutableHashIterator<Session*, QTreeWidgetItem*> iter(_items);
+    while (iter.hasNext()) {
+        iter.next();
+        if (!sessions.contains(iter.key())) {
+            delete iter.value();
+            iter.remove();
+        }
+    }
+
+    foreach(Session* session, sessions) {
+        QTreeWidgetItem* item = _items.value(session);
+        if (!item) {
+            item = new QTreeWidgetItem(_usageList);
+            for (int column = 1; column < _usageList->columnCount(); column++)
+                item->setTextAlignment(column, Qt::AlignRight | Qt::AlignVCenter);
+            _items.insert(session, item);
+        }
+
+        // the rates are stored as numbers so that the list sorts them as such
+        const SessionUsage::Rates rates = session->usage()->rates();
+        item->setText(0, session->title(Session::DisplayedTitleRole));
+        item->setData(1, Qt::DisplayRole, roundRate(rates.cpuMilliseconds));
+        item->setData(2, Qt::DisplayRole, roundRate(rates.bytes / 1024));
+        item->setData(3, Qt::DisplayRole, roundRate(rates.frames));
+        item->setData(4, Qt::DisplayRole, roundRate(rates.skippedHistoryLines));
+    }
+}
+void SessionUsageDialog::itemActivated(QTreeWidgetItem* item)
+{
+    Session* session = _items.key(item);
+    if (session && SessionManager::instance()->sessions().contains(session))
+        emit sessionActivated(session);
+}
+
+#include "SessionUsageDialog.moc"
@@ -0,0 +1,69 @@
+/*
+    Copyright 2013 by Konsole Developers <konsole-devel@kde.org>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+    02110-1301  USA.
+*/
+
+#ifndef SESSIONUSAGEDIALOG_H
+#define SESSIONUSAGEDIALOG_H
+
+// Qt
+#include <QtCore/QHash>
+
+// KDE
+#include <KDialog>
+
+class QTimer;
+class QTreeWidget;
+class QTreeWidgetItem;
+
+namespace Konsole
+{
+class Session;
+
+/**
+ * A non-modal dialog which lists every session with the time the GUI
+ * thread spends on it, the rate of its output and the rate at which its
+ * image is updated, like top(1).  The list is updated every second and
+ * can be sorted by any column, the busiest sessions first by default.
+ *
+ * Activating a session emits sessionActivated() so that the owner can
+ * show it.
+ */
+class SessionUsageDialog : public KDialog
+{
+    Q_OBJECT
+
+public:
+    explicit SessionUsageDialog(QWidget* parent = 0);
+
+signals:
+    /** Emitted when the user activates a session in the list. */
+    void sessionActivated(Session* session);
+
+private slots:
+    void updateUsage();
+    void itemActivated(QTreeWidgetItem* item);
+
+private:
+    QTreeWidget* _usageList;
+    QTimer* _updateTimer;
+
+    QHash<Session*, QTreeWidgetItem*> _items;
+};
+}
+
+#endif // SESSIONUSAGEDIALOG_H
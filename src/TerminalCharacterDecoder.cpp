@@ -136,9 +136,18 @@ void PlainTextDecoder::decodeLine(const Character* const characters, int count,
     *_output << plainText;
 }
 
+TerminalCharacterDecoder* PlainTextDecoder::clone() const
+{
+    PlainTextDecoder* decoder = new PlainTextDecoder();
+    decoder->setTrailingWhitespace(_includeTrailingWhitespace);
+    decoder->setRecordLinePositions(_recordLinePositions);
+    return decoder;
+}
+
 HTMLDecoder::HTMLDecoder() :
     _output(0)
     , _colorTable(ColorScheme::defaultTable)
+    , _wrapLines(true)
     , _innerSpanOpen(false)
     , _lastRendition(DEFAULT_RENDITION)
 {
@@ -148,6 +157,9 @@ void HTMLDecoder::begin(QTextStream* output)
 {
     _output = output;
 
+    if (!_wrapLines)
+        return;
+
     QString text;
 
     //open monospace span
@@ -160,15 +172,25 @@ void HTMLDecoder::end()
 {
     Q_ASSERT(_output);
 
-    QString text;
+    if (_wrapLines) {
+        QString text;
 
-    closeSpan(text);
+        closeSpan(text);
 
-    *_output << text;
+        *_output << text;
+    }
 
     _output = 0;
 }
 
+TerminalCharacterDecoder* HTMLDecoder::clone() const
+{
+    HTMLDecoder* decoder = new HTMLDecoder();
+    decoder->setColorTable(_colorTable);
+    decoder->_wrapLines = false;
+    return decoder;
+}
+
 //TODO: Support for LineProperty (mainly double width , double height)
 void HTMLDecoder::decodeLine(const Character* const characters, int count, LineProperty /*properties*/
                             )
@@ -249,8 +271,16 @@ void HTMLDecoder::decodeLine(const Character* const characters, int count, LineP
     }
 
     //close any remaining open inner spans
-    if (_innerSpanOpen)
+    if (_innerSpanOpen) {
         closeSpan(text);
+        _innerSpanOpen = false;
+    }
+
+    //every line opens its own span, so that the lines can be decoded
+    //separately and the spans are balanced
+    _lastRendition = DEFAULT_RENDITION;
+    _lastForeColor = CharacterColor();
+    _lastBackColor = CharacterColor();
 
     //start new line
     text.append("<br>");
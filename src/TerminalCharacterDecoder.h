@@ -63,6 +63,14 @@ public:
     virtual void decodeLine(const Character* const characters,
                             int count,
                             LineProperty properties) = 0;
+
+    /**
+     * Returns a new decoder with the same settings as this one, which
+     * ParallelLineDecoder uses to decode a chunk of lines.  The new decoder
+     * only writes the decoded lines to its output, without anything which
+     * begin() and end() would write before and after them.
+     */
+    virtual TerminalCharacterDecoder* clone() const = 0;
 };
 
 /**
@@ -101,6 +109,8 @@ public:
                             int count,
                             LineProperty properties);
 
+    virtual TerminalCharacterDecoder* clone() const;
+
 private:
     QTextStream* _output;
     bool _includeTrailingWhitespace;
@@ -133,12 +143,17 @@ public:
     virtual void begin(QTextStream* output);
     virtual void end();
 
+    virtual TerminalCharacterDecoder* clone() const;
+
 private:
     void openSpan(QString& text , const QString& style);
     void closeSpan(QString& text);
 
     QTextStream* _output;
     const ColorEntry* _colorTable;
+    // false for the copies made by clone(), which leave out the
+    // monospace span written by begin() and end()
+    bool _wrapLines;
     bool _innerSpanOpen;
     quint8 _lastRendition;
     CharacterColor _lastForeColor;
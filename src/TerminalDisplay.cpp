@@ -35,10 +35,15 @@
 #include <QGridLayout>
 #include <QAction>
 #include <QLabel>
+#include <QtGui/QFontDatabase>
 #include <QtGui/QPainter>
 #include <QtGui/QPixmap>
 #include <QScrollBar>
 #include <QStyle>
+#include <QStyleOptionSlider>
+#include <QtCore/QRunnable>
+#include <QtCore/QThread>
+#include <QtCore/QThreadPool>
 #include <QtCore/QTimer>
 #include <QToolTip>
 #include <QtGui/QAccessible>
@@ -50,6 +55,7 @@
 #include <KDebug>
 #include <KLocalizedString>
 #include <KNotification>
+#include <KGlobal>
 #include <KGlobalSettings>
 #include <KIO/NetAccess>
 #if defined(HAVE_LIBKONQ)
@@ -86,6 +92,98 @@ using namespace Konsole;
 // more information can be found in: http://unicode.org/reports/tr9/
 const QChar LTR_OVERRIDE_CHAR(0x202D);
 
+// the smallest number of lines drawn by each thread when rendering in
+// parallel.  smaller tiles are not worth handing to another thread
+const int MIN_RENDER_TILE_LINES = 4;
+
+// threads, apart from the GUI thread, which draw tiles for displays
+// with parallel rendering enabled
+K_GLOBAL_STATIC(QThreadPool, renderThreadPool)
+
+static int renderThreads = QThread::idealThreadCount();
+
+namespace Konsole
+{
+// Draws one tile of a display for TerminalDisplay::drawContentsInParallel()
+class TileRenderJob : public QRunnable
+{
+public:
+    TileRenderJob(TerminalDisplay* display, const QRect& area, QImage* image)
+        : _display(display)
+        , _area(area)
+        , _image(image) {
+    }
+
+    virtual void run() {
+        _display->renderTile(_area, *_image);
+    }
+
+private:
+    TerminalDisplay* _display;
+    QRect _area;
+    QImage* _image;
+};
+
+// Scroll bar which marks the lines with matches for the current search in
+// its groove, see TerminalDisplay::setSearchMatchLines()
+class TerminalScrollBar : public QScrollBar
+{
+public:
+    explicit TerminalScrollBar(QWidget* parent)
+        : QScrollBar(parent)
+        , _lineCount(0) {
+    }
+
+    void setMarkedLines(const QVector<int>& lines, int lineCount) {
+        if (lineCount == _lineCount && lines == _lines)
+            return;
+
+        _lines = lines;
+        _lineCount = lineCount;
+        update();
+    }
+
+protected:
+    virtual void paintEvent(QPaintEvent* event) {
+        QScrollBar::paintEvent(event);
+
+        if (_lines.isEmpty() || _lineCount <= 0)
+            return;
+
+        QStyleOptionSlider option;
+        initStyleOption(&option);
+        const QRect groove = style()->subControlRect(QStyle::CC_ScrollBar, &option,
+                             QStyle::SC_ScrollBarGroove, this);
+        if (groove.height() <= 0)
+            return;
+
+        // in a long output many matching lines fall on the same row of
+        // pixels, so the matches are counted per row and rows with more
+        // matches are drawn more opaque
+        QVector<int> density(groove.height(), 0);
+        foreach(int line, _lines) {
+            const int row = qMin(static_cast<qint64>(line) * groove.height() / _lineCount,
+                                 static_cast<qint64>(groove.height() - 1));
+            density[row]++;
+        }
+
+        QPainter painter(this);
+        QColor color = palette().color(QPalette::Highlight);
+        for (int row = 0; row < density.count(); row++) {
+            if (density[row] == 0)
+                continue;
+
+            color.setAlpha(qMin(255, 128 + 32 * density[row]));
+            painter.fillRect(groove.left(), groove.top() + row, groove.width(), 2, color);
+        }
+    }
+
+private:
+    QVector<int> _lines;
+    int _lineCount;
+};
+}
+
 /* ------------------------------------------------------------------------- */
 /*                                                                           */
 /*                                Colors                                     */
@@ -335,11 +433,14 @@ TerminalDisplay::TerminalDisplay(QWidget* parent)
     , _resizeTimer(0)
     , _flowControlWarningEnabled(false)
     , _outputSuspendedLabel(0)
+    , _outputDiscardedLabel(0)
     , _lineSpacing(0)
     , _blendColor(qRgba(0, 0, 0, 0xff))
     , _filterChain(new TerminalImageFilterChain())
     , _cursorShape(Enum::BlockCursor)
     , _antialiasText(true)
+    , _parallelRendering(false)
+    , _lineDrawing(true)
     , _printerFriendly(false)
     , _sessionController(0)
     , _trimTrailingSpaces(false)
@@ -352,7 +453,7 @@ TerminalDisplay::TerminalDisplay(QWidget* parent)
     _leftMargin = DEFAULT_LEFT_MARGIN;
 
     // create scroll bar for scrolling output up and down
-    _scrollBar = new QScrollBar(this);
+    _scrollBar = new TerminalScrollBar(this);
     // set the scroll bar's slider to occupy the whole area of the scroll bar initially
     setScroll(0, 0);
     _scrollBar->setCursor(Qt::ArrowCursor);
@@ -412,6 +513,7 @@ TerminalDisplay::~TerminalDisplay()
 
     delete _gridLayout;
     delete _outputSuspendedLabel;
+    delete _outputDiscardedLabel;
     delete _filterChain;
 }
 
@@ -535,7 +637,7 @@ static void drawLineChar(QPainter& paint, int x, int y, int w, int h, uchar code
 void TerminalDisplay::drawLineCharString(QPainter& painter, int x, int y, const QString& str,
         const Character* attributes)
 {
-    const QPen& originalPen = painter.pen();
+    const QPen originalPen = painter.pen();
 
     if ((attributes->rendition & RE_BOLD) && _boldIntense) {
         QPen boldPen(originalPen);
@@ -891,6 +993,27 @@ void TerminalDisplay::scrollImage(int lines , const QRect& screenWindowRegion)
         //set region of the display to scroll
         scrollRect.setTop(top + abs(lines) * _fontHeight);
     }
+
+    // move the references to the lines along with them.  the lines which
+    // were moved from still hold the same characters, so their references
+    // stay as they are
+    const int firstLine = region.top();
+    if (_lineReferences.count() >= firstLine + abs(lines) + linesToMove
+            && _blinkingLines.size() >= firstLine + abs(lines) + linesToMove) {
+        if (lines > 0) {
+            for (int line = firstLine; line < firstLine + linesToMove; line++) {
+                _lineReferences[line] = _lineReferences[line + lines];
+                _blinkingLines.setBit(line, _blinkingLines.testBit(line + lines));
+            }
+        } else {
+            for (int line = firstLine + linesToMove - 1; line >= firstLine; line--) {
+                _lineReferences[line - lines] = _lineReferences[line];
+                _blinkingLines.setBit(line - lines, _blinkingLines.testBit(line));
+            }
+        }
+    } else {
+        _lineReferences.clear();
+    }
     scrollRect.setHeight(linesToMove * _fontHeight);
 
     Q_ASSERT(scrollRect.isValid() && !scrollRect.isEmpty());
@@ -933,11 +1056,21 @@ QRegion TerminalDisplay::hotSpotRegion() const
     return region;
 }
 
+SessionUsage* TerminalDisplay::sessionUsage()
+{
+    if (!_sessionController || !_sessionController->session())
+        return 0;
+
+    return _sessionController->session()->usage();
+}
+
 void TerminalDisplay::processFilters()
 {
     if (!_screenWindow)
         return;
 
+    SessionUsage::Scope scope(sessionUsage());
+
     QRegion preUpdateHotSpots = hotSpotRegion();
 
     // use _screenWindow->getImage() here rather than _image because
@@ -961,6 +1094,8 @@ void TerminalDisplay::updateImage()
     if (!_screenWindow)
         return;
 
+    SessionUsage::Scope scope(sessionUsage());
+
     // optimization - scroll the existing image where possible and
     // avoid expensive text drawing for parts of the image that
     // can simply be moved up or down
@@ -977,6 +1112,7 @@ void TerminalDisplay::updateImage()
     }
 
     Character* const newimg = _screenWindow->getImage();
+    const QVector<LineReference> lineReferences = _screenWindow->getLineReferences();
     const int lines = _screenWindow->windowLines();
     const int columns = _screenWindow->windowColumns();
 
@@ -1005,11 +1141,24 @@ void TerminalDisplay::updateImage()
     // which therefore need to be repainted
     int dirtyLineCount = 0;
 
+    _blinkingLines.resize(linesToUpdate);
+
     for (y = 0; y < linesToUpdate; ++y) {
+        const bool doubleHeight = (_lineProperties.count() > y) && (_lineProperties[y] & LINE_DOUBLEHEIGHT);
+
+        // a line which shares its characters with the one already in _image
+        // is unchanged, so comparing the references is enough
+        if (!doubleHeight && y < lineReferences.count() && y < _lineReferences.count()
+                && lineReferences[y].isSameLine(_lineReferences[y])) {
+            _hasTextBlinker |= _blinkingLines.testBit(y);
+            continue;
+        }
+
         const Character* currentLine = &_image[y * this->_columns];
         const Character* const newLine = &newimg[y * columns];
 
         bool updateLine = false;
+        bool lineBlinks = false;
 
         // The dirty mask indicates which characters need repainting. We also
         // mark surrounding neighbors dirty, in case the character exceeds
@@ -1024,7 +1173,7 @@ void TerminalDisplay::updateImage()
 
         if (!_resizing) // not while _resizing, we're expecting a paintEvent
             for (x = 0; x < columnsToUpdate; ++x) {
-                _hasTextBlinker |= (newLine[x].rendition & RE_BLINK);
+                lineBlinks |= (newLine[x].rendition & RE_BLINK);
 
                 // Start drawing if this character or the next one differs.
                 // We also take the next one into account to handle the situation
@@ -1068,12 +1217,14 @@ void TerminalDisplay::updateImage()
                 }
             }
 
+        _hasTextBlinker |= lineBlinks;
+        _blinkingLines.setBit(y, lineBlinks);
+
         //both the top and bottom halves of double height _lines must always be redrawn
         //although both top and bottom halves contain the same characters, only
         //the top one is actually
         //drawn.
-        if (_lineProperties.count() > y)
-            updateLine |= (_lineProperties[y] & LINE_DOUBLEHEIGHT);
+        updateLine |= doubleHeight;
 
         // if the characters on the line are different in the old and the new _image
         // then this line must be repainted.
@@ -1095,6 +1246,10 @@ void TerminalDisplay::updateImage()
         memcpy((void*)currentLine, (const void*)newLine, columnsToUpdate * sizeof(Character));
     }
 
+    // lines beyond the image aren't in _image, so they have no reference
+    _lineReferences = lineReferences;
+    _lineReferences.resize(qMin(_lineReferences.count(), linesToUpdate));
+
     // if the new _image is smaller than the previous _image, then ensure that the area
     // outside the new _image is cleared
     if (linesToUpdate < _usedLines) {
@@ -1162,15 +1317,20 @@ void TerminalDisplay::showResizeNotification()
 
 void TerminalDisplay::paintEvent(QPaintEvent* pe)
 {
+    SessionUsage::Scope scope(sessionUsage());
+
     QPainter paint(this);
+    const QRegion region = pe->region() & contentsRect();
 
-    foreach(const QRect & rect, (pe->region() & contentsRect()).rects()) {
-        drawBackground(paint, rect, palette().background().color(),
-                       true /* use opacity setting */);
-        drawContents(paint, rect);
+    if (!drawContentsInParallel(paint, region)) {
+        foreach(const QRect & rect, region.rects()) {
+            drawBackground(paint, rect, palette().background().color(),
+                           true /* use opacity setting */);
+            drawContents(paint, rect);
+        }
     }
     drawInputMethodPreeditString(paint, preeditRect());
-    paintFilters(paint);
+    paintFilters(paint, region);
 }
 
 void TerminalDisplay::printContent(QPainter& painter, bool friendly)
@@ -1207,8 +1367,21 @@ FilterChain* TerminalDisplay::filterChain() const
     return _filterChain;
 }
 
-void TerminalDisplay::paintFilters(QPainter& painter)
+void TerminalDisplay::paintFilters(QPainter& painter, const QRegion& region)
 {
+    // only the hotspots on the lines in 'region' are drawn, so that small
+    // updates such as the blinking cursor do not draw every hotspot on screen.
+    // the areas of the hotspots drawn below are not offset by the margins
+    const QRect bounds = region.boundingRect();
+    const int firstLine = qMax(0, bounds.top() / _fontHeight);
+    const int lastLine = qMin(_lines - 1, bounds.bottom() / _fontHeight);
+    if (firstLine > lastLine)
+        return;
+
+    const QList<Filter::HotSpot*> spots = _filterChain->hotSpotsInLines(firstLine, lastLine);
+    if (spots.isEmpty())
+        return;
+
     // get color of character under mouse and use it to draw
     // lines for filters
     QPoint cursorPos = mapFromGlobal(QCursor::pos());
@@ -1221,42 +1394,17 @@ void TerminalDisplay::paintFilters(QPainter& painter)
 
     painter.setPen(QPen(cursorCharacter.foregroundColor.color(colorTable())));
 
+    // the link under the mouse is underlined
+    const Filter::HotSpot* mouseOverSpot = contentsRect().contains(cursorPos) ?
+                                           _filterChain->hotSpotAt(cursorLine, cursorColumn) : 0;
+
     // iterate over hotspots identified by the display's currently active filters
     // and draw appropriate visuals to indicate the presence of the hotspot
-
-    QList<Filter::HotSpot*> spots = _filterChain->hotSpots();
     foreach(Filter::HotSpot* spot, spots) {
-        QRegion region;
-        if (_underlineLinks && spot->type() == Filter::HotSpot::Link) {
-            QRect r;
-            if (spot->startLine() == spot->endLine()) {
-                r.setCoords(spot->startColumn()*_fontWidth + 1 + scrollBarWidth,
-                            spot->startLine()*_fontHeight + 1,
-                            (spot->endColumn() - 1)*_fontWidth - 1 + scrollBarWidth,
-                            (spot->endLine() + 1)*_fontHeight - 1);
-                region |= r;
-            } else {
-                r.setCoords(spot->startColumn()*_fontWidth + 1 + scrollBarWidth,
-                            spot->startLine()*_fontHeight + 1,
-                            (_columns - 1)*_fontWidth - 1 + scrollBarWidth,
-                            (spot->startLine() + 1)*_fontHeight - 1);
-                region |= r;
-                for (int line = spot->startLine() + 1 ; line < spot->endLine() ; line++) {
-                    r.setCoords(0 * _fontWidth + 1 + scrollBarWidth,
-                                line * _fontHeight + 1,
-                                (_columns - 1)*_fontWidth - 1 + scrollBarWidth,
-                                (line + 1)*_fontHeight - 1);
-                    region |= r;
-                }
-                r.setCoords(0 * _fontWidth + 1 + scrollBarWidth,
-                            spot->endLine()*_fontHeight + 1,
-                            (spot->endColumn() - 1)*_fontWidth - 1 + scrollBarWidth,
-                            (spot->endLine() + 1)*_fontHeight - 1);
-                region |= r;
-            }
-        }
+        const int spotFirstLine = qMax(spot->startLine(), firstLine);
+        const int spotLastLine = qMin(spot->endLine(), lastLine);
 
-        for (int line = spot->startLine() ; line <= spot->endLine() ; line++) {
+        for (int line = spotFirstLine ; line <= spotLastLine ; line++) {
             int startColumn = 0;
             int endColumn = _columns - 1; // TODO use number of _columns which are actually
             // occupied on this line rather than the width of the
@@ -1291,14 +1439,14 @@ void TerminalDisplay::paintFilters(QPainter& painter)
                         (line + 1)*_fontHeight - 1);
             // Underline link hotspots
             if (_underlineLinks && spot->type() == Filter::HotSpot::Link) {
-                QFontMetrics metrics(font());
-
-                // find the baseline (which is the invisible line that the characters in the font sit on,
-                // with some having tails dangling below)
-                const int baseline = r.bottom() - metrics.descent();
-                // find the position of the underline below that
-                const int underlinePos = baseline + metrics.underlinePos();
-                if (region.contains(mapFromGlobal(QCursor::pos()))) {
+                if (spot == mouseOverSpot) {
+                    QFontMetrics metrics(font());
+
+                    // find the baseline (which is the invisible line that the characters in the font sit on,
+                    // with some having tails dangling below)
+                    const int baseline = r.bottom() - metrics.descent();
+                    // find the position of the underline below that
+                    const int underlinePos = baseline + metrics.underlinePos();
                     painter.drawLine(r.left() , underlinePos ,
                                      r.right() , underlinePos);
                 }
@@ -1325,7 +1473,22 @@ void TerminalDisplay::drawContents(QPainter& paint, const QRect& rect)
     const int numberOfColumns = _usedColumns;
     QString unistr;
     unistr.reserve(numberOfColumns);
+
+    // the fragments of the current line and their text, when the line is
+    // drawn by drawLineFragments()
+    QVector<TextFragment> fragments;
+    QString lineText;
+    lineText.reserve(numberOfColumns);
+
     for (int y = luy; y <= rly; y++) {
+        // printed output and lines with double width or height characters,
+        // which are drawn with a scaled painter, are drawn a fragment at a time
+        const bool drawLine = _lineDrawing && !_printerFriendly &&
+                              !(y < _lineProperties.size() &&
+                                (_lineProperties[y] & (LINE_DOUBLEWIDTH | LINE_DOUBLEHEIGHT)));
+        fragments.clear();
+        lineText.clear();
+
         int x = lux;
         if (!_image[loc(lux, y)].character && x)
             x--; // Search for start of multi-column character
@@ -1404,13 +1567,21 @@ void TerminalDisplay::drawContents(QPainter& paint, const QRect& rect)
             if ((x + len < _usedColumns) && (!_image[loc(x + len, y)].character))
                 len++; // Adjust for trailing part of multi-column character
 
-            const bool save__fixedFont = _fixedFont;
-            if (lineDraw)
-                _fixedFont = false;
-            if (doubleWidth)
-                _fixedFont = false;
             unistr.resize(p);
 
+            if (drawLine) {
+                TextFragment fragment;
+                fragment.area = QRect(_leftMargin + tLx + _fontWidth * x , _topMargin + tLy + _fontHeight * y , _fontWidth * len , _fontHeight);
+                fragment.start = lineText.length();
+                fragment.length = unistr.length();
+                fragment.style = &_image[loc(x, y)];
+                fragments << fragment;
+                lineText += unistr;
+
+                x += len - 1;
+                continue;
+            }
+
             // Create a text scaling matrix for double width and double height lines.
             QMatrix textScale;
 
@@ -1449,8 +1620,6 @@ void TerminalDisplay::drawContents(QPainter& paint, const QRect& rect)
                                  &_image[loc(x, y)]);
             }
 
-            _fixedFont = save__fixedFont;
-
             //reset back to single-width, single-height _lines
             paint.setWorldMatrix(textScale.inverted(), true);
 
@@ -1466,7 +1635,151 @@ void TerminalDisplay::drawContents(QPainter& paint, const QRect& rect)
 
             x += len - 1;
         }
+
+        if (!fragments.isEmpty())
+            drawLineFragments(paint, fragments, lineText);
+    }
+}
+
+void TerminalDisplay::drawLineFragments(QPainter& painter,
+                                        const QVector<TextFragment>& fragments,
+                                        const QString& text)
+{
+    painter.save();
+
+    const QColor displayBackground = palette().background().color();
+    const QRect scrollBarArea = _scrollBar->isVisible() ? _scrollBar->geometry() : QRect();
+
+    // each fragment's background is drawn just before its text, as in
+    // drawTextFragment(), so that the part of a glyph which overhangs into
+    // the next fragment is covered by that fragment's background in the
+    // same way
+    for (int i = 0; i < fragments.count(); i++) {
+        const TextFragment& fragment = fragments[i];
+        const Character* style = fragment.style;
+        const QColor foregroundColor = style->foregroundColor.color(_colorTable);
+        const QColor backgroundColor = style->backgroundColor.color(_colorTable);
+
+        if (backgroundColor != displayBackground) {
+            // drawBackground() keeps the area behind the scroll bar in the
+            // scroll bar's colors, which is only needed next to it
+            if (fragment.area.intersects(scrollBarArea))
+                drawBackground(painter, fragment.area, backgroundColor, false);
+            else
+                painter.fillRect(fragment.area, backgroundColor);
+        }
+
+        bool invertCharacterColor = false;
+        if (style->rendition & RE_CURSOR)
+            drawCursor(painter, fragment.area, foregroundColor, backgroundColor, invertCharacterColor);
+
+        // drawCharacters() only changes the painter's font and pen when they
+        // differ from the previous fragment's
+        drawCharacters(painter, fragment.area,
+                       QString::fromRawData(text.constData() + fragment.start, fragment.length),
+                       style, invertCharacterColor);
     }
+
+    painter.restore();
+}
+
+void TerminalDisplay::setRenderThreadCount(int count)
+{
+    renderThreads = qMax(1, count);
+    renderThreadPool->setMaxThreadCount(qMax(1, renderThreads - 1));
+}
+
+int TerminalDisplay::renderThreadCount()
+{
+    return renderThreads;
+}
+
+bool TerminalDisplay::drawContentsInParallel(QPainter& paint, const QRegion& region)
+{
+    if (!_parallelRendering || renderThreads < 2 || _printerFriendly || _usedLines < 1)
+        return false;
+
+    // text can only be drawn outside of the GUI thread if the platform's
+    // font rendering is thread safe, which it is not with some X11 setups
+    static const bool threadedFontRendering = QFontDatabase::supportsThreadedFontRendering();
+    if (!threadedFontRendering)
+        return false;
+
+    // the tiles are filled with the background color before the text is drawn
+    // on them, so that text is antialiased the same way as when it is drawn on
+    // the display directly.  that is not possible with a wallpaper or a
+    // transparent background
+    if (!_wallpaper->isNull() || qAlpha(_blendColor) < 0xff)
+        return false;
+
+    const QRect bounds = region.boundingRect();
+    const int top = contentsRect().top() + _topMargin;
+    const int firstLine = qMin(_usedLines - 1, qMax(0, (bounds.top() - top) / _fontHeight));
+    const int lastLine = qMin(_usedLines - 1, qMax(0, (bounds.bottom() - top) / _fontHeight));
+    const int lineCount = lastLine - firstLine + 1;
+
+    const int tileCount = qMin(renderThreads, lineCount / MIN_RENDER_TILE_LINES);
+    if (tileCount < 2)
+        return false;
+
+    // double height lines are drawn across two lines, which may end up in
+    // different tiles
+    for (int line = firstLine; line <= lastLine && line < _lineProperties.size(); line++) {
+        if (_lineProperties[line] & LINE_DOUBLEHEIGHT)
+            return false;
+    }
+
+    QVector<QRect> areas(tileCount);
+    QVector<QImage> images(tileCount);
+    for (int i = 0; i < tileCount; i++) {
+        const int tileFirstLine = firstLine + lineCount * i / tileCount;
+        const int tileLines = firstLine + lineCount * (i + 1) / tileCount - tileFirstLine;
+        areas[i] = QRect(bounds.left(), top + tileFirstLine * _fontHeight,
+                         bounds.width(), tileLines * _fontHeight);
+    }
+
+    // draw the first tile in this thread while the render threads draw
+    // the others.  nothing else may change the display until they are done
+    for (int i = 1; i < tileCount; i++)
+        renderThreadPool->start(new TileRenderJob(this, areas[i], &images[i]));
+    renderTile(areas[0], images[0]);
+    renderThreadPool->waitForDone();
+
+    foreach(const QRect & rect, region.rects()) {
+        drawBackground(paint, rect, palette().background().color(),
+                       true /* use opacity setting */);
+    }
+
+    QRegion tileRegion = region;
+    if (_scrollBar->isVisible())
+        tileRegion -= _scrollBar->geometry();
+
+    paint.save();
+    paint.setClipRegion(tileRegion);
+    for (int i = 0; i < tileCount; i++) {
+        // each tile image includes the line above and below the tile, see renderTile()
+        paint.drawImage(areas[i].topLeft(), images[i],
+                        QRect(QPoint(0, _fontHeight), areas[i].size()));
+    }
+    paint.restore();
+
+    return true;
+}
+
+void TerminalDisplay::renderTile(const QRect& area, QImage& image)
+{
+    // the lines above and below the tile are drawn as well, because parts of
+    // their characters may reach into the tile, as they would when all lines
+    // are drawn on the display in order
+    const QRect drawnArea = area.adjusted(0, -_fontHeight, 0, _fontHeight);
+
+    image = QImage(drawnArea.size(), QImage::Format_RGB32);
+    image.fill(palette().background().color().rgb());
+
+    QPainter painter(&image);
+    painter.setFont(font());
+    painter.translate(-drawnArea.topLeft());
+    drawContents(painter, drawnArea);
 }
 
 QRect TerminalDisplay::imageToWidget(const QRect& imageArea) const
@@ -1600,6 +1913,9 @@ void TerminalDisplay::propagateSize()
 
 void TerminalDisplay::updateImageSize()
 {
+    // the lines of the new image are compared in full the first time
+    _lineReferences.clear();
+
     Character* oldImage = _image;
     const int oldLines = _lines;
     const int oldColumns = _columns;
@@ -1805,6 +2121,11 @@ void TerminalDisplay::setScroll(int cursor, int slines)
     connect(_scrollBar, SIGNAL(valueChanged(int)), this, SLOT(scrollBarPositionChanged(int)));
 }
 
+void TerminalDisplay::setSearchMatchLines(const QVector<int>& lines, int lineCount)
+{
+    _scrollBar->setMarkedLines(lines, lineCount);
+}
+
 /* ------------------------------------------------------------------------- */
 /*                                                                           */
 /*                                  Mouse                                    */
@@ -2793,6 +3114,41 @@ void TerminalDisplay::outputSuspended(bool suspended)
     _outputSuspendedLabel->setVisible(suspended);
 }
 
+void TerminalDisplay::outputDiscarded(bool discarded)
+{
+    //create the label when this function is first called
+    if (!_outputDiscardedLabel) {
+        _outputDiscardedLabel = new QLabel(i18n("<qt>The output looks like binary data "
+                                                "and is being discarded.  "
+                                                "<a href=\"resume\">Resume output</a></qt>"),
+                                           this);
+
+        QPalette palette(_outputDiscardedLabel->palette());
+        KColorScheme::adjustBackground(palette, KColorScheme::NeutralBackground);
+        _outputDiscardedLabel->setPalette(palette);
+        _outputDiscardedLabel->setAutoFillBackground(true);
+        _outputDiscardedLabel->setBackgroundRole(QPalette::Base);
+        _outputDiscardedLabel->setFont(KGlobalSettings::generalFont());
+        _outputDiscardedLabel->setContentsMargins(5, 5, 5, 5);
+        _outputDiscardedLabel->setTextInteractionFlags(Qt::LinksAccessibleByMouse |
+                Qt::LinksAccessibleByKeyboard);
+        _outputDiscardedLabel->setVisible(false);
+
+        connect(_outputDiscardedLabel, SIGNAL(linkActivated(QString)),
+                this, SIGNAL(resumeOutputRequest()));
+
+        // shown at the bottom of the display, below the flow control warning
+        _gridLayout->addWidget(_outputDiscardedLabel, 2, 0);
+        if (!_gridLayout->itemAtPosition(1, 0)) {
+            _gridLayout->addItem(new QSpacerItem(0, 0, QSizePolicy::Expanding,
+                                                 QSizePolicy::Expanding),
+                                 1, 0);
+        }
+    }
+
+    _outputDiscardedLabel->setVisible(discarded);
+}
+
 void TerminalDisplay::scrollScreenWindow(enum ScreenWindow::RelativeScrollMode mode, int amount)
 {
     _screenWindow->scrollBy(mode, amount);
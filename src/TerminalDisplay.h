@@ -23,6 +23,7 @@
 
 // Qt
 #include <QtGui/QColor>
+#include <QtCore/QBitArray>
 #include <QtCore/QPointer>
 #include <QWidget>
 
@@ -44,6 +45,7 @@ class QKeyEvent;
 class QScrollBar;
 class QShowEvent;
 class QHideEvent;
+class QImage;
 class QTimerEvent;
 
 namespace Konsole
@@ -51,6 +53,8 @@ namespace Konsole
 class FilterChain;
 class TerminalImageFilterChain;
 class SessionController;
+class SessionUsage;
+class TerminalScrollBar;
 
 /**
  * A widget which displays output from a terminal emulation and sends input keypresses and mouse activity
@@ -105,6 +109,16 @@ public:
      */
     void setScroll(int cursor, int lines);
 
+    /**
+     * Marks the lines of output with matches for the current search in the
+     * groove of the display's scroll bar, so that the user can see where the
+     * matches are in a long output.
+     *
+     * @param lines The matching lines, in ascending order.
+     * @param lineCount The number of lines of output the matches were found in.
+     */
+    void setSearchMatchLines(const QVector<int>& lines, int lineCount);
+
     /**
      * Returns the display's filter chain.  When the image for the display is updated,
      * the text is passed through each filter in the chain.  Each filter can define
@@ -401,6 +415,41 @@ public:
         return _boldIntense;
     }
 
+    /**
+     * Specifies whether the text of large repaints is drawn in horizontal
+     * tiles by several threads at once.  Each tile is drawn into an image
+     * which is then copied to the display.  Displays with a wallpaper or a
+     * transparent background are always drawn by the GUI thread alone.
+     * Defaults to false.
+     */
+    void setParallelRendering(bool enable) {
+        _parallelRendering = enable;
+    }
+    /** Returns true if large repaints are drawn by several threads. */
+    bool parallelRendering() const {
+        return _parallelRendering;
+    }
+
+    /**
+     * Specifies whether the fragments of each line are drawn together,
+     * saving the painter state once per line, or one at a time with the
+     * state saved for each fragment.  Both give the same output, drawing
+     * fragments one at a time is only useful to compare them.
+     * Defaults to true.
+     */
+    void setLineDrawingEnabled(bool enable) {
+        _lineDrawing = enable;
+    }
+
+    /**
+     * Sets the number of threads, including the GUI thread, which draw
+     * the tiles of displays with parallel rendering enabled.  Defaults to
+     * the number of processor cores.
+     */
+    static void setRenderThreadCount(int count);
+    /** Returns the number of threads used for parallel rendering. */
+    static int renderThreadCount();
+
     /**
      * Sets whether or not the current height and width of the
      * terminal in lines and columns is displayed whilst the widget
@@ -509,6 +558,16 @@ public slots:
      */
     void outputSuspended(bool suspended);
 
+    /**
+     * Causes the widget to display or hide a message informing the user that
+     * output which looks like binary data is being discarded, with a link to
+     * resume processing output.  The resumeOutputRequest() signal is emitted
+     * when the link is activated.
+     *
+     * See Emulation::setBinaryOutputGuardEnabled()
+     */
+    void outputDiscarded(bool discarded);
+
     /**
      * Sets whether the program whose output is being displayed in the view
      * is interested in mouse events.
@@ -591,6 +650,12 @@ signals:
 
     void sendStringToEmu(const char*);
 
+    /**
+     * Emitted when the user asks to resume processing output which was
+     * discarded because it looked like binary data.  See outputDiscarded()
+     */
+    void resumeOutputRequest();
+
 protected:
     virtual bool event(QEvent* event);
 
@@ -665,11 +730,33 @@ private slots:
 private:
     // -- Drawing helpers --
 
+    // a section of a line with a common color and style, whose text
+    // is 'length' characters of the line's text starting at 'start'
+    struct TextFragment {
+        QRect area;
+        int start;
+        int length;
+        const Character* style;
+    };
+
     // divides the part of the display specified by 'rect' into
     // fragments according to their colors and styles and calls
-    // drawTextFragment() or drawPrinterFriendlyTextFragment()
-    // to draw the fragments
+    // drawLineFragments(), drawTextFragment() or
+    // drawPrinterFriendlyTextFragment() to draw the fragments
     void drawContents(QPainter& painter, const QRect& rect);
+    // draws the fragments of one line in the same order and with the same
+    // result as drawTextFragment(), but only saves the painter state once
+    // and only changes the font and pen when a fragment needs a different
+    // one.  'text' holds the text of all the fragments
+    void drawLineFragments(QPainter& painter, const QVector<TextFragment>& fragments,
+                           const QString& text);
+    // draws the contents of 'region' in tiles using several threads, see
+    // setParallelRendering().  returns false without drawing anything if
+    // the region is too small or cannot be drawn this way
+    bool drawContentsInParallel(QPainter& painter, const QRegion& region);
+    // draws the lines of the display in 'area' on an image with the display's
+    // background color.  called from the render threads
+    void renderTile(const QRect& area, QImage& image);
     // draws a section of text, all the text in this section
     // has a common color and style
     void drawTextFragment(QPainter& painter, const QRect& rect,
@@ -725,12 +812,16 @@ private:
     void updateImageSize();
     void makeImage();
 
-    void paintFilters(QPainter& painter);
+    // draws the hotspots on the lines of the display in 'region'
+    void paintFilters(QPainter& painter, const QRegion& region);
 
     // returns a region covering all of the areas of the widget which contain
     // a hotspot
     QRegion hotSpotRegion() const;
 
+    // returns the usage of the session shown in the display, or null
+    SessionUsage* sessionUsage();
+
     // returns the position of the cursor in columns and lines
     QPoint cursorPosition() const;
 
@@ -779,6 +870,13 @@ private:
     int _imageSize;
     QVector<LineProperty> _lineProperties;
 
+    // references to the lines in _image, lines whose reference is the same
+    // in the next image are not compared or copied again.
+    // see ScreenWindow::getLineReferences()
+    QVector<LineReference> _lineReferences;
+    // the lines in _image with blinking text
+    QBitArray _blinkingLines;
+
     ColorEntry _colorTable[TABLE_COLORS];
     uint _randomSeed;
 
@@ -799,7 +897,7 @@ private:
     bool _autoCopySelectedText;
     Enum::MiddleClickPasteModeEnum _middleClickPasteMode;
 
-    QScrollBar* _scrollBar;
+    TerminalScrollBar* _scrollBar;
     Enum::ScrollBarPositionEnum _scrollbarLocation;
     QString     _wordCharacters;
     int         _bellMode;
@@ -830,6 +928,7 @@ private:
     //widgets related to the warning message that appears when the user presses Ctrl+S to suspend
     //terminal output - informing them what has happened and how to resume output
     QLabel* _outputSuspendedLabel;
+    QLabel* _outputDiscardedLabel;
 
     uint _lineSpacing;
 
@@ -857,6 +956,8 @@ private:
     InputMethodData _inputMethodData;
 
     bool _antialiasText;   // do we anti-alias or not
+    bool _parallelRendering;   // draw large repaints using several threads
+    bool _lineDrawing;   // draw the fragments of a line with drawLineFragments()
 
     bool _printerFriendly; // are we currently painting to a printer in black/white mode
 
@@ -875,6 +976,7 @@ private:
     bool _mouseWheelZoom;   // enable mouse wheel zooming or not
 
     friend class TerminalDisplayAccessible;
+    friend class TileRenderJob;
 };
 
 class AutoScrollHandler : public QObject
@@ -28,6 +28,7 @@
 #include <QtGui/QDrag>
 #include <QtGui/QDragMoveEvent>
 #include <QtCore/QMimeData>
+#include <QtCore/QTimer>
 #include <QHBoxLayout>
 #include <QVBoxLayout>
 
@@ -140,6 +141,7 @@ void ViewContainer::addView(QWidget* view , ViewProperties* item, int index)
         _views.insert(index, view);
 
     _navigation[view] = item;
+    _widgetsByItem.insert(item, view);
 
     connect(view, SIGNAL(destroyed(QObject*)), this, SLOT(viewDestroyed(QObject*)));
 
@@ -152,7 +154,7 @@ void ViewContainer::viewDestroyed(QObject* object)
     QWidget* widget = static_cast<QWidget*>(object);
 
     _views.removeAll(widget);
-    _navigation.remove(widget);
+    _widgetsByItem.remove(_navigation.take(widget), widget);
 
     // FIXME This can result in ViewContainerSubClass::removeViewWidget() being
     // called after the widget's parent has been deleted or partially deleted
@@ -171,7 +173,7 @@ void ViewContainer::viewDestroyed(QObject* object)
 void ViewContainer::removeView(QWidget* view)
 {
     _views.removeAll(view);
-    _navigation.remove(view);
+    _widgetsByItem.remove(_navigation.take(view), view);
 
     disconnect(view, SIGNAL(destroyed(QObject*)), this, SLOT(viewDestroyed(QObject*)));
 
@@ -251,12 +253,13 @@ ViewProperties* ViewContainer::viewProperties(QWidget* widget) const
 
 QList<QWidget*> ViewContainer::widgetsForItem(ViewProperties* item) const
 {
-    return _navigation.keys(item);
+    return _widgetsByItem.values(item);
 }
 
 TabbedViewContainer::TabbedViewContainer(NavigationPosition position , QObject* parent)
     : ViewContainer(position, parent)
     , _contextMenuTabIndex(0)
+    , _tabUpdateScheduled(false)
 {
     _containerWidget = new QWidget;
     _stackWidget = new QStackedWidget();
@@ -684,23 +687,54 @@ void TabbedViewContainer::updateActivity(ViewProperties* item)
 
 void TabbedViewContainer::updateTitle(ViewProperties* item)
 {
-    foreach(QWidget* widget, widgetsForItem(item)) {
-        const int index = _stackWidget->indexOf(widget);
-        QString tabText = item->title();
+    _pendingTitleUpdates << item;
 
-        _tabBar->setTabToolTip(index , tabText);
-
-        // To avoid having & replaced with _ (shortcut indicator)
-        tabText.replace('&', "&&");
-        _tabBar->setTabText(index , tabText);
+    if (!_tabUpdateScheduled) {
+        _tabUpdateScheduled = true;
+        QTimer::singleShot(0, this, SLOT(updatePendingTabs()));
     }
 }
 void TabbedViewContainer::updateIcon(ViewProperties* item)
 {
-    foreach(QWidget* widget, widgetsForItem(item)) {
+    _pendingIconUpdates << item;
+
+    if (!_tabUpdateScheduled) {
+        _tabUpdateScheduled = true;
+        QTimer::singleShot(0, this, SLOT(updatePendingTabs()));
+    }
+}
+void TabbedViewContainer::updatePendingTabs()
+{
+    _tabUpdateScheduled = false;
+
+    // the pending items are only compared against the items of the views
+    // which are still in the container, items which have been removed
+    // (and possibly destroyed) in the meantime are never dereferenced
+    foreach(QWidget* widget, views()) {
+        ViewProperties* item = viewProperties(widget);
+        const bool titleChanged = _pendingTitleUpdates.contains(item);
+        const bool iconChanged = _pendingIconUpdates.contains(item);
+        if (!titleChanged && !iconChanged)
+            continue;
+
         const int index = _stackWidget->indexOf(widget);
-        _tabBar->setTabIcon(index , item->icon());
+
+        if (titleChanged) {
+            QString tabText = item->title();
+
+            _tabBar->setTabToolTip(index , tabText);
+
+            // To avoid having & replaced with _ (shortcut indicator)
+            tabText.replace('&', "&&");
+            _tabBar->setTabText(index , tabText);
+        }
+
+        if (iconChanged)
+            _tabBar->setTabIcon(index , item->icon());
     }
+
+    _pendingTitleUpdates.clear();
+    _pendingIconUpdates.clear();
 }
 
 StackedViewContainer::StackedViewContainer(QObject* parent)
@@ -27,6 +27,7 @@
 #include <QtCore/QPointer>
 #include <QtCore/QHash>
 #include <QtCore/QList>
+#include <QtCore/QSet>
 
 // Konsole
 #include "Profile.h"
@@ -344,6 +345,7 @@ private:
     NavigationPosition _navigationPosition;
     QList<QWidget*> _views;
     QHash<QWidget*, ViewProperties*> _navigation;
+    QMultiHash<ViewProperties*, QWidget*> _widgetsByItem; // reverse of _navigation
     Features _features;
     IncrementalSearchBar* _searchBar;
 };
@@ -388,6 +390,7 @@ private slots:
     void updateTitle(ViewProperties* item);
     void updateIcon(ViewProperties* item);
     void updateActivity(ViewProperties* item);
+    void updatePendingTabs();
     void currentTabChanged(int index);
     void closeCurrentTab();
     void wheelScrolled(int delta);
@@ -421,6 +424,12 @@ private:
     QToolButton* _closeTabButton;
     int _contextMenuTabIndex;
     KMenu* _contextPopupMenu;
+
+    // title and icon changes are applied to the tab bar once per
+    // event loop iteration, see updatePendingTabs()
+    QSet<ViewProperties*> _pendingTitleUpdates;
+    QSet<ViewProperties*> _pendingIconUpdates;
+    bool _tabUpdateScheduled;
 };
 
 /** A plain view container with no navigation display */
@@ -41,6 +41,9 @@
 #include "Session.h"
 #include "TerminalDisplay.h"
 #include "SessionController.h"
+#include "SearchAllSessionsDialog.h"
+#include "SessionUsageDialog.h"
+#include "ScreenWindow.h"
 #include "SessionManager.h"
 #include "ProfileManager.h"
 #include "ViewContainer.h"
@@ -64,6 +67,7 @@ ViewManager::ViewManager(QObject* parent , KActionCollection* collection)
     , _newTabBehavior(PutNewTabAtTheEnd)
     , _navigationStyleSheet(QString())
     , _managerId(0)
+    , _actionsCreated(false)
 {
     // create main view area
     _viewSplitter = new ViewSplitter(0);
@@ -78,9 +82,6 @@ ViewManager::ViewManager(QObject* parent , KActionCollection* collection)
     _viewSplitter->setRecursiveSplitting(false);
     _viewSplitter->setFocusPolicy(Qt::NoFocus);
 
-    // setup actions which are related to the views
-    setupActions();
-
     // emit a signal when all of the views held by this view manager are destroyed
     connect(_viewSplitter , SIGNAL(allContainersEmpty()) , this , SIGNAL(empty()));
     connect(_viewSplitter , SIGNAL(empty(ViewSplitter*)) , this , SIGNAL(empty()));
@@ -130,6 +131,11 @@ QWidget* ViewManager::widget() const
 
 void ViewManager::setupActions()
 {
+    if (_actionsCreated)
+        return;
+
+    _actionsCreated = true;
+
     KActionCollection* collection = _actionCollection;
 
     KAction* nextViewAction = new KAction(i18nc("@action Shortcut entry", "Next Tab") , this);
@@ -203,6 +209,16 @@ void ViewManager::setupActions()
         connect(this , SIGNAL(splitViewToggle(bool)) , this , SLOT(updateDetachViewState()));
         connect(detachViewAction , SIGNAL(triggered()) , this , SLOT(detachActiveView()));
 
+        KAction* searchAllAction = collection->addAction("search-all-sessions");
+        searchAllAction->setIcon(KIcon("edit-find"));
+        searchAllAction->setText(i18nc("@action:inmenu", "Search All Tabs..."));
+        connect(searchAllAction , SIGNAL(triggered()) , this , SLOT(showSearchAllSessionsDialog()));
+
+        KAction* sessionUsageAction = collection->addAction("show-session-usage");
+        sessionUsageAction->setIcon(KIcon("view-statistics"));
+        sessionUsageAction->setText(i18nc("@action:inmenu", "Tab &Activity..."));
+        connect(sessionUsageAction , SIGNAL(triggered()) , this , SLOT(showSessionUsageDialog()));
+
         // Next / Previous View , Next Container
         collection->addAction("next-view", nextViewAction);
         collection->addAction("previous-view", previousViewAction);
@@ -251,7 +267,93 @@ void ViewManager::setupActions()
 
     connect(lastViewAction, SIGNAL(triggered()) , this , SLOT(lastView()));
     _viewSplitter->addAction(lastViewAction);
+
+    // the navigation method may have been set before the actions existed
+    setNavigationMethod(_navigationMethod);
+
+    if (_pluggedController)
+        _pluggedController->setupActions();
 }
+void ViewManager::showSearchAllSessionsDialog()
+{
+    if (!_searchAllSessionsDialog) {
+        _searchAllSessionsDialog = new SearchAllSessionsDialog(_viewSplitter->window());
+        _searchAllSessionsDialog->setAttribute(Qt::WA_DeleteOnClose);
+        connect(_searchAllSessionsDialog , SIGNAL(matchActivated(Session*,int)) ,
+                this , SLOT(showSessionLine(Session*,int)));
+    }
+
+    // search each session once, even if it is shown in several views
+    QList<Session*> sessions;
+    QSet<Session*> seen;
+    foreach(ViewContainer* container, _viewSplitter->containers()) {
+        foreach(QWidget* view, container->views()) {
+            Session* session = _sessionMap.value(qobject_cast<TerminalDisplay*>(view));
+            if (session && !seen.contains(session)) {
+                seen.insert(session);
+                sessions << session;
+            }
+        }
+    }
+
+    _searchAllSessionsDialog->setSessions(sessions);
+    _searchAllSessionsDialog->show();
+    _searchAllSessionsDialog->raise();
+    _searchAllSessionsDialog->activateWindow();
+}
+
+TerminalDisplay* ViewManager::activateSessionView(Session* session)
+{
+    foreach(ViewContainer* container, _viewSplitter->containers()) {
+        foreach(QWidget* view, container->views()) {
+            TerminalDisplay* display = qobject_cast<TerminalDisplay*>(view);
+            if (!display || _sessionMap.value(display) != session)
+                continue;
+
+            container->setActiveView(display);
+            display->setFocus(Qt::OtherFocusReason);
+            return display;
+        }
+    }
+
+    return 0;
+}
+
+void ViewManager::showSessionLine(Session* session , int line)
+{
+    TerminalDisplay* display = activateSessionView(session);
+    if (!display)
+        return;
+
+    // show the line and select it, in the same way as the search bar
+    // highlights a match
+    ScreenWindow* window = display->screenWindow();
+    window->scrollTo(line);
+    window->setSelectionStart(0 , line - window->currentLine() , false);
+    window->setSelectionEnd(window->columnCount() , line - window->currentLine());
+    window->setTrackOutput(false);
+    window->notifyOutputChanged();
+}
+
+void ViewManager::showSessionUsageDialog()
+{
+    if (!_sessionUsageDialog) {
+        _sessionUsageDialog = new SessionUsageDialog(_viewSplitter->window());
+        _sessionUsageDialog->setAttribute(Qt::WA_DeleteOnClose);
+        connect(_sessionUsageDialog , SIGNAL(sessionActivated(Session*)) ,
+                this , SLOT(showSession(Session*)));
+    }
+
+    _sessionUsageDialog->show();
+    _sessionUsageDialog->raise();
+    _sessionUsageDialog->activateWindow();
+}
+
+void ViewManager::showSession(Session* session)
+{
+    activateSessionView(session);
+}
+
 void ViewManager::switchToView(int index)
 {
     Q_ASSERT(index >= 0);
@@ -363,10 +465,8 @@ void ViewManager::sessionFinished()
     Q_ASSERT(session);
 
     // close attached views
-    QList<TerminalDisplay*> children = _viewSplitter->findChildren<TerminalDisplay*>();
-
-    foreach(TerminalDisplay* view , children) {
-        if (_sessionMap[view] == session) {
+    foreach(TerminalDisplay* view , session->views()) {
+        if (_sessionMap.value(view) == session) {
             _sessionMap.remove(view);
             view->deleteLater();
         }
@@ -500,8 +600,8 @@ SessionController* ViewManager::createController(Session* session , TerminalDisp
     connect(session , SIGNAL(destroyed()) , controller , SLOT(deleteLater()));
     connect(session , SIGNAL(primaryScreenInUse(bool)) ,
             controller , SLOT(setupPrimaryScreenSpecificActions(bool)));
-    connect(session , SIGNAL(selectionChanged(QString)) ,
-            controller , SLOT(selectionChanged(QString)));
+    connect(session , SIGNAL(selectionChanged(bool)) ,
+            controller , SLOT(selectionChanged(bool)));
     connect(view , SIGNAL(destroyed()) , controller , SLOT(deleteLater()));
 
     // if this is the first controller created then set it as the active controller
@@ -516,6 +616,11 @@ void ViewManager::controllerChanged(SessionController* controller)
     if (controller == _pluggedController)
         return;
 
+    // the actions of a controller are only created when it is activated
+    // for the first time, so that tabs which are never visited stay cheap
+    if (_actionsCreated)
+        controller->setupActions();
+
     _viewSplitter->setFocusProxy(controller->view());
 
     _pluggedController = controller;
@@ -780,6 +885,7 @@ void ViewManager::applyProfileToView(TerminalDisplay* view , const Profile::Ptr
     view->setAntialias(profile->antiAliasFonts());
     view->setBoldIntense(profile->boldIntense());
     view->setVTFont(profile->font());
+    view->setParallelRendering(profile->property<bool>(Profile::ParallelRendering));
 
     // set scroll-bar position
     int scrollBarPosition = profile->property<int>(Profile::ScrollBarPosition);
@@ -850,8 +956,9 @@ void ViewManager::updateViewsForSession(Session* session)
 {
     const Profile::Ptr profile = SessionManager::instance()->sessionProfile(session);
 
-    foreach(TerminalDisplay* view, _sessionMap.keys(session)) {
-        applyProfileToView(view, profile);
+    foreach(TerminalDisplay* view, session->views()) {
+        if (_sessionMap.value(view) == session)
+            applyProfileToView(view, profile);
     }
 }
 
@@ -965,11 +1072,37 @@ int ViewManager::sessionCount()
 
 int ViewManager::currentSession()
 {
-    QHash<TerminalDisplay*, Session*>::iterator i;
-    for (i = this->_sessionMap.begin(); i != this->_sessionMap.end(); ++i)
-        if (i.key()->isVisible())
-            return i.value()->sessionId();
-    return -1;
+    TerminalDisplay* display = qobject_cast<TerminalDisplay*>(activeView());
+    Session* session = _sessionMap.value(display);
+
+    return session ? session->sessionId() : -1;
+}
+
+// orders sessions by the time spent on them, the most first
+static bool moreCpuUsage(const QPair<double, Session*>& a, const QPair<double, Session*>& b)
+{
+    return a.first > b.first;
+}
+
+QStringList ViewManager::sessionUsage()
+{
+    QList<QPair<double, Session*> > sessions;
+    foreach(Session* session, SessionManager::instance()->sessions()) {
+        sessions << qMakePair(session->cpuUsage(), session);
+    }
+    qStableSort(sessions.begin(), sessions.end(), moreCpuUsage);
+
+    QStringList usage;
+    for (int i = 0; i < sessions.count(); i++) {
+        Session* session = sessions[i].second;
+        usage << QString("%1 %2 %3 %4 %5").arg(session->sessionId())
+              .arg(sessions[i].first, 0, 'f', 1)
+              .arg(session->outputRate(), 0, 'f', 0)
+              .arg(session->frameRate(), 0, 'f', 1)
+              .arg(session->skippedHistoryLineRate(), 0, 'f', 0);
+    }
+
+    return usage;
 }
 
 int ViewManager::newSession()
@@ -985,15 +1118,9 @@ int ViewManager::newSession()
 
 int ViewManager::newSession(QString profile, QString directory)
 {
-    const QList<Profile::Ptr> profilelist = ProfileManager::instance()->allProfiles();
-    Profile::Ptr profileptr = ProfileManager::instance()->defaultProfile();
-
-    for (int i = 0; i < profilelist.size(); ++i) {
-        if (profilelist.at(i)->name() == profile) {
-            profileptr = profilelist.at(i);
-            break;
-        }
-    }
+    Profile::Ptr profileptr = ProfileManager::instance()->findProfileByName(profile);
+    if (!profileptr)
+        profileptr = ProfileManager::instance()->defaultProfile();
 
     Session* session = SessionManager::instance()->createSession(profileptr);
     session->setInitialWorkingDirectory(directory);
@@ -37,6 +37,8 @@ namespace Konsole
 {
 class ColorScheme;
 class IncrementalSearchBar;
+class SearchAllSessionsDialog;
+class SessionUsageDialog;
 class Session;
 class TerminalDisplay;
 
@@ -71,12 +73,21 @@ class KONSOLEPRIVATE_EXPORT ViewManager : public QObject
 public:
     /**
      * Constructs a new view manager with the specified @p parent.
-     * View-related actions defined in 'konsoleui.rc' are created
-     * and added to the specified @p collection.
+     * View-related actions defined in 'konsoleui.rc' are added to the
+     * specified @p collection when setupActions() is called.
      */
     ViewManager(QObject* parent , KActionCollection* collection);
     ~ViewManager();
 
+    /**
+     * Creates the view-related actions, and the actions of the active
+     * session controller.  Controllers which are activated afterwards
+     * create their actions as they are activated.
+     *
+     * Calling this more than once has no effect.
+     */
+    void setupActions();
+
     /**
      * Creates a new view to display the output from and deliver input to @p session.
      * Constructs a new container to hold the views if no container has yet been created.
@@ -237,6 +248,16 @@ public slots:
      */
     Q_SCRIPTABLE int newSession(QString profile, QString directory);
 
+    /**
+     * DBus slot that returns the recent usage of every session in Konsole,
+     * the session which the GUI thread spends the most time on first.
+     * Each entry holds the session id, the milliseconds per second spent on
+     * the session, the bytes of output per second, the image updates per
+     * second and the history lines per second which were dropped without
+     * being compacted, separated by spaces.
+     */
+    Q_SCRIPTABLE QStringList sessionUsage();
+
     // TODO: its semantic is application-wide. Move it to more appropriate place
     // DBus slot that returns the name of default profile
     Q_SCRIPTABLE QString defaultProfile();
@@ -328,6 +349,15 @@ private slots:
     // in the current container
     void switchToView(int index);
 
+    // shows a dialog to search the output of every session in this window
+    void showSearchAllSessionsDialog();
+    // activates the view of session and selects the given line of its output
+    void showSessionLine(Session* session , int line);
+    // shows a dialog listing the usage of every session
+    void showSessionUsageDialog();
+    // activates the view of session, if it is in this window
+    void showSession(Session* session);
+
     // called when a SessionController gains focus
     void controllerChanged(SessionController* controller);
 
@@ -343,9 +373,12 @@ private:
     void createView(Session* session, ViewContainer* container, int index);
     static const ColorScheme* colorSchemeForProfile(const Profile::Ptr profile);
 
-    void setupActions();
     void focusActiveView();
 
+    // activates and focuses the first view of session in this window, and
+    // returns it, or returns null if the session has no view here
+    TerminalDisplay* activateSessionView(Session* session);
+
     // takes a view from a view container owned by a different manager and places it in
     // newContainer owned by this manager
     void takeView(ViewManager* otherManager , ViewContainer* otherContainer, ViewContainer* newContainer, TerminalDisplay* view);
@@ -384,6 +417,10 @@ private:
     QString _navigationStyleSheet;
 
     int _managerId;
+    bool _actionsCreated;
+
+    QPointer<SearchAllSessionsDialog> _searchAllSessionsDialog;
+    QPointer<SessionUsageDialog> _sessionUsageDialog;
     static int lastManagerId;
 };
 }
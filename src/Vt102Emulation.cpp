@@ -73,6 +73,7 @@ Vt102Emulation::Vt102Emulation()
     QObject::connect(_titleUpdateTimer , SIGNAL(timeout()) , this , SLOT(updateTitle()));
 
     initTokenizer();
+    resetOsc();
     reset();
 }
 
@@ -154,8 +155,10 @@ void Vt102Emulation::reset()
                   - <ESC><Chr>
                   - <ESC>'Y'{Pc}{Pc}
    - XTE_HA     - Xterm window/terminal attribute commands
-                  of the form <ESC>`]' {Pn} `;' {Text} <BEL>
-                  (Note that these are handled differently to the other formats)
+                  of the form <ESC>`]' {Pn} `;' {Text} <BEL> or
+                  <ESC>`]' {Pn} `;' {Text} <ESC>`\'
+                  (Note that these are handled differently to the other formats,
+                  see receiveOscChar())
 
    The last two forms allow list of arguments. Since the elements of
    the lists are treated individually the same way, they are passed
@@ -182,6 +185,14 @@ void Vt102Emulation::reset()
 
 const int MAX_ARGUMENT = 4096;
 
+// Longest text accepted in an OSC string other than OSC 52 (window titles,
+// colors, profile change commands).  Longer strings are truncated.
+const int MAX_OSC_TEXT_LENGTH = 65536;
+// Longest list of selection targets accepted in an OSC 52 string
+const int MAX_OSC_CLIPBOARD_TARGETS = 16;
+// OSC attribute used by xterm for setting the clipboard
+const int OSC_CLIPBOARD = 52;
+
 // Tokenizer --------------------------------------------------------------- --
 
 /* The tokenizer's state
@@ -197,6 +208,11 @@ void Vt102Emulation::resetTokenizer()
     argc = 0;
     argv[0] = 0;
     argv[1] = 0;
+
+    // this runs for every printable character, the OSC state only needs
+    // to be cleared once a string has been started
+    if (_oscActive)
+        resetOsc();
 }
 
 void Vt102Emulation::addDigit(int digit)
@@ -279,9 +295,7 @@ void Vt102Emulation::initTokenizer()
 #define epp( )     (p >=  3  && s[2] == '?')
 #define epe( )     (p >=  3  && s[2] == '!')
 #define egt( )     (p >=  3  && s[2] == '>')
-#define Xpe        (tokenBufferPos >= 2 && tokenBuffer[1] == ']')
-#define Xte        (Xpe      && cc ==  7 )
-#define ces(C)     (cc < 256 && (charClass[cc] & (C)) == (C) && !Xte)
+#define ces(C)     (cc < 256 && (charClass[cc] & (C)) == (C))
 
 #define CNTL(c) ((c)-'@')
 const int ESC = 27;
@@ -293,6 +307,12 @@ void Vt102Emulation::receiveChar(int cc)
   if (cc == DEL)
     return; //VT100: ignore.
 
+  if (_oscActive)
+  {
+    receiveOscChar(cc);
+    return;
+  }
+
   if (ces(CTL))
   {
     // DEC HACK ALERT! Control Characters are allowed *within* esc sequences in VT100
@@ -317,9 +337,8 @@ void Vt102Emulation::receiveChar(int cc)
   {
     if (lec(1,0,ESC)) { return; }
     if (lec(1,0,ESC+128)) { s[0] = ESC; receiveChar('['); return; }
+    if (lec(2,1,']')) { startOsc(); return; }
     if (les(2,1,GRP)) { return; }
-    if (Xte         ) { processWindowAttributeChange(); resetTokenizer(); return; }
-    if (Xpe         ) { return; }
     if (lec(3,2,'?')) { return; }
     if (lec(3,2,'>')) { return; }
     if (lec(3,2,'!')) { return; }
@@ -390,31 +409,183 @@ void Vt102Emulation::receiveChar(int cc)
     return;
   }
 }
+// OSC strings ------------------------------------------------------------ --
+
+/*
+   Operating System Command strings can be arbitrarily long, so once the
+   introducing <ESC>`]' has been seen the remaining characters bypass the
+   token buffer.  The attribute number is decoded as it arrives, and the
+   text following the `;' is appended to a growable buffer.  The payload
+   of OSC 52 (set clipboard) is base64 encoded; it is decoded on the fly
+   so that only the decoded bytes are kept, up to clipboardPayloadLimit().
+
+   The string is terminated by <BEL> or by the string terminator <ESC>`\'.
+*/
+
+void Vt102Emulation::startOsc()
+{
+    resetOsc();
+    _oscActive = true;
+}
+
+void Vt102Emulation::resetOsc()
+{
+    _oscActive = false;
+    _oscEscapePending = false;
+    _oscHasAttribute = false;
+    _oscInvalid = false;
+    _oscOverflow = false;
+    _oscAttribute = 0;
+    _oscClipboardTargetsDone = false;
+    _oscBase64Bits = 0;
+    _oscBase64BitCount = 0;
+
+    // release the memory held by large payloads
+    if (!_oscText.isEmpty())
+        _oscText.clear();
+    if (!_oscClipboardTargets.isEmpty())
+        _oscClipboardTargets.clear();
+    if (!_oscClipboardData.isEmpty())
+        _oscClipboardData.clear();
+}
+
+void Vt102Emulation::receiveOscChar(int cc)
+{
+    if (_oscEscapePending) {
+        _oscEscapePending = false;
+        if (cc == '\\') {
+            processWindowAttributeChange();
+            resetTokenizer();
+        } else {
+            // any other escape sequence aborts the OSC string
+            resetTokenizer();
+            receiveChar(ESC);
+            receiveChar(cc);
+        }
+        return;
+    }
+
+    if (cc == 7) {
+        processWindowAttributeChange();
+        resetTokenizer();
+        return;
+    }
+
+    if (cc == ESC) {
+        _oscEscapePending = true;
+        return;
+    }
+
+    if (cc < 32) {
+        // see the DEC HACK in receiveChar(), control characters are
+        // processed even within OSC strings
+        if (cc == CNTL('X') || cc == CNTL('Z'))
+            resetTokenizer();
+        processToken(TY_CTL(cc + '@'), 0, 0);
+        return;
+    }
+
+    if (!_oscHasAttribute) {
+        if (cc >= '0' && cc <= '9') {
+            if (_oscAttribute < MAX_ARGUMENT)
+                _oscAttribute = 10 * _oscAttribute + (cc - '0');
+        } else if (cc == ';') {
+            _oscHasAttribute = true;
+        } else {
+            _oscInvalid = true;
+        }
+        return;
+    }
+
+    if (_oscInvalid || _oscOverflow)
+        return;
+
+    if (_oscAttribute != OSC_CLIPBOARD) {
+        if (_oscText.length() < MAX_OSC_TEXT_LENGTH)
+            _oscText.append(QChar(cc));
+        else
+            _oscOverflow = true;
+        return;
+    }
+
+    // OSC 52: <targets> ';' <base64 data>
+    if (!_oscClipboardTargetsDone) {
+        if (cc == ';')
+            _oscClipboardTargetsDone = true;
+        else if (_oscClipboardTargets.length() < MAX_OSC_CLIPBOARD_TARGETS)
+            _oscClipboardTargets.append(QChar(cc));
+        else
+            _oscInvalid = true;
+        return;
+    }
+
+    // with remote clipboard access disabled, skip the payload entirely
+    if (clipboardPayloadLimit() == 0) {
+        _oscOverflow = true;
+        return;
+    }
+
+    addOscBase64Digit(cc);
+}
+
+void Vt102Emulation::addOscBase64Digit(int cc)
+{
+    int value;
+    if (cc >= 'A' && cc <= 'Z')
+        value = cc - 'A';
+    else if (cc >= 'a' && cc <= 'z')
+        value = cc - 'a' + 26;
+    else if (cc >= '0' && cc <= '9')
+        value = cc - '0' + 52;
+    else if (cc == '+')
+        value = 62;
+    else if (cc == '/')
+        value = 63;
+    else if (cc == '=') {
+        // padding, the remaining bits are discarded
+        _oscBase64Bits = 0;
+        _oscBase64BitCount = 0;
+        return;
+    } else {
+        // '?' (a clipboard query) and anything else is not supported
+        _oscInvalid = true;
+        return;
+    }
+
+    _oscBase64Bits = (_oscBase64Bits << 6) | value;
+    _oscBase64BitCount += 6;
+    if (_oscBase64BitCount >= 8) {
+        _oscBase64BitCount -= 8;
+        if (_oscClipboardData.size() >= clipboardPayloadLimit()) {
+            _oscOverflow = true;
+            return;
+        }
+        _oscClipboardData.append(char((_oscBase64Bits >> _oscBase64BitCount) & 0xff));
+        _oscBase64Bits &= (1 << _oscBase64BitCount) - 1;
+    }
+}
+
 void Vt102Emulation::processWindowAttributeChange()
 {
   // Describes the window or terminal session attribute to change
   // See Session::UserTitleChange for possible values
-  int attributeToChange = 0;
-  int i;
-  for (i = 2; i < tokenBufferPos     &&
-              tokenBuffer[i] >= '0'  &&
-              tokenBuffer[i] <= '9'; i++)
+  if (!_oscHasAttribute || _oscInvalid)
   {
-    attributeToChange = 10 * attributeToChange + (tokenBuffer[i]-'0');
+    reportDecodingError();
+    return;
   }
 
-  if (tokenBuffer[i] != ';')
+  if (_oscAttribute == OSC_CLIPBOARD)
   {
-    reportDecodingError();
+    if (_oscOverflow) {
+        kDebug() << "Discarding clipboard request larger than" << clipboardPayloadLimit() << "bytes";
+        return;
+    }
+    emit clipboardChangeRequest(_oscClipboardTargets, codec()->toUnicode(_oscClipboardData));
     return;
   }
 
-  QString newValue;
-  newValue.reserve(tokenBufferPos-i-2);
-  for (int j = 0; j < tokenBufferPos-i-2; j++)
-    newValue[j] = tokenBuffer[i+1+j];
-
-  _pendingTitleUpdates[attributeToChange] = newValue;
+  _pendingTitleUpdates[_oscAttribute] = _oscText;
   _titleUpdateTimer->start(20);
 }
 
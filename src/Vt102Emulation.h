@@ -128,9 +128,9 @@ private:
     void resetModes();
 
     void resetTokenizer();
-#define MAX_TOKEN_LENGTH 256 // Max length of tokens (e.g. window title)
+#define MAX_TOKEN_LENGTH 256 // Max length of tokens (excluding OSC strings)
     void addToCurrentToken(int cc);
-    int tokenBuffer[MAX_TOKEN_LENGTH]; //FIXME: overflow?
+    int tokenBuffer[MAX_TOKEN_LENGTH];
     int tokenBufferPos;
 #define MAXARGS 15
     void addDigit(int dig);
@@ -147,8 +147,31 @@ private:
     void reportDecodingError();
 
     void processToken(int code, int p, int q);
+
+    // Operating System Command strings ( ESC ']' {Pn} ';' {Text} BEL/ST )
+    // are not kept in the token buffer, but streamed into growable
+    // buffers so that long payloads (eg. OSC 52 clipboard data) are not
+    // truncated.
+    void startOsc();
+    void resetOsc();
+    void receiveOscChar(int cc);
+    void addOscBase64Digit(int cc);
     void processWindowAttributeChange();
 
+    bool _oscActive;          // true while an OSC string is being read
+    bool _oscEscapePending;   // an ESC was seen, '\\' completes the ST
+    bool _oscHasAttribute;    // the ';' after the attribute number was seen
+    bool _oscInvalid;         // the string is malformed and will be dropped
+    bool _oscOverflow;        // the payload exceeded its size limit
+    int _oscAttribute;
+    QString _oscText;         // payload of title and other text OSCs
+    // OSC 52 state: selection targets and incrementally decoded base64 data
+    QString _oscClipboardTargets;
+    bool _oscClipboardTargetsDone;
+    QByteArray _oscClipboardData;
+    quint32 _oscBase64Bits;
+    int _oscBase64BitCount;
+
     void reportTerminalType();
     void reportSecondaryAttributes();
     void reportStatus();
@@ -0,0 +1,158 @@
+/*
+    Copyright 2013 by Konsole Developers <konsole-devel@kde.org>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+    02110-1301  USA.
+*/
+
+// Standard
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+// Qt
+#include <QtCore/QCoreApplication>
+#include <QtCore/QDir>
+#include <QtCore/QStringList>
+#include <QtCore/QVector>
+#include <QtDBus/QDBusConnection>
+#include <QtDBus/QDBusError>
+#include <QtDBus/QDBusMessage>
+
+/*
+ * konsole-launch opens a new tab or window in the running Konsole.
+ *
+ * Unlike "konsole --new-tab", it does not load the KDE libraries or set up
+ * a GUI application just to hand its arguments over to the running Konsole.
+ * It sends one D-Bus call to Application::openSession() and prints the id
+ * of the new session.  If no Konsole is running, it starts one with the
+ * equivalent command-line options instead.
+ */
+
+static void printUsage()
+{
+    printf("Usage: konsole-launch [--profile <name>] [--workdir <dir>] [--new-window]"
+           " [-e <command> [args]]\n"
+           "\n"
+           "Opens a new tab in the running Konsole and prints the id of its session.\n"
+           "\n"
+           "  --profile <name>  Use the profile 'name' instead of the default profile\n"
+           "  --workdir <dir>   Start the session in 'dir'\n"
+           "  --new-window      Open a new window instead of a tab\n"
+           "  -e <command>      Run 'command' with the following arguments\n");
+}
+
+// starts Konsole itself with the same request, when there is no Konsole
+// running to send it to.  only returns if Konsole could not be started
+static int execKonsole(const QString& profile, const QString& directory,
+                       const QStringList& command, bool newWindow)
+{
+    QList<QByteArray> arguments;
+    arguments << "konsole";
+    if (!newWindow)
+        arguments << "--new-tab";
+    if (!profile.isEmpty())
+        arguments << "--profile" << profile.toLocal8Bit();
+    if (!directory.isEmpty())
+        arguments << "--workdir" << directory.toLocal8Bit();
+    if (!command.isEmpty()) {
+        arguments << "-e";
+        foreach(const QString& argument, command) {
+            arguments << argument.toLocal8Bit();
+        }
+    }
+
+    QVector<char*> argv;
+    for (int i = 0; i < arguments.count(); i++)
+        argv << arguments[i].data();
+    argv << 0;
+
+    execvp(argv[0], argv.data());
+
+    fprintf(stderr, "konsole-launch: unable to start konsole: %s\n", strerror(errno));
+    return 1;
+}
+
+int main(int argc, char** argv)
+{
+    QCoreApplication app(argc, argv);
+
+    QString profile;
+    QString directory;
+    QStringList command;
+    bool newWindow = false;
+
+    const QStringList arguments = app.arguments();
+    for (int i = 1; i < arguments.count(); i++) {
+        const QString& argument = arguments[i];
+
+        if (argument == "--profile" && i + 1 < arguments.count()) {
+            profile = arguments[++i];
+        } else if (argument == "--workdir" && i + 1 < arguments.count()) {
+            directory = QDir(arguments[++i]).absolutePath();
+        } else if (argument == "--new-window") {
+            newWindow = true;
+        } else if (argument == "-e" && i + 1 < arguments.count()) {
+            // the command catches all of the following arguments
+            command = arguments.mid(i + 1);
+            break;
+        } else if (argument == "--help" || argument == "-h") {
+            printUsage();
+            return 0;
+        } else {
+            fprintf(stderr, "konsole-launch: unknown option '%s'\n", argument.toLocal8Bit().constData());
+            printUsage();
+            return 1;
+        }
+    }
+
+    // the running Konsole has a different working directory
+    if (!command.isEmpty() && command.first().startsWith(QLatin1String("./")))
+        command[0] = QDir::currentPath() + command.first().mid(1);
+
+    // the service can be changed to talk to another instance, which is
+    // used by the tests.  Konsole is not started if that instance is missing
+    QString service = QString::fromLocal8Bit(qgetenv("KONSOLE_LAUNCH_SERVICE"));
+    const bool fallback = service.isEmpty();
+    if (service.isEmpty())
+        service = "org.kde.konsole";
+
+    QDBusMessage message = QDBusMessage::createMethodCall(service, "/Launcher",
+                           "org.kde.konsole.Launcher", "openSession");
+    message << profile << directory << command << newWindow;
+
+    const QDBusMessage reply = QDBusConnection::sessionBus().call(message);
+    if (reply.type() == QDBusMessage::ReplyMessage && !reply.arguments().isEmpty()) {
+        printf("%d\n", reply.arguments().first().toInt());
+        return 0;
+    }
+
+    // Konsole is only started when no instance owns the service.  A
+    // timeout or any other error may come from an instance which is busy
+    // but running, so starting another one would open the session twice
+    const QDBusError::ErrorType error = QDBusError(reply).type();
+    const bool notRunning = (error == QDBusError::ServiceUnknown
+                             || error == QDBusError::NameHasNoOwner);
+
+    if (!fallback || !notRunning) {
+        const QString message = reply.type() == QDBusMessage::ErrorMessage ?
+                                reply.errorMessage() : QString("Unexpected reply from %1").arg(service);
+        fprintf(stderr, "konsole-launch: %s\n", message.toLocal8Bit().constData());
+        return 1;
+    }
+
+    return execKonsole(profile, directory, command, newWindow);
+}
@@ -0,0 +1,248 @@
+/*
+    Copyright 2013 by Konsole Developers <konsole-devel@kde.org>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+    02110-1301  USA.
+*/
+
+// Own
+#include "EmulationComplexityTest.h"
+
+// Qt
+#include <QtCore/QCryptographicHash>
+#include <QtCore/QDir>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QFile>
+#include <QtCore/QTextCodec>
+
+// KDE
+#include <qtest_kde.h>
+
+// Konsole
+#include "../Filter.h"
+#include "../History.h"
+#include "../ScreenWindow.h"
+#include "../Vt102Emulation.h"
+
+using namespace Konsole;
+
+// Feeds input to a new emulation and does what the display does when it is
+// updated: reads the visible image and the top of the history, and finds the
+// hotspots in them.  Returns the time taken in nanoseconds.
+static qint64 processInput(const QByteArray& input)
+{
+    Vt102Emulation emulation;
+    emulation.setCodec(QTextCodec::codecForName("UTF-8"));
+    emulation.setHistory(CompactHistoryType(1000));
+    emulation.setImageSize(40, 120);
+    ScreenWindow* window = emulation.createWindow();
+
+    TerminalImageFilterChain filters;
+    filters.addFilter(new UrlFilter());
+
+    QElapsedTimer timer;
+    timer.start();
+
+    emulation.receiveData(input.constData(), input.size());
+    window->notifyOutputChanged();
+
+    for (int pass = 0; pass < 2; pass++) {
+        if (pass == 1)
+            window->scrollTo(0);
+
+        filters.setImage(window->getImage(), window->windowLines(), window->windowColumns(),
+                         window->getLineProperties());
+        filters.process();
+        filters.hotSpots();
+    }
+
+    return timer.nsecsElapsed();
+}
+
+void EmulationComplexityTest::initTestCase()
+{
+    qint64 factor = 20;
+    const QByteArray factorVariable = qgetenv("KONSOLE_COMPLEXITY_FACTOR");
+    if (!factorVariable.isEmpty())
+        factor = factorVariable.toLongLong();
+
+    // the cost of updating an empty display, the best of a few runs
+    _fixedCost = processInput(QByteArray());
+    for (int i = 0; i < 4; i++)
+        _fixedCost = qMin(_fixedCost, processInput(QByteArray()));
+
+    // the cost of plain text on this machine, the best of a few runs
+    QByteArray text;
+    while (text.size() < 64 * 1024)
+        text += "The quick brown fox jumps over the lazy dog " + QByteArray::number(text.size()) + "\r\n";
+
+    _asciiCost = costPerByte(text);
+    for (int i = 0; i < 2; i++)
+        _asciiCost = qMin(_asciiCost, costPerByte(text));
+    _asciiCost = qMax(Q_INT64_C(1), _asciiCost);
+
+    _threshold = factor * _asciiCost;
+    qDebug() << "plain text costs" << _asciiCost << "ns per byte, threshold is"
+             << _threshold << "ns per byte";
+}
+
+qint64 EmulationComplexityTest::costPerByte(const QByteArray& input) const
+{
+    if (input.isEmpty())
+        return 0;
+
+    // take the best of two runs to reduce noise from the rest of the system
+    const qint64 time = qMin(processInput(input), processInput(input));
+    return qMax(Q_INT64_C(0), time - _fixedCost) / input.size();
+}
+
+void EmulationComplexityTest::testCorpus_data()
+{
+    QTest::addColumn<QString>("fileName");
+
+    const QDir corpus(KDESRCDIR "data/complexity");
+    foreach(const QString& fileName, corpus.entryList(QDir::Files, QDir::Name)) {
+        QTest::newRow(fileName.toLocal8Bit()) << corpus.filePath(fileName);
+    }
+}
+
+void EmulationComplexityTest::testCorpus()
+{
+    QFETCH(QString, fileName);
+
+    QFile file(fileName);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    const QByteArray input = file.readAll();
+
+    const qint64 cost = costPerByte(input);
+    qDebug() << input.size() << "bytes," << cost << "ns per byte";
+
+    if (qgetenv("KONSOLE_COMPLEXITY_TIMING").isEmpty())
+        QSKIP("Set KONSOLE_COMPLEXITY_TIMING to compare the time per byte with the threshold", SkipSingle);
+
+    QVERIFY2(cost <= _threshold, qPrintable(QString("%1 ns per byte").arg(cost)));
+}
+
+// Appends a random piece of terminal output to input
+static void appendRandomChunk(QByteArray& input)
+{
+    static const char* const sequences[] = {
+        "\033[%1m", "\033[38;5;%1m", "\033[%1;%1H", "\033[%1L", "\033[%1M", "\033[%1@",
+        "\033[%1P", "\033[%1J", "\033[%1K", "\033[%1;%1r", "\033]0;%1\007", "\033[?%1h",
+        "\033[?%1l", "\033#8", "\033D", "\033M", "\r\n", "\t", "\b"
+    };
+    static const int sequenceCount = sizeof(sequences) / sizeof(sequences[0]);
+
+    switch (qrand() % 6) {
+    case 0: {
+        QString sequence = QString::fromLatin1(sequences[qrand() % sequenceCount]);
+        while (sequence.contains("%1"))
+            sequence = sequence.arg(qrand() % 300);
+        input += sequence.toLatin1();
+    }
+    break;
+    case 1: {
+        // a character followed by combining marks
+        QString text(QChar('a' + qrand() % 26));
+        const int marks = 1 + qrand() % 64;
+        for (int i = 0; i < marks; i++)
+            text += QChar(0x300 + qrand() % 0x70);
+        input += text.toUtf8();
+    }
+    break;
+    case 2:
+        input += "http://example.org/" + QByteArray::number(qrand()) + ' ';
+        break;
+    case 3: {
+        const int count = 1 + qrand() % 200;
+        for (int i = 0; i < count; i++)
+            input += 'a' + qrand() % 26;
+    }
+    break;
+    case 4: {
+        // wide and other non-ASCII characters
+        QString text;
+        const int count = 1 + qrand() % 40;
+        for (int i = 0; i < count; i++)
+            text += QChar(0x100 + qrand() % 0xff00);
+        input += text.toUtf8();
+    }
+    break;
+    default:
+        input += QByteArray(1 + qrand() % 100, '\n');
+        break;
+    }
+}
+
+QByteArray EmulationComplexityTest::minimize(const QByteArray& input) const
+{
+    QByteArray result = input;
+
+    // try removing chunks of decreasing size, keeping each removal which
+    // leaves the input slow
+    for (int chunk = result.size() / 2; chunk >= 1; chunk /= 2) {
+        int pos = 0;
+        while (pos < result.size()) {
+            QByteArray candidate = result;
+            candidate.remove(pos, chunk);
+            if (!candidate.isEmpty() && costPerByte(candidate) > _threshold)
+                result = candidate;
+            else
+                pos += chunk;
+        }
+    }
+
+    return result;
+}
+
+void EmulationComplexityTest::fuzzEmulation()
+{
+    const int iterations = qgetenv("KONSOLE_COMPLEXITY_FUZZ").toInt();
+    if (iterations <= 0)
+        QSKIP("Set KONSOLE_COMPLEXITY_FUZZ to the number of inputs to try", SkipSingle);
+
+    QDir output(QString::fromLocal8Bit(qgetenv("KONSOLE_COMPLEXITY_CORPUS")));
+    int slowInputs = 0;
+
+    for (int i = 0; i < iterations; i++) {
+        QByteArray input;
+        const int size = 4096 + qrand() % 60000;
+        while (input.size() < size)
+            appendRandomChunk(input);
+
+        const qint64 cost = costPerByte(input);
+        if (cost <= _threshold)
+            continue;
+
+        const QByteArray minimized = minimize(input);
+        const QString fileName = output.filePath("slow-" + QCryptographicHash::hash(minimized,
+                                 QCryptographicHash::Sha1).toHex().left(12) + ".txt");
+
+        QFile file(fileName);
+        if (file.open(QIODevice::WriteOnly))
+            file.write(minimized);
+
+        qDebug() << "slow input:" << cost << "ns per byte, minimized to"
+                 << minimized.size() << "bytes in" << fileName;
+        slowInputs++;
+    }
+
+    QCOMPARE(slowInputs, 0);
+}
+
+QTEST_KDEMAIN(EmulationComplexityTest , GUI)
+
+#include "EmulationComplexityTest.moc"
+
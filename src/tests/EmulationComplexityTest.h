@@ -0,0 +1,77 @@
+/*
+    Copyright 2013 by Konsole Developers <konsole-devel@kde.org>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+    02110-1301  USA.
+*/
+
+#ifndef EMULATIONCOMPLEXITYTEST_H
+#define EMULATIONCOMPLEXITYTEST_H
+
+#include <QtCore/QObject>
+
+namespace Konsole
+{
+
+/**
+ * Looks for input which makes the terminal emulation, screen and filters
+ * spend a disproportionate amount of time per byte.
+ *
+ * testCorpus() runs the inputs in data/complexity, which were found to be
+ * slow in the past.  Wall-clock timings are unreliable on a loaded machine,
+ * so it only fails if one of them is slow again when
+ * KONSOLE_COMPLEXITY_TIMING is set.  Otherwise it only checks that each
+ * input is processed.
+ *
+ * fuzzEmulation() generates random input from a mix of escape sequences,
+ * combining characters, format changes and URLs, and minimizes and saves
+ * each input which is slow.  It only runs when KONSOLE_COMPLEXITY_FUZZ is
+ * set to the number of inputs to try.  The minimized inputs are written to
+ * the directory in KONSOLE_COMPLEXITY_CORPUS, or the current directory, and
+ * can be added to data/complexity once the cause is fixed.
+ *
+ * An input is slow when it costs more per byte than plain text does by a
+ * factor which defaults to 20 and can be changed with
+ * KONSOLE_COMPLEXITY_FACTOR.  The cost of plain text is measured when the
+ * test starts, so the threshold follows the speed of the machine.
+ */
+class EmulationComplexityTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void testCorpus_data();
+    void testCorpus();
+    void fuzzEmulation();
+
+private:
+    // returns the cost of processing input in nanoseconds per byte, less
+    // the fixed cost of updating the display
+    qint64 costPerByte(const QByteArray& input) const;
+    // removes parts of input for as long as it stays slow
+    QByteArray minimize(const QByteArray& input) const;
+
+    // nanoseconds per byte above which an input is slow
+    qint64 _threshold;
+    qint64 _fixedCost;
+    // nanoseconds per byte for plain text
+    qint64 _asciiCost;
+};
+
+}
+
+#endif // EMULATIONCOMPLEXITYTEST_H
+
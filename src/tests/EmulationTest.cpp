@@ -0,0 +1,135 @@
+/*
+    Copyright 2013 by Konsole Developers <konsole-devel@kde.org>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+    02110-1301  USA.
+*/
+
+// Own
+#include "EmulationTest.h"
+
+// Qt
+#include <QtCore/QTextCodec>
+#include <QtTest/QSignalSpy>
+
+// KDE
+#include <qtest_kde.h>
+
+// Konsole
+#include "../History.h"
+#include "../ScreenWindow.h"
+#include "../Vt102Emulation.h"
+
+using namespace Konsole;
+
+static QByteArray randomBytes(int count)
+{
+    QByteArray bytes(count, '\0');
+    for (int i = 0; i < count; i++)
+        bytes[i] = qrand() % 256;
+    return bytes;
+}
+
+void EmulationTest::testBinaryOutputGuard()
+{
+    Vt102Emulation emulation;
+    emulation.setCodec(QTextCodec::codecForName("UTF-8"));
+    emulation.setBinaryOutputGuardEnabled(true);
+    emulation.setHistory(CompactHistoryType(1000));
+
+    QSignalSpy spy(&emulation, SIGNAL(outputDiscardingChanged(bool)));
+
+    const QByteArray binary = randomBytes(64 * 1024);
+    emulation.receiveData(binary.constData(), binary.size());
+
+    QVERIFY(emulation.isDiscardingOutput());
+    QCOMPARE(spy.count(), 1);
+    QCOMPARE(spy.at(0).at(0).toBool(), true);
+
+    // further output is discarded without changing the screen
+    const int lines = emulation.lineCount();
+    const QByteArray text = QByteArray("some text\r\n").repeated(100);
+    emulation.receiveData(text.constData(), text.size());
+    QCOMPARE(emulation.lineCount(), lines);
+
+    emulation.resumeOutput();
+    QVERIFY(!emulation.isDiscardingOutput());
+    QCOMPARE(spy.count(), 2);
+    QCOMPARE(spy.at(1).at(0).toBool(), false);
+
+    // a short burst of binary data is not enough to discard output again
+    const QByteArray burst = randomBytes(1024);
+    emulation.receiveData(burst.constData(), burst.size());
+    QVERIFY(!emulation.isDiscardingOutput());
+}
+
+void EmulationTest::testBinaryOutputGuardIgnoresText()
+{
+    Vt102Emulation emulation;
+    emulation.setCodec(QTextCodec::codecForName("UTF-8"));
+    emulation.setBinaryOutputGuardEnabled(true);
+
+    // colored output, line drawing, tabs and non-ASCII text, as printed
+    // by ls, compilers and full screen programs
+    QByteArray text;
+    for (int i = 0; i < 5000; i++) {
+        text += "\033[01;34mdirectory\033[0m\t\033[01;32mscript.sh\033[0m\t";
+        text += QString::fromUtf8("caf\xc3\xa9 \xe6\x97\xa5\xe6\x9c\xac ").toUtf8();
+        text += "\033(0lqqk\033(B\a\b\r\n";
+    }
+    emulation.receiveData(text.constData(), text.size());
+
+    QVERIFY(!emulation.isDiscardingOutput());
+
+    // the guard does nothing when disabled
+    emulation.setBinaryOutputGuardEnabled(false);
+    const QByteArray binary = randomBytes(64 * 1024);
+    emulation.receiveData(binary.constData(), binary.size());
+    QVERIFY(!emulation.isDiscardingOutput());
+}
+
+void EmulationTest::testSelectionChanged()
+{
+    Vt102Emulation emulation;
+    ScreenWindow* window = emulation.createWindow();
+
+    const QByteArray text("first line\r\nsecond line\r\n");
+    emulation.receiveData(text.constData(), text.size());
+
+    QSignalSpy windowSpy(window, SIGNAL(selectionChanged()));
+    QSignalSpy spy(&emulation, SIGNAL(selectionChanged(bool)));
+
+    window->setSelectionStart(0, 0, false);
+    window->setSelectionEnd(4, 1);
+    QCOMPARE(windowSpy.count(), 2);
+    QCOMPARE(spy.count(), 2);
+    QCOMPARE(spy.last().at(0).toBool(), true);
+
+    // moving to the same position while dragging does not change the selection
+    window->setSelectionEnd(4, 1);
+    QCOMPARE(windowSpy.count(), 2);
+    QCOMPARE(spy.count(), 2);
+
+    QVERIFY(window->selectedText(true).startsWith("first line"));
+
+    window->clearSelection();
+    QCOMPARE(spy.count(), 3);
+    QCOMPARE(spy.last().at(0).toBool(), false);
+}
+
+QTEST_KDEMAIN(EmulationTest , GUI)
+
+#include "EmulationTest.moc"
+
@@ -0,0 +1,109 @@
+/*
+    Copyright 2013 by Konsole Developers <konsole-devel@kde.org>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+    02110-1301  USA.
+*/
+
+// Own
+#include "FilterTest.h"
+
+// KDE
+#include <qtest_kde.h>
+
+// Konsole
+#include "../Filter.h"
+
+using namespace Konsole;
+
+static const int COLUMNS = 20;
+
+// Sets the image of chain to lines of text, each padded to COLUMNS, and
+// finds the URLs in it.  Lines in wrapped continue on the next line.
+static void processLines(TerminalImageFilterChain& chain, const QStringList& lines,
+                         const QList<int>& wrapped = QList<int>())
+{
+    QVector<Character> image(lines.count() * COLUMNS);
+    QVector<LineProperty> lineProperties(lines.count(), LINE_DEFAULT);
+
+    for (int line = 0; line < lines.count(); line++) {
+        const QString text = lines[line].leftJustified(COLUMNS, ' ', true);
+        for (int column = 0; column < COLUMNS; column++)
+            image[line * COLUMNS + column] = Character(text[column].unicode());
+        if (wrapped.contains(line))
+            lineProperties[line] = LINE_WRAPPED;
+    }
+
+    chain.setImage(image.constData(), lines.count(), COLUMNS, lineProperties);
+    chain.process();
+}
+
+void FilterTest::testHotSpotsInLines()
+{
+    TerminalImageFilterChain chain;
+    chain.addFilter(new UrlFilter());
+
+    QStringList lines;
+    lines << "see http://a.org/x"
+          << "nothing here"
+          << "http://example.com/a"
+          << "bcdef"
+          << "end http://b.org";
+    processLines(chain, lines, QList<int>() << 2);
+
+    QCOMPARE(chain.hotSpots().count(), 3);
+    QCOMPARE(chain.hotSpotsInLines(0, 4).count(), 3);
+    QCOMPARE(chain.hotSpotsInLines(1, 1).count(), 0);
+
+    // the URL which continues on the wrapped line is listed once
+    QCOMPARE(chain.hotSpotsInLines(2, 3).count(), 1);
+    QCOMPARE(chain.hotSpotsInLines(3, 4).count(), 2);
+
+    const QList<Filter::HotSpot*> spots = chain.hotSpotsInLines(3, 3);
+    QCOMPARE(spots.count(), 1);
+    QCOMPARE(spots.first()->startLine(), 2);
+    QCOMPARE(spots.first()->endLine(), 3);
+}
+
+void FilterTest::testHotSpotAt()
+{
+    TerminalImageFilterChain chain;
+    chain.addFilter(new UrlFilter());
+
+    QStringList lines;
+    lines << "see http://a.org/x"
+          << "nothing here"
+          << "http://example.com/a"
+          << "bcdef";
+    processLines(chain, lines, QList<int>() << 2);
+
+    Filter::HotSpot* spot = chain.hotSpotAt(0, 6);
+    QVERIFY(spot);
+    QCOMPARE(spot->type(), Filter::HotSpot::Link);
+    QCOMPARE(spot->startColumn(), 4);
+
+    QVERIFY(!chain.hotSpotAt(0, 2));
+    QVERIFY(!chain.hotSpotAt(1, 5));
+
+    spot = chain.hotSpotAt(3, 2);
+    QVERIFY(spot);
+    QCOMPARE(spot->startLine(), 2);
+    QCOMPARE(chain.hotSpotAt(2, 10), spot);
+}
+
+QTEST_KDEMAIN_CORE(FilterTest)
+
+#include "FilterTest.moc"
+
@@ -0,0 +1,432 @@
+/*
+    Copyright 2013 by Konsole Developers <konsole-devel@kde.org>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+    02110-1301  USA.
+*/
+
+// Own
+#include "HistoryConformanceTest.h"
+
+// Qt
+#include <QtCore/QScopedPointer>
+#include <QtCore/QStringList>
+#include <QtCore/QVector>
+
+// KDE
+#include <qtest_kde.h>
+
+// Konsole
+#include "../History.h"
+#include "../LineBlock.h"
+
+using namespace Konsole;
+
+// number of lines a limited store can hold in these tests, more than any
+// test adds unless it checks the limit
+static const int MAXIMUM_LINES = 100000;
+
+// returns the type of the store called name
+static HistoryType* createHistoryType(const QString& name, int maximumLines = MAXIMUM_LINES)
+{
+    if (name == "file")
+        return new HistoryTypeFile();
+    else if (name == "compact")
+        return new CompactHistoryType(maximumLines);
+    else if (name == "compact, deduplicated")
+        return new CompactHistoryType(maximumLines, true);
+
+    Q_ASSERT(false);
+    return 0;
+}
+
+// returns a new, empty history of the store called name
+static HistoryScroll* createHistory(const QString& name)
+{
+    QScopedPointer<HistoryType> type(createHistoryType(name));
+    return type->scroll(0);
+}
+
+static void addStores()
+{
+    QTest::addColumn<QString>("store");
+
+    QTest::newRow("file") << "file";
+    QTest::newRow("compact") << "compact";
+    QTest::newRow("compact, deduplicated") << "compact, deduplicated";
+}
+
+// returns the cells of a test line, with varying length, text and format.
+// some lines are empty, some are repeated, and some are longer than any
+// terminal is likely to be wide
+static QVector<Character> testLine(int line)
+{
+    int length = (line * 37) % 130;
+    if (line % 11 == 0)
+        length = 0;
+    else if (line % 97 == 0)
+        length = 3000;
+
+    // every seventh line uses the text of one of a few lines, so that
+    // some lines are repeated
+    const int seed = (line % 7 == 0) ? line % 5 : line;
+
+    QVector<Character> cells(length);
+    for (int i = 0; i < length; i++) {
+        cells[i].character = 'a' + (seed + i) % 26;
+        cells[i].rendition = (i / 8 % 3 == 1) ? RE_BOLD : DEFAULT_RENDITION;
+        cells[i].foregroundColor = CharacterColor(COLOR_SPACE_SYSTEM, (seed + i / 16) % 8);
+        cells[i].backgroundColor = CharacterColor(COLOR_SPACE_256, i < length / 2 ? 0 : seed % 256);
+    }
+    return cells;
+}
+
+static bool testLineWrapped(int line)
+{
+    return line % 3 == 0;
+}
+
+// returns a block holding test lines firstLine .. firstLine + count - 1
+static LineBlock testBlock(int firstLine, int count)
+{
+    LineBlock block;
+    for (int line = firstLine; line < firstLine + count; line++) {
+        const QVector<Character> cells = testLine(line);
+        Character* characters = block.appendLine(cells.size(), testLineWrapped(line) ? LINE_WRAPPED : LINE_DEFAULT);
+        qCopy(cells.constBegin(), cells.constEnd(), characters);
+    }
+    return block;
+}
+
+// adds test lines firstLine .. firstLine + count - 1 one at a time
+static void addTestLines(HistoryScroll* history, int firstLine, int count)
+{
+    for (int line = firstLine; line < firstLine + count; line++) {
+        history->addCellsVector(testLine(line));
+        history->addLine(testLineWrapped(line));
+    }
+}
+
+// checks that the lines of history, starting at historyLine, are test lines
+// firstLine .. firstLine + count - 1, reading them one at a time
+static void verifyTestLines(HistoryScroll* history, int historyLine, int firstLine, int count)
+{
+    for (int i = 0; i < count; i++) {
+        const QVector<Character> expected = testLine(firstLine + i);
+        const int line = historyLine + i;
+
+        QCOMPARE(history->getLineLen(line), expected.size());
+        QCOMPARE(history->isWrappedLine(line), testLineWrapped(firstLine + i));
+
+        QVector<Character> cells(expected.size());
+        history->getCells(line, 0, cells.size(), cells.data());
+        QVERIFY(cells == expected);
+
+        // part of the line, starting inside a format run
+        if (expected.size() > 20) {
+            QVector<Character> part(expected.size() - 13);
+            history->getCells(line, 5, part.size(), part.data());
+            QVERIFY(part == expected.mid(5, part.size()));
+        }
+    }
+}
+
+// checks that the lines of block, starting at blockLine, are test lines
+// firstLine .. firstLine + count - 1
+static void verifyTestBlock(const LineBlock& block, int blockLine, int firstLine, int count)
+{
+    for (int i = 0; i < count; i++) {
+        const QVector<Character> expected = testLine(firstLine + i);
+        const int line = blockLine + i;
+
+        QCOMPARE(block.lineLength(line), expected.size());
+        QCOMPARE(bool(block.lineProperties(line) & LINE_WRAPPED), testLineWrapped(firstLine + i));
+        QVERIFY(qEqual(expected.constBegin(), expected.constEnd(), block.characters(line)));
+    }
+}
+
+void HistoryConformanceTest::testEmpty_data()
+{
+    addStores();
+}
+
+void HistoryConformanceTest::testEmpty()
+{
+    QFETCH(QString, store);
+    QScopedPointer<HistoryScroll> history(createHistory(store));
+
+    QVERIFY(history->hasScroll());
+    QCOMPARE(history->getLines(), 0);
+
+    LineBlock block;
+    history->readLines(0, 0, &block);
+    QCOMPARE(block.lineCount(), 0);
+
+    history->addLines(LineBlock());
+    history->flush();
+    QCOMPARE(history->getLines(), 0);
+
+    const HistoryScroll::MemoryUsage usage = history->memoryUsage();
+    QVERIFY(usage.memoryBytes >= 0);
+    QVERIFY(usage.fileBytes >= 0);
+}
+
+void HistoryConformanceTest::testAddLine_data()
+{
+    addStores();
+}
+
+// adds lines one at a time, and checks them both before and after they
+// are flushed
+void HistoryConformanceTest::testAddLine()
+{
+    QFETCH(QString, store);
+    QScopedPointer<HistoryScroll> history(createHistory(store));
+
+    addTestLines(history.data(), 0, 500);
+    QCOMPARE(history->getLines(), 500);
+    verifyTestLines(history.data(), 0, 0, 500);
+
+    history->flush();
+    QCOMPARE(history->getLines(), 500);
+    verifyTestLines(history.data(), 0, 0, 500);
+}
+
+void HistoryConformanceTest::testAddLines_data()
+{
+    addStores();
+}
+
+// adds lines in batches, and checks that they are the same as lines added
+// one at a time
+void HistoryConformanceTest::testAddLines()
+{
+    QFETCH(QString, store);
+    QScopedPointer<HistoryScroll> history(createHistory(store));
+
+    history->addLines(testBlock(0, 300));
+    addTestLines(history.data(), 300, 100);
+    history->addLines(testBlock(400, 1));
+    history->addLines(testBlock(401, 99));
+
+    QCOMPARE(history->getLines(), 500);
+    verifyTestLines(history.data(), 0, 0, 500);
+
+    history->flush();
+    verifyTestLines(history.data(), 0, 0, 500);
+}
+
+void HistoryConformanceTest::testReadLines_data()
+{
+    addStores();
+}
+
+// reads ranges at the start, middle and end of the history, before and
+// after the lines are flushed
+void HistoryConformanceTest::testReadLines()
+{
+    QFETCH(QString, store);
+    QScopedPointer<HistoryScroll> history(createHistory(store));
+
+    addTestLines(history.data(), 0, 500);
+
+    for (int pass = 0; pass < 2; pass++) {
+        LineBlock block;
+        history->readLines(0, 500, &block);
+        QCOMPARE(block.lineCount(), 500);
+        verifyTestBlock(block, 0, 0, 500);
+
+        // ranges are appended to what the block already holds
+        block.clear();
+        history->readLines(0, 1, &block);
+        history->readLines(250, 0, &block);
+        history->readLines(123, 77, &block);
+        history->readLines(499, 1, &block);
+        QCOMPARE(block.lineCount(), 79);
+        verifyTestBlock(block, 0, 0, 1);
+        verifyTestBlock(block, 1, 123, 77);
+        verifyTestBlock(block, 78, 499, 1);
+
+        history->flush();
+    }
+}
+
+void HistoryConformanceTest::testCopyLines_data()
+{
+    QTest::addColumn<QString>("source");
+    QTest::addColumn<QString>("destination");
+
+    const QStringList stores = QStringList() << "file" << "compact" << "compact, deduplicated";
+    foreach(const QString& source, stores) {
+        foreach(const QString& destination, stores) {
+            QTest::newRow(QString("%1 to %2").arg(source, destination).toLatin1().constData())
+                    << source << destination;
+        }
+    }
+}
+
+// changes the type of a history, which keeps the lines that fit in the new one
+void HistoryConformanceTest::testCopyLines()
+{
+    QFETCH(QString, source);
+    QFETCH(QString, destination);
+
+    HistoryScroll* history = createHistory(source);
+    addTestLines(history, 0, 2500);
+
+    QScopedPointer<HistoryType> type(createHistoryType(destination));
+    history = type->scroll(history);
+    QCOMPARE(history->getLines(), 2500);
+    verifyTestLines(history, 0, 0, 2500);
+    delete history;
+
+    // a limited history keeps the most recent lines
+    history = createHistory(source);
+    addTestLines(history, 0, 2500);
+
+    type.reset(createHistoryType(destination, 1000));
+    history = type->scroll(history);
+    if (type->isUnlimited()) {
+        QCOMPARE(history->getLines(), 2500);
+    } else {
+        QCOMPARE(history->getLines(), 1000);
+        verifyTestLines(history, 0, 1500, 1000);
+    }
+    delete history;
+}
+
+void HistoryConformanceTest::testMemoryUsage_data()
+{
+    addStores();
+}
+
+// the memory and disk space used grows with the number of lines stored
+void HistoryConformanceTest::testMemoryUsage()
+{
+    QFETCH(QString, store);
+    QScopedPointer<HistoryScroll> history(createHistory(store));
+
+    const HistoryScroll::MemoryUsage empty = history->memoryUsage();
+
+    addTestLines(history.data(), 0, 20000);
+    history->flush();
+
+    const HistoryScroll::MemoryUsage full = history->memoryUsage();
+    QVERIFY(full.memoryBytes >= empty.memoryBytes);
+    QVERIFY(full.fileBytes >= empty.fileBytes);
+
+    // the text alone takes more than a byte per character
+    qint64 textBytes = 0;
+    for (int line = 0; line < 20000; line++)
+        textBytes += testLine(line).size();
+    QVERIFY(full.memoryBytes + full.fileBytes > textBytes);
+
+    qDebug() << store << "uses" << full.memoryBytes / 1024 << "KiB of memory and"
+             << full.fileBytes / 1024 << "KiB of disk for 20000 lines";
+}
+
+// Standard measurements, which every store reports the same way
+
+void HistoryConformanceTest::benchmarkAddLine_data()
+{
+    addStores();
+}
+
+void HistoryConformanceTest::benchmarkAddLine()
+{
+    QFETCH(QString, store);
+
+    QList< QVector<Character> > lines;
+    for (int line = 0; line < 10000; line++)
+        lines << testLine(line);
+
+    QBENCHMARK {
+        QScopedPointer<HistoryScroll> history(createHistory(store));
+        for (int line = 0; line < lines.count(); line++) {
+            history->addCellsVector(lines[line]);
+            history->addLine(testLineWrapped(line));
+        }
+        history->flush();
+    }
+}
+
+void HistoryConformanceTest::benchmarkAddLines_data()
+{
+    addStores();
+}
+
+void HistoryConformanceTest::benchmarkAddLines()
+{
+    QFETCH(QString, store);
+
+    const LineBlock block = testBlock(0, 10000);
+
+    QBENCHMARK {
+        QScopedPointer<HistoryScroll> history(createHistory(store));
+        history->addLines(block);
+        history->flush();
+    }
+}
+
+void HistoryConformanceTest::benchmarkReadLines_data()
+{
+    addStores();
+}
+
+void HistoryConformanceTest::benchmarkReadLines()
+{
+    QFETCH(QString, store);
+
+    QScopedPointer<HistoryScroll> history(createHistory(store));
+    history->addLines(testBlock(0, 10000));
+    history->flush();
+
+    LineBlock block;
+    QBENCHMARK {
+        for (int line = 0; line < 10000; line += 1000) {
+            block.clear();
+            history->readLines(line, 1000, &block);
+        }
+    }
+}
+
+void HistoryConformanceTest::benchmarkGetCells_data()
+{
+    addStores();
+}
+
+// reads the lines of a screen at a time from places all over the history,
+// as scrolling does
+void HistoryConformanceTest::benchmarkGetCells()
+{
+    QFETCH(QString, store);
+
+    QScopedPointer<HistoryScroll> history(createHistory(store));
+    history->addLines(testBlock(0, 10000));
+    history->flush();
+
+    QVector<Character> cells(3000);
+    QBENCHMARK {
+        for (int screen = 0; screen < 100; screen++) {
+            const int firstLine = (screen * 7919) % (10000 - 50);
+            for (int line = firstLine; line < firstLine + 50; line++)
+                history->getCells(line, 0, history->getLineLen(line), cells.data());
+        }
+    }
+}
+
+QTEST_KDEMAIN_CORE(HistoryConformanceTest)
+
+#include "HistoryConformanceTest.moc"
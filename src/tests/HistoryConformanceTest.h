@@ -0,0 +1,65 @@
+/*
+    Copyright 2013 by Konsole Developers <konsole-devel@kde.org>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+    02110-1301  USA.
+*/
+
+#ifndef HISTORYCONFORMANCETEST_H
+#define HISTORYCONFORMANCETEST_H
+
+#include <QtCore/QObject>
+
+namespace Konsole
+{
+
+/**
+ * Checks that every way of storing the history behaves the same, and
+ * measures how fast each of them adds and reads lines.
+ *
+ * A new store is covered by adding it to createHistory() and addStores().
+ */
+class HistoryConformanceTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testEmpty_data();
+    void testEmpty();
+    void testAddLine_data();
+    void testAddLine();
+    void testAddLines_data();
+    void testAddLines();
+    void testReadLines_data();
+    void testReadLines();
+    void testCopyLines_data();
+    void testCopyLines();
+    void testMemoryUsage_data();
+    void testMemoryUsage();
+
+    void benchmarkAddLine_data();
+    void benchmarkAddLine();
+    void benchmarkAddLines_data();
+    void benchmarkAddLines();
+    void benchmarkReadLines_data();
+    void benchmarkReadLines();
+    void benchmarkGetCells_data();
+    void benchmarkGetCells();
+};
+
+}
+
+#endif // HISTORYCONFORMANCETEST_H
+
@@ -0,0 +1,578 @@
+/*
+    Copyright 2013 by Konsole Developers <konsole-devel@kde.org>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+    02110-1301  USA.
+*/
+
+// Own
+#include "HistoryTest.h"
+
+// Qt
+#include <QtCore/QDir>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QFile>
+#include <QtCore/QThread>
+#include <QtCore/QThreadPool>
+#include <QtCore/QVector>
+
+// KDE
+#include <qtest_kde.h>
+
+// Konsole
+#include "../History.h"
+
+using namespace Konsole;
+
+void HistoryTest::testSegmentBoundaries()
+{
+    HistoryFile file(1000);
+
+    QByteArray data;
+    for (int i = 0; i < 3500; i++)
+        data += char(i % 251);
+
+    // add in uneven chunks so that some of them span two segments
+    for (int pos = 0; pos < data.size(); pos += 333)
+        file.add((const unsigned char*)data.constData() + pos, qMin(333, data.size() - pos));
+
+    QCOMPARE(file.len(), qint64(data.size()));
+
+    QByteArray result(data.size(), 0);
+    file.get((unsigned char*)result.data(), data.size(), 0);
+    QCOMPARE(result, data);
+
+    // a read spanning three segments
+    result.fill(0, 1500);
+    file.get((unsigned char*)result.data(), 1500, 900);
+    QCOMPARE(result, data.mid(900, 1500));
+
+    // the same reads from mmap'ed segments
+    file.map();
+    result.fill(0, data.size());
+    file.get((unsigned char*)result.data(), data.size(), 0);
+    QCOMPARE(result, data);
+    file.unmap();
+}
+
+static int openDescriptorCount()
+{
+    return QDir("/proc/self/fd").entryList(QDir::Files | QDir::System).count();
+}
+
+void HistoryTest::testSegmentDescriptors()
+{
+    if (!QDir("/proc/self/fd").exists())
+        QSKIP("Open descriptors can't be counted on this system", SkipAll);
+
+    const int initialCount = openDescriptorCount();
+
+    HistoryFile file(100);
+    QByteArray data;
+    for (int i = 0; i < 1050; i++)
+        data += char(i % 251);
+    file.add((const unsigned char*)data.constData(), data.size());
+
+    // only the segment being written to is open
+    QCOMPARE(openDescriptorCount(), initialCount + 1);
+
+    // full segments are opened again to read them, one at a time
+    QByteArray result(data.size(), 0);
+    file.get((unsigned char*)result.data(), data.size(), 0);
+    QCOMPARE(result, data);
+    QCOMPARE(openDescriptorCount(), initialCount + 2);
+
+    // mapped segments don't need a descriptor
+    file.map();
+    result.fill(0);
+    file.get((unsigned char*)result.data(), data.size(), 0);
+    QCOMPARE(result, data);
+    QCOMPARE(openDescriptorCount(), initialCount + 1);
+    file.unmap();
+
+    // and can be read again after they are unmapped
+    result.fill(0);
+    file.get((unsigned char*)result.data(), 300, 250);
+    QCOMPARE(result.left(300), data.mid(250, 300));
+    QCOMPARE(openDescriptorCount(), initialCount + 2);
+}
+
+void HistoryTest::testFileHistoryLines()
+{
+    HistoryTypeFile type;
+    HistoryScroll* history = type.scroll(0);
+
+    for (int line = 0; line < 1000; line++) {
+        QVector<Character> cells(line % 80);
+        for (int i = 0; i < cells.size(); i++)
+            cells[i].character = 'a' + (line + i) % 26;
+        history->addCellsVector(cells);
+        history->addLine(line % 3 == 0);
+    }
+
+    QCOMPARE(history->getLines(), 1000);
+    for (int line = 0; line < 1000; line++) {
+        QCOMPARE(history->getLineLen(line), line % 80);
+        QCOMPARE(history->isWrappedLine(line), line % 3 == 0);
+
+        QVector<Character> cells(line % 80);
+        history->getCells(line, 0, cells.size(), cells.data());
+        for (int i = 0; i < cells.size(); i++)
+            QCOMPARE(cells[i].character, quint16('a' + (line + i) % 26));
+    }
+
+    delete history;
+}
+
+// Adds more lines than a compact history can hold, with and without
+// flushing in between, and checks that the most recent lines are kept
+void HistoryTest::testCompactHistoryLimit()
+{
+    CompactHistoryType type(100);
+    HistoryScroll* history = type.scroll(0);
+
+    for (int line = 0; line < 5000; line++) {
+        QVector<Character> cells(1);
+        cells[0].character = line % 65536;
+        history->addCellsVector(cells);
+        history->addLine(false);
+
+        if (line % 700 == 0)
+            history->flush();
+    }
+
+    const int lines = history->getLines();
+    QVERIFY(lines >= 100 && lines <= 101);
+
+    Character last;
+    history->getCells(lines - 1, 0, 1, &last);
+    QCOMPARE(last.character, quint16(4999));
+
+    history->flush();
+    QCOMPARE(history->getLines(), lines);
+    history->getCells(0, 0, 1, &last);
+    QCOMPARE(last.character, quint16(5000 - lines));
+
+    delete history;
+}
+
+void HistoryTest::testSkipDroppedLines()
+{
+    CompactHistoryScroll history(100);
+
+    LineBlock block;
+    for (int line = 0; line < 1000; line++) {
+        Character* cells = block.appendLine(1, line % 3 == 0 ? LINE_WRAPPED : LINE_DEFAULT);
+        cells[0].character = line;
+    }
+    history.addLines(block);
+
+    // only the lines which would have survived adding them one at a time
+    // are kept, and the others are never compacted
+    QCOMPARE(history.getLines(), 101);
+    QCOMPARE(history.skippedLineCount(), qint64(899));
+
+    history.flush();
+    for (int line = 0; line < 101; line++) {
+        Character cell;
+        history.getCells(line, 0, 1, &cell);
+        QCOMPARE(cell.character, quint16(899 + line));
+        QCOMPARE(history.isWrappedLine(line), (899 + line) % 3 == 0);
+    }
+}
+
+void HistoryTest::testSkipLinesDuringFlood()
+{
+    CompactHistoryScroll history(2000);
+
+    // 5000 lines between two display updates.  nothing is known about the
+    // rate of output yet, so the queued lines are compacted as usual
+    for (int line = 0; line < 5000; line++) {
+        QVector<Character> cells(1);
+        cells[0].character = line;
+        history.addCellsVector(cells);
+        history.addLine(false);
+    }
+    history.flush();
+    QCOMPARE(history.skippedLineCount(), qint64(0));
+
+    // the next 5000 lines are expected to push each other out before the
+    // next update, so they stay queued and most of them are dropped
+    for (int line = 5000; line < 10000; line++) {
+        QVector<Character> cells(1);
+        cells[0].character = line;
+        history.addCellsVector(cells);
+        history.addLine(false);
+    }
+    QVERIFY(history.skippedLineCount() > 0);
+    history.flush();
+
+    const int lines = history.getLines();
+    QCOMPARE(lines, 2001);
+    for (int line = 0; line < lines; line++) {
+        Character cell;
+        history.getCells(line, 0, 1, &cell);
+        QCOMPARE(cell.character, quint16(10000 - lines + line));
+    }
+
+    // the count starts from zero again once it has been taken
+    QVERIFY(history.takeSkippedLineCount() > 0);
+    QCOMPARE(history.skippedLineCount(), qint64(0));
+}
+
+void HistoryTest::testBoundedDeferredLines()
+{
+    CompactHistoryScroll history(50000);
+
+    // two intervals of 60000 lines, the second of which is expected to
+    // push its own lines out of the history before the next update
+    for (int interval = 0; interval < 2; interval++) {
+        for (int line = 0; line < 60000; line++) {
+            QVector<Character> cells(1);
+            cells[0].character = line;
+            history.addCellsVector(cells);
+            history.addLine(false);
+        }
+        history.flush();
+    }
+
+    // the queue is compacted once it grows past its bound rather than
+    // holding up to 50000 uncompacted lines, so the lines which are
+    // dropped later have already been compacted
+    QCOMPARE(history.skippedLineCount(), qint64(0));
+    QCOMPARE(history.getLines(), 50001);
+}
+
+// Returns a history line holding text
+static QVector<Character> textLine(const QString& text)
+{
+    QVector<Character> cells(text.length());
+    for (int i = 0; i < text.length(); i++)
+        cells[i].character = text[i].unicode();
+    return cells;
+}
+
+void HistoryTest::testDeduplication()
+{
+    CompactHistoryScroll history(1000);
+    history.setDeduplicationEnabled(true);
+
+    QVector<Character> colored = textLine("GET /health 200");
+    colored[4].foregroundColor = CharacterColor(COLOR_SPACE_SYSTEM, 2);
+
+    const QVector<Character> lines[] = {
+        textLine("GET /health 200"),
+        textLine(""),
+        colored,
+        textLine("GET /health 200"),
+        textLine(""),
+        colored,
+    };
+    const bool wrapped[] = { false, false, false, false, false, true };
+
+    for (int i = 0; i < 6; i++) {
+        history.addCellsVector(lines[i]);
+        history.addLine(wrapped[i]);
+    }
+    history.flush();
+
+    // the plain and colored lines must not be merged, and neither may lines
+    // which only differ in the wrap flag
+    CompactHistoryScroll::DeduplicationStatistics statistics = history.deduplicationStatistics();
+    QCOMPARE(statistics.lines, 6);
+    QCOMPARE(statistics.storedLines, 4);
+    QVERIFY(statistics.savedBytes > 0);
+
+    for (int i = 0; i < 6; i++) {
+        QCOMPARE(history.getLineLen(i), lines[i].size());
+        QCOMPARE(history.isWrappedLine(i), wrapped[i]);
+
+        QVector<Character> result(lines[i].size());
+        history.getCells(i, 0, result.size(), result.data());
+        QVERIFY(result == lines[i]);
+    }
+
+    // dropping the first occurrences of shared lines keeps the later ones
+    history.setMaxNbLines(3);
+    statistics = history.deduplicationStatistics();
+    QCOMPARE(statistics.lines, 3);
+    QCOMPARE(statistics.storedLines, 3);
+    QCOMPARE(statistics.savedBytes, qint64(0));
+
+    QVector<Character> result(lines[3].size());
+    history.getCells(0, 0, result.size(), result.data());
+    QVERIFY(result == lines[3]);
+}
+
+void HistoryTest::benchmarkDeduplication_data()
+{
+    QTest::addColumn<QStringList>("corpus");
+    QTest::addColumn<bool>("deduplicate");
+
+    // log output with a mix of repeated and unique lines
+    QStringList healthChecks;
+    for (int i = 0; i < 20000; i++) {
+        if (i % 10 == 0)
+            healthChecks << QString("2013-05-01 12:%1 request %2 served").arg(i % 60).arg(i);
+        else
+            healthChecks << "GET /health HTTP/1.1 200 OK";
+    }
+
+    QStringList separators;
+    for (int i = 0; i < 20000; i++)
+        separators << ((i % 4 == 0) ? QString("build step %1 finished").arg(i) : QString());
+
+    QStringList unique;
+    for (int i = 0; i < 20000; i++)
+        unique << QString("line %1 of output which never repeats").arg(i);
+
+    QTest::newRow("health checks") << healthChecks << false;
+    QTest::newRow("health checks, deduplicated") << healthChecks << true;
+    QTest::newRow("separators") << separators << false;
+    QTest::newRow("separators, deduplicated") << separators << true;
+    QTest::newRow("unique") << unique << false;
+    QTest::newRow("unique, deduplicated") << unique << true;
+
+    // a real log can be used by setting KONSOLE_HISTORY_CORPUS to its path
+    QFile file(QString::fromLocal8Bit(qgetenv("KONSOLE_HISTORY_CORPUS")));
+    if (!file.fileName().isEmpty() && file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        const QStringList corpus = QString::fromLocal8Bit(file.readAll()).split('\n');
+        QTest::newRow("corpus") << corpus << false;
+        QTest::newRow("corpus, deduplicated") << corpus << true;
+    }
+}
+
+// Measures the cost of storing lines with and without deduplication, and
+// reports how much memory deduplication saves
+void HistoryTest::benchmarkDeduplication()
+{
+    QFETCH(QStringList, corpus);
+    QFETCH(bool, deduplicate);
+
+    QList< QVector<Character> > lines;
+    foreach(const QString& text, corpus) {
+        lines << textLine(text);
+    }
+
+    CompactHistoryScroll::DeduplicationStatistics statistics;
+    QBENCHMARK {
+        CompactHistoryScroll history(lines.count());
+        history.setDeduplicationEnabled(deduplicate);
+        foreach(const QVector<Character>& line, lines) {
+            history.addCellsVector(line);
+            history.addLine(false);
+        }
+        history.flush();
+        statistics = history.deduplicationStatistics();
+    }
+
+    qDebug() << statistics.lines << "lines stored as" << statistics.storedLines
+             << "lines, saving" << statistics.savedBytes / 1024 << "KiB";
+}
+
+void HistoryTest::testFormatRuns_data()
+{
+    QTest::addColumn<bool>("compact");
+
+    QTest::newRow("file") << false;
+    QTest::newRow("compact") << true;
+}
+
+// Checks that the colors and renditions of a line survive being stored in
+// the history, reading back the whole line and ranges inside format runs
+void HistoryTest::testFormatRuns()
+{
+    QFETCH(bool, compact);
+
+    HistoryScroll* history = compact ? CompactHistoryType(100).scroll(0)
+                             : HistoryTypeFile().scroll(0);
+
+    QVector<Character> cells(60);
+    for (int i = 0; i < cells.size(); i++) {
+        cells[i].character = 'A' + i % 26;
+        cells[i].rendition = (i / 10 == 2) ? RE_BOLD : DEFAULT_RENDITION;
+        cells[i].foregroundColor = CharacterColor(COLOR_SPACE_SYSTEM, (i / 20) % 8);
+        cells[i].backgroundColor = CharacterColor(COLOR_SPACE_256, i < 45 ? 0 : 200);
+    }
+
+    history->addCellsVector(cells);
+    history->addLine(true);
+    history->addCellsVector(QVector<Character>());
+    history->addLine(false);
+
+    QCOMPARE(history->getLines(), 2);
+    QCOMPARE(history->getLineLen(0), cells.size());
+    QCOMPARE(history->getLineLen(1), 0);
+    QVERIFY(history->isWrappedLine(0));
+    QVERIFY(!history->isWrappedLine(1));
+
+    // check the lines both while they are queued and after flush() has
+    // stored them
+    for (int pass = 0; pass < 2; pass++) {
+        QVector<Character> result(cells.size());
+        history->getCells(0, 0, cells.size(), result.data());
+        QVERIFY(result == cells);
+
+        history->getCells(0, 15, 32, result.data());
+        for (int i = 0; i < 32; i++)
+            QVERIFY(result[i] == cells[15 + i]);
+
+        QVERIFY(history->isWrappedLine(0));
+        QCOMPARE(history->getLineLen(1), 0);
+
+        history->flush();
+    }
+
+    delete history;
+}
+
+// Writes more than 4 GB of line records to a file history, which overflowed
+// the 32-bit offsets used previously.  This takes a while and needs plenty of
+// free space in the temporary directory, so it only runs when
+// KONSOLE_HISTORY_SOAK_TEST is set.
+void HistoryTest::testFileHistoryPast4GB()
+{
+    if (qgetenv("KONSOLE_HISTORY_SOAK_TEST").isEmpty())
+        QSKIP("Set KONSOLE_HISTORY_SOAK_TEST to write more than 4 GB of history", SkipSingle);
+
+    const int columns = 1000;
+    const qint64 targetSize = Q_INT64_C(4500) * 1024 * 1024;
+    const int lineCount = targetSize / (columns * sizeof(quint16)) + 1;
+
+    HistoryTypeFile type;
+    HistoryScroll* history = type.scroll(0);
+
+    QVector<Character> cells(columns);
+    for (int line = 0; line < lineCount; line++) {
+        // tag the first and last cell of each line with the line number
+        cells[0].character = line % 65536;
+        cells[columns - 1].character = (line / 65536) % 65536;
+        history->addCellsVector(cells);
+        history->addLine(false);
+    }
+
+    QCOMPARE(history->getLines(), lineCount);
+
+    const int step = lineCount / 1000;
+    for (int line = 0; line < lineCount; line += step) {
+        QCOMPARE(history->getLineLen(line), columns);
+
+        Character first;
+        Character last;
+        history->getCells(line, 0, 1, &first);
+        history->getCells(line, columns - 1, 1, &last);
+        QCOMPARE(first.character, quint16(line % 65536));
+        QCOMPARE(last.character, quint16((line / 65536) % 65536));
+    }
+
+    delete history;
+}
+
+// Returns a compact history holding lineCount lines, some of them shared
+static HistoryScroll* createLargeHistory(int lineCount)
+{
+    CompactHistoryScroll* history = new CompactHistoryScroll(lineCount);
+    history->setDeduplicationEnabled(true);
+
+    for (int line = 0; line < lineCount; line++) {
+        if (line % 4 == 0)
+            history->addCellsVector(textLine("GET /health 200"));
+        else
+            history->addCellsVector(textLine(QString("request %1 served in %2 ms").arg(line).arg(line % 97)));
+        history->addLine(false);
+    }
+    history->flush();
+
+    return history;
+}
+
+// Records the thread which deletes it
+class ThreadRecordingHistory : public HistoryScrollNone
+{
+public:
+    explicit ThreadRecordingHistory(QThread** deletingThread)
+        : _deletingThread(deletingThread) {
+    }
+    virtual ~ThreadRecordingHistory() {
+        *_deletingThread = QThread::currentThread();
+    }
+
+private:
+    QThread** _deletingThread;
+};
+
+void HistoryTest::testDeleteInBackground()
+{
+    QThread* deletingThread = 0;
+    HistoryScroll::deleteInBackground(new ThreadRecordingHistory(&deletingThread));
+    QThreadPool::globalInstance()->waitForDone();
+    QVERIFY(deletingThread);
+    QVERIFY(deletingThread != QThread::currentThread());
+
+    // handing over a large history returns without waiting for it to be freed
+    HistoryScroll* compact = createLargeHistory(200000);
+    QElapsedTimer timer;
+    timer.start();
+    HistoryScroll::deleteInBackground(compact);
+    QVERIFY2(timer.elapsed() < 100, qPrintable(QString("took %1 ms").arg(timer.elapsed())));
+
+    const bool canCountDescriptors = QDir("/proc/self/fd").exists();
+    const int descriptorCount = canCountDescriptors ? openDescriptorCount() : 0;
+    HistoryScroll* file = HistoryTypeFile().scroll(0);
+    for (int line = 0; line < 1000; line++) {
+        file->addCellsVector(textLine(QString("line %1").arg(line)));
+        file->addLine(false);
+    }
+    if (canCountDescriptors)
+        QVERIFY(openDescriptorCount() > descriptorCount);
+    HistoryScroll::deleteInBackground(file);
+
+    HistoryScroll::deleteInBackground(0);
+
+    // the segment files are closed once the job has finished
+    QThreadPool::globalInstance()->waitForDone();
+    if (canCountDescriptors)
+        QCOMPARE(openDescriptorCount(), descriptorCount);
+}
+
+void HistoryTest::benchmarkDeleteHistory_data()
+{
+    QTest::addColumn<bool>("background");
+
+    QTest::newRow("delete") << false;
+    QTest::newRow("delete in background") << true;
+}
+
+// Measures how long clearing a large history blocks the caller for
+void HistoryTest::benchmarkDeleteHistory()
+{
+    QFETCH(bool, background);
+
+    HistoryScroll* history = createLargeHistory(500000);
+
+    QBENCHMARK_ONCE {
+        if (background)
+            HistoryScroll::deleteInBackground(history);
+        else
+            delete history;
+    }
+
+    QThreadPool::globalInstance()->waitForDone();
+}
+
+QTEST_KDEMAIN_CORE(HistoryTest)
+
+#include "HistoryTest.moc"
+
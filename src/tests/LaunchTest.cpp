@@ -0,0 +1,142 @@
+/*
+    Copyright 2013 by Konsole Developers <konsole-devel@kde.org>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+    02110-1301  USA.
+*/
+
+// Own
+#include "LaunchTest.h"
+
+// Qt
+#include <QtCore/QCoreApplication>
+#include <QtCore/QEventLoop>
+#include <QtCore/QFile>
+#include <QtCore/QProcess>
+#include <QtCore/QTimer>
+#include <QtDBus/QDBusConnection>
+
+// KDE
+#include <qtest_kde.h>
+
+using namespace Konsole;
+
+int FakeLauncher::openSession(const QString& profile, const QString& directory,
+                              const QStringList& command, bool newWindow)
+{
+    this->profile = profile;
+    this->directory = directory;
+    this->command = command;
+    this->newWindow = newWindow;
+
+    return ++requests;
+}
+
+void LaunchTest::initTestCase()
+{
+    if (!QDBusConnection::sessionBus().isConnected())
+        QSKIP("Session bus not found", SkipAll);
+
+    // konsole-launch is built in the directory above the tests
+    const QString program = QCoreApplication::applicationDirPath() + "/../konsole-launch";
+    if (!QFile::exists(program))
+        QSKIP("konsole-launch not found", SkipAll);
+
+    _service = QString("org.kde.konsole.launchtest-%1").arg(QCoreApplication::applicationPid());
+    QVERIFY(QDBusConnection::sessionBus().registerService(_service));
+
+    _launcher = new FakeLauncher();
+    QVERIFY(QDBusConnection::sessionBus().registerObject("/Launcher", _launcher,
+            QDBusConnection::ExportScriptableSlots));
+}
+
+void LaunchTest::cleanupTestCase()
+{
+    QDBusConnection::sessionBus().unregisterObject("/Launcher");
+    QDBusConnection::sessionBus().unregisterService(_service);
+    delete _launcher;
+}
+
+bool LaunchTest::launch(const QStringList& arguments, QByteArray* output)
+{
+    QProcess process;
+    QStringList environment = QProcess::systemEnvironment();
+    environment << "KONSOLE_LAUNCH_SERVICE=" + _service;
+    process.setEnvironment(environment);
+
+    // the fake launcher answers the request from this event loop
+    QEventLoop loop;
+    connect(&process, SIGNAL(finished(int,QProcess::ExitStatus)), &loop, SLOT(quit()));
+    QTimer::singleShot(10000, &loop, SLOT(quit()));
+    process.start(QCoreApplication::applicationDirPath() + "/../konsole-launch", arguments);
+    if (!process.waitForStarted())
+        return false;
+
+    loop.exec();
+
+    if (process.state() != QProcess::NotRunning) {
+        process.kill();
+        process.waitForFinished(1000);
+        return false;
+    }
+
+    if (output)
+        *output = process.readAllStandardOutput();
+
+    return process.exitStatus() == QProcess::NormalExit && process.exitCode() == 0;
+}
+
+void LaunchTest::testOpenSession()
+{
+    const int requests = _launcher->requests;
+
+    QStringList arguments;
+    arguments << "--profile" << "Shell" << "--workdir" << "/tmp"
+              << "-e" << "top" << "-d" << "5";
+    QByteArray output;
+    QVERIFY(launch(arguments, &output));
+
+    QCOMPARE(_launcher->requests, requests + 1);
+    QCOMPARE(output.trimmed(), QByteArray::number(requests + 1));
+    QCOMPARE(_launcher->profile, QString("Shell"));
+    QCOMPARE(_launcher->directory, QString("/tmp"));
+    QCOMPARE(_launcher->command, QStringList() << "top" << "-d" << "5");
+    QVERIFY(!_launcher->newWindow);
+}
+
+void LaunchTest::testNewWindow()
+{
+    QVERIFY(launch(QStringList() << "--new-window"));
+
+    QVERIFY(_launcher->newWindow);
+    QVERIFY(_launcher->profile.isEmpty());
+    QVERIFY(_launcher->directory.isEmpty());
+    QVERIFY(_launcher->command.isEmpty());
+}
+
+void LaunchTest::benchmarkLaunch()
+{
+    QStringList arguments;
+    arguments << "-e" << "true";
+
+    QBENCHMARK {
+        QVERIFY(launch(arguments));
+    }
+}
+
+QTEST_KDEMAIN_CORE(LaunchTest)
+
+#include "LaunchTest.moc"
+
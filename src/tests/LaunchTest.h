@@ -0,0 +1,79 @@
+/*
+    Copyright 2013 by Konsole Developers <konsole-devel@kde.org>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+    02110-1301  USA.
+*/
+
+#ifndef LAUNCHTEST_H
+#define LAUNCHTEST_H
+
+#include <QtCore/QObject>
+#include <QtCore/QStringList>
+
+namespace Konsole
+{
+
+/**
+ * Stands in for Application::openSession(), recording the requests sent
+ * by konsole-launch.
+ */
+class FakeLauncher : public QObject
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.kde.konsole.Launcher")
+
+public:
+    FakeLauncher() : requests(0), newWindow(false) {}
+
+    int requests;
+    QString profile;
+    QString directory;
+    QStringList command;
+    bool newWindow;
+
+public slots:
+    Q_SCRIPTABLE int openSession(const QString& profile, const QString& directory,
+                                 const QStringList& command, bool newWindow);
+};
+
+class LaunchTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void testOpenSession();
+    void testNewWindow();
+
+    // wall time of konsole-launch, from starting the process until it
+    // exits after Konsole has opened the session
+    void benchmarkLaunch();
+
+private:
+    // runs konsole-launch with arguments and stores its output in output,
+    // returns false if it did not finish successfully within 10 seconds
+    bool launch(const QStringList& arguments, QByteArray* output = 0);
+
+    FakeLauncher* _launcher;
+    QString _service;
+};
+
+}
+
+#endif // LAUNCHTEST_H
+
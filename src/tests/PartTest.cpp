@@ -21,6 +21,8 @@
 #include "PartTest.h"
 
 // Qt
+#include <QtCore/QDir>
+#include <QtCore/QTimer>
 #include <QWidget>
 #include <QLabel>
 #include <QVBoxLayout>
@@ -32,6 +34,7 @@
 #include <sys/types.h>
 
 // KDE
+#include <KActionCollection>
 #include <KMenu>
 #include <KMenuBar>
 #include <KPluginLoader>
@@ -42,12 +45,17 @@
 #include <KPtyDevice>
 #include <KDialog>
 #include <KMainWindow>
+#include <KXMLGUIBuilder>
+#include <KXMLGUIFactory>
 #include <qtest_kde.h>
 
 // Konsole
 #include "../Pty.h"
 #include "../Session.h"
 #include "../KeyboardTranslator.h"
+#include "../ScreenWindow.h"
+#include "../SessionController.h"
+#include "../TerminalDisplay.h"
 
 using namespace Konsole;
 
@@ -86,6 +94,86 @@ void PartTest::testFd()
     ptyProcess.kill();
     ptyProcess.waitForFinished(1000);
 }
+void PartTest::testStartupTime()
+{
+    // measures how long an embedding application waits for the part to
+    // be created, and then for the first paint which shows the prompt
+    _startupTimer.start();
+
+    KParts::Part* terminalPart = createPart();
+    QVERIFY(terminalPart);
+    const qint64 createTime = _startupTimer.elapsed();
+
+    TerminalInterface* terminal = qobject_cast<TerminalInterface*>(terminalPart);
+    QVERIFY(terminal);
+
+    TerminalDisplay* display = terminalPart->widget()->findChild<TerminalDisplay*>();
+    QVERIFY(display);
+    display->installEventFilter(this);
+
+    _firstPromptPaint = -1;
+    _promptEventLoop = new QEventLoop();
+
+    terminalPart->widget()->show();
+    terminal->showShellInDir(QDir::homePath());
+
+    QTimer::singleShot(10000, _promptEventLoop, SLOT(quit()));
+    _promptEventLoop->exec();
+
+    display->removeEventFilter(this);
+    delete _promptEventLoop;
+    _promptEventLoop = 0;
+
+    QVERIFY2(_firstPromptPaint >= 0, "No prompt was painted within 10 seconds");
+
+    qDebug() << "Part created in" << createTime << "ms,"
+             << "first prompt painted after" << _firstPromptPaint << "ms";
+
+    delete terminalPart;
+}
+void PartTest::testControllerPlugged()
+{
+    // the host merges the part into its GUI before the part has had a
+    // chance to plug its session controller
+    KParts::Part* terminalPart = createPart();
+    QVERIFY(terminalPart);
+
+    QWidget window;
+    KXMLGUIBuilder builder(&window);
+    KXMLGUIFactory factory(&builder);
+    factory.addClient(terminalPart);
+
+    QTest::qWait(0);
+
+    SessionController* controller = terminalPart->findChild<SessionController*>();
+    QVERIFY(controller);
+    QVERIFY(factory.clients().contains(controller));
+    QVERIFY(controller->actionCollection()->action("manage-profiles"));
+
+    factory.removeClient(terminalPart);
+    delete terminalPart;
+}
+bool PartTest::eventFilter(QObject* watched, QEvent* event)
+{
+    if (event->type() == QEvent::Paint && _firstPromptPaint < 0) {
+        TerminalDisplay* display = static_cast<TerminalDisplay*>(watched);
+        ScreenWindow* window = display->screenWindow();
+
+        if (window) {
+            const Character* image = window->getImage();
+            const int count = window->windowLines() * window->windowColumns();
+            for (int i = 0; i < count; i++) {
+                if (image[i].character != ' ' && image[i].character != 0) {
+                    _firstPromptPaint = _startupTimer.elapsed();
+                    _promptEventLoop->quit();
+                    break;
+                }
+            }
+        }
+    }
+
+    return QObject::eventFilter(watched, event);
+}
 void PartTest::testShortcutOverride()
 {
     // FIXME: This test asks the user to press shortcut key sequences manually because
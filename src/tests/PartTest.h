@@ -20,6 +20,7 @@
 #ifndef PARTTEST_H
 #define PARTTEST_H
 
+#include <QtCore/QElapsedTimer>
 #include <QtCore/QEventLoop>
 
 #include <kde_terminal_interface.h>
@@ -38,12 +39,17 @@ class PartTest : public QObject
 private slots:
     void testShortcutOverride();
     void testFd();
+    void testStartupTime();
+    void testControllerPlugged();
 
 // marked as protected so they are not treated as test cases
 protected slots:
     void overrideShortcut(QKeyEvent* event, bool& override);
     void shortcutTriggered();
 
+protected:
+    bool eventFilter(QObject* watched, QEvent* event);
+
 private:
     KParts::Part* createPart();
 
@@ -52,6 +58,11 @@ private:
     bool _overrideCalled;
     bool _override;
     QEventLoop* _shortcutEventLoop;
+
+    // variables for testStartupTime()
+    QEventLoop* _promptEventLoop;
+    QElapsedTimer _startupTimer;
+    qint64 _firstPromptPaint;
 };
 
 }
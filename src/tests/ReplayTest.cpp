@@ -0,0 +1,344 @@
+/*
+    Copyright 2013 by Konsole Developers <konsole-devel@kde.org>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+    02110-1301  USA.
+*/
+
+// Own
+#include "ReplayTest.h"
+
+// System
+#include <stdlib.h>
+
+// Qt
+#include <QtCore/QCoreApplication>
+#include <QtCore/QCryptographicHash>
+#include <QtCore/QDir>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QFile>
+#include <QtCore/QTextCodec>
+#include <QtCore/QTextStream>
+
+// KDE
+#include <qtest_kde.h>
+
+// Konsole
+#include "../ExtendedCharTable.h"
+#include "../Filter.h"
+#include "../History.h"
+#include "../Screen.h"
+#include "../ScreenWindow.h"
+#include "../Vt102Emulation.h"
+
+using namespace Konsole;
+
+// Allocations are counted by replacing the malloc family with wrappers
+// around glibc's own functions, which Qt's containers use as well as new.
+static QBasicAtomicInt allocationCount = Q_BASIC_ATOMIC_INITIALIZER(0);
+static volatile bool countAllocations = false;
+
+#if defined(__GLIBC__)
+extern "C" {
+    void* __libc_malloc(size_t size);
+    void* __libc_calloc(size_t count, size_t size);
+    void* __libc_realloc(void* pointer, size_t size);
+    void __libc_free(void* pointer);
+
+    void* malloc(size_t size)
+    {
+        if (countAllocations)
+            allocationCount.ref();
+        return __libc_malloc(size);
+    }
+
+    void* calloc(size_t count, size_t size)
+    {
+        if (countAllocations)
+            allocationCount.ref();
+        return __libc_calloc(count, size);
+    }
+
+    void* realloc(void* pointer, size_t size)
+    {
+        if (countAllocations)
+            allocationCount.ref();
+        return __libc_realloc(pointer, size);
+    }
+
+    void free(void* pointer)
+    {
+        __libc_free(pointer);
+    }
+}
+static const bool canCountAllocations = true;
+#else
+static const bool canCountAllocations = false;
+#endif
+
+// Size of the reads from the pty when output arrives quickly
+static const int CHUNK_SIZE = 4096;
+
+struct ReplayResult {
+    QByteArray checksum;
+    qint64 nanoseconds;
+    qint64 allocations;
+};
+
+// Returns a checksum of the text, formats and line properties of the
+// history and the screen, and of the cursor position
+static QByteArray screenChecksum(const Screen* screen)
+{
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+
+    const int lines = screen->getHistLines() + screen->getLines();
+    const int columns = screen->getColumns();
+    QVector<Character> image(columns);
+
+    for (int line = 0; line < lines; line++) {
+        screen->getImage(image.data(), columns, line, line);
+        const LineProperty properties = screen->getLineProperties(line, line).first();
+        hash.addData(reinterpret_cast<const char*>(&properties), sizeof(LineProperty));
+
+        foreach(const Character& c, image) {
+            // extended characters are hashed by their contents, the code
+            // depends on what else was added to the table before
+            if (c.rendition & RE_EXTENDED_CHAR) {
+                ushort length = 0;
+                const ushort* chars = ExtendedCharTable::instance.lookupExtendedChar(c.character, length);
+                hash.addData(reinterpret_cast<const char*>(chars), length * sizeof(ushort));
+            } else {
+                hash.addData(reinterpret_cast<const char*>(&c.character), sizeof(c.character));
+            }
+            hash.addData(reinterpret_cast<const char*>(&c.rendition), sizeof(c.rendition));
+            hash.addData(reinterpret_cast<const char*>(&c.foregroundColor), sizeof(CharacterColor));
+            hash.addData(reinterpret_cast<const char*>(&c.backgroundColor), sizeof(CharacterColor));
+            hash.addData(c.isRealCharacter ? "r" : "-", 1);
+        }
+    }
+
+    const int cursor[] = { screen->getCursorX(), screen->getCursorY() };
+    hash.addData(reinterpret_cast<const char*>(cursor), sizeof(cursor));
+
+    return hash.result().toHex();
+}
+
+// Feeds trace to a new emulation in chunks of chunkSize bytes, and after each
+// chunk does what the display does when it is updated: reads the visible
+// image and finds the hotspots in it
+static ReplayResult replay(const QByteArray& trace, int chunkSize)
+{
+    Vt102Emulation emulation;
+    emulation.setCodec(QTextCodec::codecForName("UTF-8"));
+    emulation.setHistory(CompactHistoryType(1000));
+    emulation.setImageSize(24, 80);
+    ScreenWindow* window = emulation.createWindow();
+
+    TerminalImageFilterChain filters;
+    filters.addFilter(new UrlFilter());
+
+    ReplayResult result;
+    allocationCount = 0;
+    countAllocations = true;
+
+    QElapsedTimer timer;
+    timer.start();
+
+    for (int pos = 0; pos < trace.size(); pos += chunkSize) {
+        emulation.receiveData(trace.constData() + pos, qMin(chunkSize, trace.size() - pos));
+
+        // the update timers can't fire without an event loop
+        QMetaObject::invokeMethod(&emulation, "showBulk");
+
+        filters.setImage(window->getImage(), window->windowLines(), window->windowColumns(),
+                         window->getLineProperties());
+        filters.process();
+    }
+
+    result.nanoseconds = timer.nsecsElapsed();
+    countAllocations = false;
+    result.allocations = canCountAllocations ? qint64(allocationCount) : -1;
+    result.checksum = screenChecksum(window->screen());
+
+    return result;
+}
+
+void ReplayTest::initTestCase()
+{
+    _tolerance = 25;
+    const QByteArray tolerance = qgetenv("KONSOLE_REPLAY_TOLERANCE");
+    if (!tolerance.isEmpty())
+        _tolerance = tolerance.toInt();
+
+    _record = !qgetenv("KONSOLE_REPLAY_RECORD").isEmpty();
+    _timing = !qgetenv("KONSOLE_REPLAY_TIMING").isEmpty();
+
+    // each line of the checksums holds the name of a trace and its
+    // checksum, each line of the baselines holds the name of a trace, the
+    // nanoseconds per byte and the number of allocations
+    foreach(const QList<QByteArray>& fields, readFields(KDESRCDIR "data/replay-checksums.txt", 2))
+        _checksums.insert(QString::fromLatin1(fields[0]), fields[1]);
+
+    foreach(const QList<QByteArray>& fields, readFields(baselinesFileName(), 3)) {
+        Baseline baseline;
+        baseline.nanosecondsPerByte = fields[1].toLongLong();
+        baseline.allocations = fields[2].toLongLong();
+        _baselines.insert(QString::fromLatin1(fields[0]), baseline);
+    }
+}
+
+void ReplayTest::cleanupTestCase()
+{
+    if (!_record)
+        return;
+
+    QStringList names = _baselines.keys();
+    names.sort();
+
+    QFile checksumsFile(QCoreApplication::applicationDirPath() + "/replay-checksums.txt");
+    QVERIFY(checksumsFile.open(QIODevice::WriteOnly | QIODevice::Text));
+
+    QTextStream checksums(&checksumsFile);
+    checksums << "# trace checksum\n";
+    foreach(const QString& name, names)
+        checksums << name << ' ' << _checksums[name] << '\n';
+
+    QFile baselinesFile(baselinesFileName());
+    QVERIFY(baselinesFile.open(QIODevice::WriteOnly | QIODevice::Text));
+
+    QTextStream baselines(&baselinesFile);
+    baselines << "# trace nanoseconds-per-byte allocations\n";
+    foreach(const QString& name, names) {
+        const Baseline& baseline = _baselines[name];
+        baselines << name << ' ' << baseline.nanosecondsPerByte << ' '
+                  << baseline.allocations << '\n';
+    }
+
+    qDebug() << "Recorded" << names.count() << "traces in" << QCoreApplication::applicationDirPath()
+             << "- copy replay-checksums.txt to" << KDESRCDIR "data/ to check it in";
+}
+
+QString ReplayTest::baselinesFileName()
+{
+    return QCoreApplication::applicationDirPath() + "/replay-baselines.txt";
+}
+
+QList<QList<QByteArray> > ReplayTest::readFields(const QString& fileName, int count)
+{
+    QList<QList<QByteArray> > lines;
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+        return lines;
+
+    while (!file.atEnd()) {
+        const QList<QByteArray> fields = file.readLine().simplified().split(' ');
+        if (fields.count() == count && !fields[0].startsWith('#'))
+            lines << fields;
+    }
+
+    return lines;
+}
+
+void ReplayTest::testReplay_data()
+{
+    QTest::addColumn<QByteArray>("trace");
+
+    const QDir traces(KDESRCDIR "data/replay");
+    foreach(const QFileInfo& info, traces.entryInfoList(QDir::Files, QDir::Name)) {
+        QFile file(info.filePath());
+        if (file.open(QIODevice::ReadOnly))
+            QTest::newRow(info.baseName().toLocal8Bit()) << file.readAll();
+    }
+
+    // the sample is plain text, so add the carriage returns which the pty
+    // would add to each new line
+    QFile sample(KDESRCDIR "../../tests/UTF-8-demo.txt");
+    if (sample.open(QIODevice::ReadOnly))
+        QTest::newRow("UTF-8-demo") << sample.readAll().replace('\n', "\r\n");
+}
+
+void ReplayTest::testReplay()
+{
+    QFETCH(QByteArray, trace);
+    QVERIFY(!trace.isEmpty());
+
+    const ReplayResult result = replay(trace, CHUNK_SIZE);
+
+    // escape sequences and UTF-8 characters which are split between chunks
+    // must give the same result
+    QCOMPARE(replay(trace, 61).checksum, result.checksum);
+
+    // take the best of three runs to reduce noise from the rest of the system
+    qint64 nanoseconds = result.nanoseconds;
+    for (int run = 0; run < 2; run++)
+        nanoseconds = qMin(nanoseconds, replay(trace, CHUNK_SIZE).nanoseconds);
+
+    const QString name = QString::fromLatin1(QTest::currentDataTag());
+    Baseline current;
+    current.nanosecondsPerByte = nanoseconds / trace.size();
+    current.allocations = result.allocations;
+
+    qDebug() << trace.size() << "bytes," << current.nanosecondsPerByte << "ns per byte,"
+             << current.allocations << "allocations";
+
+    if (_record) {
+        _checksums.insert(name, result.checksum);
+        _baselines.insert(name, current);
+        return;
+    }
+
+    if (_checksums.contains(name))
+        QCOMPARE(result.checksum, _checksums[name]);
+    else
+        QWARN("No checksum, set KONSOLE_REPLAY_RECORD to record one");
+
+    if (!_timing)
+        QSKIP("Timings are only checked when KONSOLE_REPLAY_TIMING is set", SkipSingle);
+
+    if (!_baselines.contains(name))
+        QSKIP("No timing baseline, set KONSOLE_REPLAY_RECORD to record one", SkipSingle);
+
+    const Baseline& baseline = _baselines[name];
+    const qint64 maximumTime = baseline.nanosecondsPerByte * (100 + _tolerance) / 100;
+    QVERIFY2(current.nanosecondsPerByte <= maximumTime,
+             qPrintable(QString("%1 ns per byte, baseline %2").arg(current.nanosecondsPerByte)
+                        .arg(baseline.nanosecondsPerByte)));
+
+    if (current.allocations >= 0 && baseline.allocations >= 0) {
+        const qint64 maximumAllocations = baseline.allocations * (100 + _tolerance) / 100;
+        QVERIFY2(current.allocations <= maximumAllocations,
+                 qPrintable(QString("%1 allocations, baseline %2").arg(current.allocations)
+                            .arg(baseline.allocations)));
+    }
+}
+
+void ReplayTest::benchmarkReplay_data()
+{
+    testReplay_data();
+}
+
+void ReplayTest::benchmarkReplay()
+{
+    QFETCH(QByteArray, trace);
+
+    QBENCHMARK {
+        replay(trace, CHUNK_SIZE);
+    }
+}
+
+QTEST_KDEMAIN(ReplayTest , GUI)
+
+#include "ReplayTest.moc"
@@ -0,0 +1,90 @@
+/*
+    Copyright 2013 by Konsole Developers <konsole-devel@kde.org>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+    02110-1301  USA.
+*/
+
+#ifndef REPLAYTEST_H
+#define REPLAYTEST_H
+
+#include <QtCore/QHash>
+#include <QtCore/QList>
+#include <QtCore/QObject>
+
+namespace Konsole
+{
+
+/**
+ * Replays recorded terminal output through the emulation, screen, history
+ * and filters to catch changes in their behavior and performance.
+ *
+ * The traces in data/replay were recorded with script(1) in an 80x24
+ * terminal: compiler errors, a colored recursive listing, a vim session and
+ * top refreshing, and the UTF-8 sample from tests/UTF-8-demo.txt is replayed
+ * as well.  Each trace is fed to a new emulation in pty-sized chunks, and the
+ * display update is repeated after each chunk.
+ *
+ * testReplay() checks that the final screen and history are the same
+ * whichever way the trace is split into chunks, and compares the checksum of
+ * them with data/replay-checksums.txt.  A trace without a checksum there
+ * only gives a warning.
+ *
+ * Timings depend on the machine, so they are only checked when
+ * KONSOLE_REPLAY_TIMING is set.  The time in nanoseconds per byte and the
+ * number of allocations are then compared with the baselines in
+ * replay-baselines.txt next to the test executable.  These may exceed their
+ * baselines by the percentage in KONSOLE_REPLAY_TOLERANCE, which defaults to
+ * 25.  Allocations are only counted with glibc.
+ *
+ * Setting KONSOLE_REPLAY_RECORD writes the results to replay-checksums.txt
+ * and replay-baselines.txt next to the test executable instead of comparing
+ * them.  Timings depend on the machine, so the baselines stay in the build
+ * directory.  Checksums do not, so after adding or changing a trace, or
+ * changing the emulation on purpose, copy replay-checksums.txt over
+ * src/tests/data/replay-checksums.txt.
+ */
+class ReplayTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void testReplay_data();
+    void testReplay();
+    void benchmarkReplay_data();
+    void benchmarkReplay();
+
+private:
+    struct Baseline {
+        qint64 nanosecondsPerByte;
+        qint64 allocations;
+    };
+
+    static QString baselinesFileName();
+    // returns the lines of fileName which have count fields, other than comments
+    static QList<QList<QByteArray> > readFields(const QString& fileName, int count);
+
+    QHash<QString, QByteArray> _checksums;
+    QHash<QString, Baseline> _baselines;
+    int _tolerance;
+    bool _record;
+    bool _timing;
+};
+
+}
+
+#endif // REPLAYTEST_H
@@ -0,0 +1,144 @@
+/*
+    Copyright 2013 by Konsole Developers <konsole-devel@kde.org>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+    02110-1301  USA.
+*/
+
+// Own
+#include "ScreenTest.h"
+
+// Qt
+#include <QtCore/QVector>
+
+// KDE
+#include <qtest_kde.h>
+
+// Konsole
+#include "../Screen.h"
+
+using namespace Konsole;
+
+// writes text at the start of line, counting from 0
+static void writeLine(Screen* screen, int line, const QString& text)
+{
+    screen->setCursorYX(line + 1, 1);
+    for (int i = 0; i < text.length(); i++)
+        screen->displayCharacter(text[i].unicode());
+}
+
+// fills the line of image starting at index with a character which the
+// screen never contains, to find out whether the line is copied again
+static void markLine(QVector<Character>& image, int line, int columns)
+{
+    for (int i = line * columns; i < (line + 1) * columns; i++)
+        image[i].character = '#';
+}
+
+static bool isMarked(const QVector<Character>& image, int line, int columns)
+{
+    return image[line * columns].character == '#';
+}
+
+void ScreenTest::testLineReferences()
+{
+    const int lines = 5;
+    const int columns = 20;
+    Screen screen(lines, columns);
+
+    for (int line = 0; line < lines; line++)
+        writeLine(&screen, line, QString("line %1").arg(line));
+
+    // the cursor is on the last line
+    QVector<Character> image(lines * columns);
+    QVector<LineReference> references(lines);
+    screen.getImage(image.data(), image.size(), 0, lines - 1, &references);
+
+    for (int line = 0; line < lines - 1; line++)
+        QVERIFY(references[line].valid);
+    QVERIFY(!references[lines - 1].valid);
+    QCOMPARE(image[columns].character, quint16('l'));
+
+    // unchanged lines are not copied again, the cursor's line is
+    for (int line = 0; line < lines; line++)
+        markLine(image, line, columns);
+    screen.getImage(image.data(), image.size(), 0, lines - 1, &references);
+    for (int line = 0; line < lines - 1; line++)
+        QVERIFY(isMarked(image, line, columns));
+    QVERIFY(!isMarked(image, lines - 1, columns));
+
+    // a changed line is copied again
+    writeLine(&screen, 1, "changed");
+    screen.setCursorYX(lines, 1);
+    screen.getImage(image.data(), image.size(), 0, lines - 1, &references);
+    QVERIFY(isMarked(image, 0, columns));
+    QCOMPARE(image[columns].character, quint16('c'));
+    QVERIFY(references[1].valid);
+
+    // so is a line with selected text, and the line once it is no longer selected
+    markLine(image, 1, columns);
+    screen.setSelectionStart(0, 2, false);
+    screen.setSelectionEnd(5, 2);
+    screen.getImage(image.data(), image.size(), 0, lines - 1, &references);
+    QVERIFY(isMarked(image, 0, columns));
+    QVERIFY(isMarked(image, 1, columns));
+    QVERIFY(!isMarked(image, 2, columns));
+    QVERIFY(!references[2].valid);
+
+    markLine(image, 2, columns);
+    screen.clearSelection();
+    screen.getImage(image.data(), image.size(), 0, lines - 1, &references);
+    QVERIFY(!isMarked(image, 2, columns));
+    QCOMPARE(image[2 * columns].character, quint16('l'));
+
+    // every line is copied without references
+    for (int line = 0; line < lines; line++)
+        markLine(image, line, columns);
+    screen.getImage(image.data(), image.size(), 0, lines - 1);
+    for (int line = 0; line < lines; line++)
+        QVERIFY(!isMarked(image, line, columns));
+}
+
+void ScreenTest::benchmarkUnchangedImage_data()
+{
+    QTest::addColumn<bool>("useReferences");
+
+    QTest::newRow("copy every line") << false;
+    QTest::newRow("compare references") << true;
+}
+
+void ScreenTest::benchmarkUnchangedImage()
+{
+    QFETCH(bool, useReferences);
+
+    const int lines = 60;
+    const int columns = 200;
+    Screen screen(lines, columns);
+
+    for (int line = 0; line < lines; line++)
+        writeLine(&screen, line, QString("output line %1 ").arg(line).repeated(10).left(columns));
+
+    QVector<Character> image(lines * columns);
+    QVector<LineReference> references(lines);
+
+    QBENCHMARK {
+        screen.getImage(image.data(), image.size(), 0, lines - 1,
+                        useReferences ? &references : 0);
+    }
+}
+
+QTEST_KDEMAIN_CORE(ScreenTest)
+
+#include "ScreenTest.moc"
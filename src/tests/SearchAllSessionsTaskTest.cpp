@@ -0,0 +1,288 @@
+/*
+    Copyright 2013 by Konsole Developers <konsole-devel@kde.org>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+    02110-1301  USA.
+*/
+
+// Own
+#include "SearchAllSessionsTaskTest.h"
+
+// Qt
+#include <QtCore/QEventLoop>
+#include <QtCore/QTimer>
+
+// KDE
+#include <qtest_kde.h>
+
+// Konsole
+#include "../Emulation.h"
+#include "../History.h"
+#include "../ScreenWindow.h"
+#include "../Session.h"
+
+using namespace Konsole;
+
+// Creates a session, without starting its shell, whose output is the
+// given text
+static Session* createSession(const QByteArray& output)
+{
+    Session* session = new Session();
+    session->setHistoryType(HistoryTypeBuffer(1000));
+    session->emulation()->receiveData(output.constData(), output.length());
+    return session;
+}
+
+QList<SearchAllSessionsTask::Match> SearchAllSessionsTaskTest::runSearch(SearchAllSessionsTask* task)
+{
+    _matches.clear();
+    connect(task, SIGNAL(matchesFound(QList<SearchAllSessionsTask::Match>)),
+            this, SLOT(matchesFound(QList<SearchAllSessionsTask::Match>)));
+
+    QEventLoop loop;
+    connect(task, SIGNAL(completed(bool)), &loop, SLOT(quit()));
+    QTimer::singleShot(10000, &loop, SLOT(quit()));
+    task->execute();
+    loop.exec();
+
+    return _matches;
+}
+
+void SearchAllSessionsTaskTest::matchesFound(const QList<SearchAllSessionsTask::Match>& matches)
+{
+    _matches << matches;
+}
+
+void SearchAllSessionsTaskTest::testMatchesInAllSessions()
+{
+    QByteArray firstOutput;
+    for (int i = 0; i < 500; i++)
+        firstOutput += "line " + QByteArray::number(i) + "\r\n";
+    firstOutput += "error: disk full\r\n";
+
+    Session* first = createSession(firstOutput);
+    Session* second = createSession("ok\r\nERROR: timeout\r\nok\r\n");
+    Session* third = createSession("nothing to see here\r\n");
+
+    SearchAllSessionsTask task;
+    task.setRegExp(QRegExp("error:", Qt::CaseInsensitive));
+    task.addSession(first);
+    task.addSession(second);
+    task.addSession(third);
+
+    QList<SearchAllSessionsTask::Match> matches = runSearch(&task);
+    QCOMPARE(matches.count(), 2);
+
+    foreach(const SearchAllSessionsTask::Match& match, matches) {
+        QVERIFY(match.session == first || match.session == second);
+        if (match.session == first) {
+            QCOMPARE(match.text.trimmed(), QString("error: disk full"));
+            QCOMPARE(match.line, first->emulation()->lineCount() - 1 - match.distance);
+        } else {
+            QCOMPARE(match.text.trimmed(), QString("ERROR: timeout"));
+            QCOMPARE(match.line, 1);
+        }
+    }
+
+    delete first;
+    delete second;
+    delete third;
+}
+
+void SearchAllSessionsTaskTest::testMaximumMatches()
+{
+    QByteArray output;
+    for (int i = 0; i < 5000; i++)
+        output += "match " + QByteArray::number(i) + "\r\n";
+
+    Session* session = createSession(output);
+
+    SearchAllSessionsTask task;
+    task.setRegExp(QRegExp("match"));
+    task.setMaximumMatches(100);
+    task.addSession(session);
+
+    QList<SearchAllSessionsTask::Match> matches = runSearch(&task);
+    QCOMPARE(matches.count(), 100);
+
+    delete session;
+}
+
+static QRegExp searchRegExp(const QString& text)
+{
+    return QRegExp(text, Qt::CaseInsensitive, QRegExp::FixedString);
+}
+
+// Searches the output of session for text, using and updating state
+static void searchHistory(Session* session, ScreenWindow* window, const QString& text,
+                          IncrementalSearchState* state)
+{
+    SearchHistoryTask task;
+    task.setRegExp(searchRegExp(text));
+    task.setIncrementalState(state);
+    task.addScreenWindow(session, window);
+    task.execute();
+}
+
+// Counts the lines of session's output which match text, as the search bar does
+QVector<int> SearchAllSessionsTaskTest::countLines(Session* session, const QString& text)
+{
+    SearchAllSessionsTask task;
+    task.setRegExp(searchRegExp(text));
+    task.addSession(session);
+
+    QVector<int> lines;
+    foreach(const SearchAllSessionsTask::Match& match, runSearch(&task)) {
+        lines << match.line;
+    }
+    qSort(lines);
+    return lines;
+}
+
+void SearchAllSessionsTaskTest::testIncrementalHistorySearch()
+{
+    QByteArray output;
+    for (int i = 0; i < 300; i++) {
+        switch (i % 4) {
+        case 0:
+            output += "connection refused by host " + QByteArray::number(i) + "\r\n";
+            break;
+        case 1:
+            output += "Connection reset\r\n";
+            break;
+        case 2:
+            output += "connected to " + QByteArray::number(i) + "\r\n";
+            break;
+        default:
+            output += "nothing " + QByteArray::number(i) + "\r\n";
+            break;
+        }
+    }
+
+    Session* session = createSession(output);
+    Emulation* emulation = session->emulation();
+    ScreenWindow* window = emulation->createWindow();
+
+    // the first search finds a match without reading all of the output
+    const QString text("connection refused");
+    IncrementalSearchState state;
+    searchHistory(session, window, text.left(1), &state);
+    QVERIFY(!state.valid);
+    QVERIFY(window->selectedText(false).contains("c", Qt::CaseInsensitive));
+
+    // once the matches have been counted, typing the rest of the text one
+    // character at a time finds the same lines as counting each part of it
+    state.valid = true;
+    state.regExp = searchRegExp(text.left(1));
+    state.outputGeneration = emulation->outputGeneration();
+    state.lineCount = emulation->lineCount();
+    state.lines = countLines(session, text.left(1));
+    for (int length = 2; length <= text.length(); length++) {
+        searchHistory(session, window, text.left(length), &state);
+
+        QVERIFY(state.valid);
+        QCOMPARE(state.lines, countLines(session, text.left(length)));
+    }
+    QCOMPARE(state.lines.count(), 75);
+    QVERIFY(window->selectedText(false).contains("connection refused"));
+
+    // new output makes the lines stale.  the next match is found in the
+    // output, leaving the lines to the next count
+    const QByteArray moreOutput("another connection refused\r\n");
+    emulation->receiveData(moreOutput.constData(), moreOutput.length());
+    searchHistory(session, window, text, &state);
+    QVERIFY(window->selectedText(false).contains("connection refused"));
+    QCOMPARE(state.lines.count(), 75);
+
+    // text which is not an extension of the previous text
+    searchHistory(session, window, "connection reset", &state);
+    QVERIFY(window->selectedText(false).contains("connection reset", Qt::CaseInsensitive));
+    QCOMPARE(state.regExp, searchRegExp(text));
+
+    // a count which found too many lines is not searched again when the
+    // text is extended
+    state = IncrementalSearchState();
+    state.tooManyLines = true;
+    state.regExp = searchRegExp("connect");
+    state.outputGeneration = emulation->outputGeneration();
+    state.lineCount = emulation->lineCount();
+    searchHistory(session, window, "connecte", &state);
+    QVERIFY(window->selectedText(false).contains("connected to"));
+    QVERIFY(!state.valid);
+    QVERIFY(state.tooManyLines);
+    QCOMPARE(state.regExp, searchRegExp("connect"));
+
+    delete session;
+}
+
+void SearchAllSessionsTaskTest::testSearchUsesCountedMatches()
+{
+    QByteArray output;
+    for (int i = 0; i < 300; i++) {
+        if (i % 10 == 0)
+            output += "error " + QByteArray::number(i) + "\r\n";
+        else
+            output += "line " + QByteArray::number(i) + "\r\n";
+    }
+
+    Session* session = createSession(output);
+    Emulation* emulation = session->emulation();
+    ScreenWindow* window = emulation->createWindow();
+
+    // count the lines matching a regular expression, as the search bar does
+    const QRegExp regExp("err[aeiou]r \\d+");
+    SearchAllSessionsTask countTask;
+    countTask.setRegExp(regExp);
+    countTask.addSession(session);
+
+    QVector<int> lines;
+    foreach(const SearchAllSessionsTask::Match& match, runSearch(&countTask)) {
+        lines << match.line;
+    }
+    qSort(lines);
+    QCOMPARE(lines.count(), 30);
+    QCOMPARE(lines.first(), 0);
+
+    // keep only one of the lines, so that a search which uses them can be
+    // told apart from one which reads the output
+    IncrementalSearchState state;
+    state.valid = true;
+    state.regExp = regExp;
+    state.outputGeneration = emulation->outputGeneration();
+    state.lineCount = emulation->lineCount();
+    state.lines << lines[5];
+
+    SearchHistoryTask task;
+    task.setRegExp(regExp);
+    task.setIncrementalState(&state);
+    task.addScreenWindow(session, window);
+    task.execute();
+    QVERIFY(window->selectedText(false).contains("error 50"));
+
+    // the counted lines are stale once more output arrives, so the next
+    // match after the selection is found in the output
+    const QByteArray moreOutput("more output\r\n");
+    emulation->receiveData(moreOutput.constData(), moreOutput.length());
+    task.execute();
+    QVERIFY(window->selectedText(false).contains("error 60"));
+    QCOMPARE(state.lines.count(), 1);
+
+    delete session;
+}
+
+QTEST_KDEMAIN(SearchAllSessionsTaskTest , GUI)
+
+#include "SearchAllSessionsTaskTest.moc"
+
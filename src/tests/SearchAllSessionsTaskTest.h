@@ -0,0 +1,56 @@
+/*
+    Copyright 2013 by Konsole Developers <konsole-devel@kde.org>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+    02110-1301  USA.
+*/
+
+#ifndef SEARCHALLSESSIONSTASKTEST_H
+#define SEARCHALLSESSIONSTASKTEST_H
+
+#include <QtCore/QObject>
+
+#include "../SessionController.h"
+
+namespace Konsole
+{
+
+class SearchAllSessionsTaskTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testMatchesInAllSessions();
+    void testMaximumMatches();
+    void testIncrementalHistorySearch();
+    void testSearchUsesCountedMatches();
+
+// marked as protected so they are not treated as test cases
+protected slots:
+    void matchesFound(const QList<SearchAllSessionsTask::Match>& matches);
+
+private:
+    // runs task until it completes and returns the matches it reported
+    QList<SearchAllSessionsTask::Match> runSearch(SearchAllSessionsTask* task);
+    // the lines of session's output which contain text, in ascending order
+    QVector<int> countLines(Session* session, const QString& text);
+
+    QList<SearchAllSessionsTask::Match> _matches;
+};
+
+}
+
+#endif // SEARCHALLSESSIONSTASKTEST_H
+
@@ -0,0 +1,104 @@
+/*
+    Copyright 2013 by Konsole Developers <konsole-devel@kde.org>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+    02110-1301  USA.
+*/
+
+// Own
+#include "SessionUsageTest.h"
+
+// Qt
+#include <QtCore/QElapsedTimer>
+
+// KDE
+#include <qtest_kde.h>
+
+// Konsole
+#include "../SessionUsage.h"
+
+using namespace Konsole;
+
+// Keeps the thread busy for the given number of milliseconds
+static void spin(int milliseconds)
+{
+    QElapsedTimer timer;
+    timer.start();
+    while (timer.elapsed() < milliseconds) {
+    }
+}
+
+void SessionUsageTest::testScope()
+{
+    SessionUsage usage;
+    QCOMPARE(usage.rates().cpuMilliseconds, 0.0);
+
+    {
+        SessionUsage::Scope scope(&usage);
+        spin(50);
+    }
+
+    // nearly all of the time since the usage was created was in the scope
+    QVERIFY(usage.rates().cpuMilliseconds > 500);
+
+    // a null usage records nothing
+    SessionUsage::Scope scope(0);
+}
+
+void SessionUsageTest::testNestedScopes()
+{
+    SessionUsage outer;
+    SessionUsage inner;
+
+    {
+        SessionUsage::Scope outerScope(&outer);
+        spin(20);
+        {
+            SessionUsage::Scope innerScope(&inner);
+            spin(20);
+        }
+    }
+
+    // the time in the inner scope belongs to the outer session
+    QVERIFY(outer.rates().cpuMilliseconds > 0);
+    QCOMPARE(inner.rates().cpuMilliseconds, 0.0);
+
+    {
+        SessionUsage::Scope innerScope(&inner);
+        spin(20);
+    }
+    QVERIFY(inner.rates().cpuMilliseconds > 0);
+}
+
+void SessionUsageTest::testCounts()
+{
+    SessionUsage usage;
+    spin(10);
+
+    usage.addReceivedBytes(4096);
+    usage.addFrame();
+    usage.addFrame();
+    usage.addSkippedHistoryLines(1024);
+
+    const SessionUsage::Rates rates = usage.rates();
+    QVERIFY(rates.bytes > 0);
+    QVERIFY(rates.frames > 0);
+    QCOMPARE(rates.bytes / rates.frames, 2048.0);
+    QCOMPARE(rates.skippedHistoryLines / rates.frames, 512.0);
+}
+
+QTEST_KDEMAIN_CORE(SessionUsageTest)
+
+#include "SessionUsageTest.moc"
@@ -27,8 +27,50 @@
 // KDE
 #include <qtest_kde.h>
 
+// Konsole
+#include "../ParallelLineDecoder.h"
+
 using namespace Konsole;
 
+// fills a block with lines of varying length and appearance, some of
+// which are wrapped onto the following line
+static void fillBlock(LineBlock* block, int lineCount)
+{
+    for (int line = 0; line < lineCount; line++) {
+        const QString text = QString("line %1 of the output").arg(line).repeated(line % 4);
+        const LineProperty properties = (line % 5 == 0) ? LINE_WRAPPED : LINE_DEFAULT;
+
+        Character* characters = block->appendLine(text.length(), properties);
+        for (int i = 0; i < text.length(); i++) {
+            characters[i] = Character(text[i].unicode());
+            characters[i].rendition = (i % 7 == 0) ? RE_BOLD : DEFAULT_RENDITION;
+            characters[i].foregroundColor = CharacterColor(COLOR_SPACE_SYSTEM, line % 8);
+        }
+    }
+}
+
+// decodes the lines of a block one after the other with a single decoder
+static QString decodeSequentially(TerminalCharacterDecoder* decoder, const LineBlock& block,
+                                  QList<int>* linePositions = 0)
+{
+    QString text;
+    QTextStream stream(&text);
+    decoder->begin(&stream);
+    for (int line = 0; line < block.lineCount(); line++) {
+        QVector<Character> characters;
+        for (int i = 0; i < block.lineLength(line); i++)
+            characters << block.characters(line)[i];
+        if (!(block.lineProperties(line) & LINE_WRAPPED))
+            characters << Character('\n');
+
+        if (linePositions)
+            *linePositions << text.length();
+        decoder->decodeLine(characters.constData(), characters.count(), block.lineProperties(line));
+    }
+    decoder->end();
+    return text;
+}
+
 void TerminalCharacterDecoderTest::init()
 {
 }
@@ -57,6 +99,68 @@ void TerminalCharacterDecoderTest::testPlainTextDecoder()
     delete decoder;
 }
 
+void TerminalCharacterDecoderTest::testParallelLineDecoder()
+{
+    LineBlock block;
+    fillBlock(&block, 1000);
+
+    PlainTextDecoder decoder;
+    QList<int> expectedPositions;
+    const QString expected = decodeSequentially(&decoder, block, &expectedPositions);
+
+    // chunks which don't divide the lines evenly, a single chunk, and
+    // one chunk per line
+    foreach(int chunkLines, QList<int>() << 7 << 5000 << 1) {
+        ParallelLineDecoder parallelDecoder(&decoder);
+        parallelDecoder.setChunkLines(chunkLines);
+
+        QCOMPARE(parallelDecoder.decode(block), expected);
+        QCOMPARE(parallelDecoder.linePositions().toList(), expectedPositions);
+    }
+
+    // an empty block
+    ParallelLineDecoder parallelDecoder(&decoder);
+    QCOMPARE(parallelDecoder.decode(LineBlock()), QString());
+    QVERIFY(parallelDecoder.linePositions().isEmpty());
+}
+
+void TerminalCharacterDecoderTest::testParallelLineDecoderHtml()
+{
+    LineBlock block;
+    fillBlock(&block, 300);
+
+    HTMLDecoder decoder;
+    const QString expected = decodeSequentially(&decoder, block);
+
+    // every line opens and closes its own spans, inside the monospace span
+    QCOMPARE(expected.count("<span"), expected.count("</span>"));
+    QVERIFY(expected.startsWith("<span style=\"font-family:monospace\">"));
+
+    ParallelLineDecoder parallelDecoder(&decoder);
+    parallelDecoder.setChunkLines(16);
+
+    QString text;
+    QTextStream stream(&text);
+    decoder.begin(&stream);
+    stream << parallelDecoder.decode(block);
+    decoder.end();
+
+    QCOMPARE(text, expected);
+}
+
+void TerminalCharacterDecoderTest::benchmarkParallelLineDecoder()
+{
+    LineBlock block;
+    fillBlock(&block, 100000);
+
+    PlainTextDecoder decoder;
+    ParallelLineDecoder parallelDecoder(&decoder);
+
+    QBENCHMARK {
+        parallelDecoder.decode(block);
+    }
+}
+
 QTEST_KDEMAIN_CORE(TerminalCharacterDecoderTest)
 
 #include "TerminalCharacterDecoderTest.moc"
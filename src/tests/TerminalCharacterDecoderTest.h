@@ -34,6 +34,9 @@ private slots:
     void cleanup();
 
     void testPlainTextDecoder();
+    void testParallelLineDecoder();
+    void testParallelLineDecoderHtml();
+    void benchmarkParallelLineDecoder();
 };
 
 }
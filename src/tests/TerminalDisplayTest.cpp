@@ -0,0 +1,181 @@
+/*
+    Copyright 2013 by Konsole Developers <konsole-devel@kde.org>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+    02110-1301  USA.
+*/
+
+// Own
+#include "TerminalDisplayTest.h"
+
+// Qt
+#include <QtCore/QTextCodec>
+#include <QtCore/QThread>
+#include <QtGui/QImage>
+
+// KDE
+#include <KGlobalSettings>
+#include <qtest_kde.h>
+
+// Konsole
+#include "../ScreenWindow.h"
+#include "../TerminalDisplay.h"
+#include "../Vt102Emulation.h"
+
+using namespace Konsole;
+
+static const int COLUMNS = 400;
+static const int LINES = 120;
+
+void TerminalDisplayTest::initTestCase()
+{
+    QFont font = KGlobalSettings::fixedFont();
+    font.setPointSize(7);
+
+    _display = new TerminalDisplay();
+    _display->setVTFont(font);
+    _display->setFixedSize(COLUMNS, LINES);
+
+    _emulation = new Vt102Emulation();
+    _emulation->setImageSize(LINES, COLUMNS);
+    _display->setScreenWindow(_emulation->createWindow());
+
+    // fill the screen with text in runs of different colors and styles,
+    // so that each line is drawn as many separate fragments
+    QByteArray text;
+    for (int line = 0; line < LINES; line++) {
+        for (int run = 0; run < COLUMNS / 10; run++) {
+            text += "\033[" + QByteArray::number((line + run) % 3) + ';'
+                    + QByteArray::number(30 + (line + run) % 8) + ';'
+                    + QByteArray::number(40 + (line * run) % 8) + 'm';
+            for (int column = 0; column < 10; column++)
+                text += 'A' + (line * 7 + run * 3 + column) % 58;
+        }
+        if (line < LINES - 1)
+            text += "\r\n";
+    }
+    _emulation->receiveData(text.constData(), text.size());
+    _display->screenWindow()->notifyOutputChanged();
+}
+
+void TerminalDisplayTest::cleanupTestCase()
+{
+    // the emulation deletes its screen window, which the display uses
+    delete _display;
+    delete _emulation;
+}
+
+QImage TerminalDisplayTest::render() const
+{
+    QImage image(_display->size(), QImage::Format_RGB32);
+    _display->render(&image);
+    return image;
+}
+
+void TerminalDisplayTest::testParallelRendering()
+{
+    const int threads = TerminalDisplay::renderThreadCount();
+    TerminalDisplay::setRenderThreadCount(4);
+
+    _display->setParallelRendering(false);
+    const QImage serial = render();
+    _display->setParallelRendering(true);
+    const QImage parallel = render();
+
+    TerminalDisplay::setRenderThreadCount(threads);
+
+    QVERIFY(serial == parallel);
+}
+
+void TerminalDisplayTest::testLineDrawing()
+{
+    QFont font = KGlobalSettings::fixedFont();
+    font.setPointSize(7);
+
+    Vt102Emulation emulation;
+    emulation.setCodec(QTextCodec::codecForName("UTF-8"));
+    emulation.setImageSize(12, 60);
+
+    TerminalDisplay display;
+    display.setVTFont(font);
+    display.setFixedSize(400, 120);
+    display.setScreenWindow(emulation.createWindow());
+
+    // bold and normal box drawing characters of the same color next to
+    // each other, text whose glyphs may overhang into the next fragment,
+    // and the cursor in the middle of such a line
+    const QByteArray line = "\033[1;32m─┼─\033[0;32m─┼─"
+                            "\033[1m│═\033[0;32m│═ "
+                            "\033[1;3;33mfjW\033[0;44mfjW\033[0;1m╔╗\033[0m╔╗ "
+                            "\033[7m─x─\033[0m\r\n";
+    QByteArray text;
+    for (int i = 0; i < 8; i++)
+        text += line;
+    text += "\033[4;6H";
+    emulation.receiveData(text.constData(), text.size());
+    display.screenWindow()->notifyOutputChanged();
+    display.setParallelRendering(false);
+
+    QImage fragments(display.size(), QImage::Format_RGB32);
+    display.setLineDrawingEnabled(false);
+    display.render(&fragments);
+
+    QImage lines(display.size(), QImage::Format_RGB32);
+    display.setLineDrawingEnabled(true);
+    display.render(&lines);
+
+    QVERIFY(fragments == lines);
+}
+
+void TerminalDisplayTest::benchmarkFullRedraw_data()
+{
+    QTest::addColumn<int>("threads");
+
+    const int cores = QThread::idealThreadCount();
+    for (int threads = 1; threads < cores; threads *= 2)
+        QTest::newRow(QByteArray::number(threads) + " threads") << threads;
+    QTest::newRow(QByteArray::number(cores) + " threads") << cores;
+}
+
+void TerminalDisplayTest::benchmarkFullRedraw()
+{
+    QFETCH(int, threads);
+
+    const int previousThreads = TerminalDisplay::renderThreadCount();
+    TerminalDisplay::setRenderThreadCount(threads);
+    _display->setParallelRendering(true);
+
+    QImage image(_display->size(), QImage::Format_RGB32);
+    QBENCHMARK {
+        _display->render(&image);
+    }
+
+    TerminalDisplay::setRenderThreadCount(previousThreads);
+}
+
+void TerminalDisplayTest::benchmarkSerialRedraw()
+{
+    _display->setParallelRendering(false);
+
+    QImage image(_display->size(), QImage::Format_RGB32);
+    QBENCHMARK {
+        _display->render(&image);
+    }
+}
+
+QTEST_KDEMAIN(TerminalDisplayTest , GUI)
+
+#include "TerminalDisplayTest.moc"
+
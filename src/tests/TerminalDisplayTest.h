@@ -0,0 +1,61 @@
+/*
+    Copyright 2013 by Konsole Developers <konsole-devel@kde.org>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+    02110-1301  USA.
+*/
+
+#ifndef TERMINALDISPLAYTEST_H
+#define TERMINALDISPLAYTEST_H
+
+#include <QtCore/QObject>
+#include <QtGui/QImage>
+
+namespace Konsole
+{
+
+class TerminalDisplay;
+class Vt102Emulation;
+
+class TerminalDisplayTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void testParallelRendering();
+    void testLineDrawing();
+
+    // redraws a display of 400x120 characters, with the number
+    // of render threads going up to the number of processor cores
+    void benchmarkFullRedraw_data();
+    void benchmarkFullRedraw();
+    // redraws the display on the GUI thread alone, each line has runs
+    // of many background colors and text styles
+    void benchmarkSerialRedraw();
+
+private:
+    QImage render() const;
+
+    Vt102Emulation* _emulation;
+    TerminalDisplay* _display;
+};
+
+}
+
+#endif // TERMINALDISPLAYTEST_H
+
@@ -0,0 +1,129 @@
+/*
+    Copyright 2013 by Konsole Developers <konsole-devel@kde.org>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+    02110-1301  USA.
+*/
+
+// Own
+#include "ViewManagerTest.h"
+
+// Qt
+#include <QtCore/QFile>
+#include <QtCore/QTime>
+
+// System
+#include <unistd.h>
+
+// KDE
+#include <KActionCollection>
+#include <qtest_kde.h>
+
+// Konsole
+#include "../ProfileManager.h"
+#include "../Session.h"
+#include "../SessionManager.h"
+#include "../ViewManager.h"
+
+using namespace Konsole;
+
+// Returns the resident set size of this process in bytes, or 0 if it
+// can not be determined
+static qint64 residentMemory()
+{
+    QFile statm("/proc/self/statm");
+    if (!statm.open(QIODevice::ReadOnly))
+        return 0;
+
+    const QList<QByteArray> fields = statm.readAll().split(' ');
+    if (fields.count() < 2)
+        return 0;
+
+    return fields[1].toLongLong() * sysconf(_SC_PAGESIZE);
+}
+
+void ViewManagerTest::testCreateAndDestroySessions_data()
+{
+    QTest::addColumn<int>("count");
+
+    QTest::newRow("10 sessions") << 10;
+    QTest::newRow("100 sessions") << 100;
+    QTest::newRow("500 sessions") << 500;
+}
+
+// Creates and destroys a number of sessions, with one tab each, without
+// starting their shells, and reports the time and memory used per session
+void ViewManagerTest::testCreateAndDestroySessions()
+{
+    QFETCH(int, count);
+
+    KActionCollection collection(this);
+    ViewManager* manager = new ViewManager(this, &collection);
+    Profile::Ptr profile = ProfileManager::instance()->defaultProfile();
+    const int initialSessionCount = SessionManager::instance()->sessions().count();
+
+    const qint64 memoryBefore = residentMemory();
+    QTime timer;
+    timer.start();
+
+    QList<Session*> sessions;
+    for (int i = 0; i < count; i++) {
+        Session* session = SessionManager::instance()->createSession(profile);
+        manager->createView(session);
+        sessions << session;
+    }
+
+    const int createTime = timer.restart();
+    const qint64 memoryAfter = residentMemory();
+
+    QCOMPARE(manager->sessionCount(), count);
+
+    // switching to each tab activates its controller for the first time
+    for (int i = 0; i < count; i++) {
+        manager->switchToView(i);
+        QCOMPARE(manager->currentSession(), sessions[i]->sessionId());
+    }
+
+    const int switchTime = timer.restart();
+
+    foreach(Session* session, sessions) {
+        session->close();
+    }
+    QTime deadline;
+    deadline.start();
+    while (SessionManager::instance()->sessions().count() > initialSessionCount
+            && deadline.elapsed() < 30000)
+        QTest::qWait(10);
+
+    const int destroyTime = timer.elapsed();
+
+    QCOMPARE(SessionManager::instance()->sessions().count(), initialSessionCount);
+
+    QCOMPARE(manager->sessionCount(), 0);
+
+    qDebug() << count << "sessions:"
+             << "create" << double(createTime) / count << "ms/session,"
+             << "switch" << double(switchTime) / count << "ms/session,"
+             << "destroy" << double(destroyTime) / count << "ms/session,"
+             << (memoryAfter - memoryBefore) / count / 1024 << "KiB/session";
+
+    delete manager->widget();
+    delete manager;
+}
+
+QTEST_KDEMAIN(ViewManagerTest , GUI)
+
+#include "ViewManagerTest.moc"
+